@@ -0,0 +1,251 @@
+// Cycle benchmarks for the hot paths of the clock firmware.
+//
+// Built by env:bench in place of main.cpp. Each case runs with interrupts
+// off while Timer1 counts CPU cycles (prescaler 1), so the numbers are the
+// same under simavr and on a real Nano. Results go out over serial as
+//
+//   BENCH <name> <iterations> <min> <max> <mean>
+//
+// followed by BENCH_END, after which the CPU sleeps with interrupts off
+// (simavr exits on that). bench/simavr_bench.py turns this into JSON.
+
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include "Clock.h"
+#include "Display.h"
+#include "Epoch.h"
+#include "Format.h"
+#include "Button.h"
+#include "Buzzer.h"
+#include "HTSensor.h"
+#include "RTClock.h"
+#include "Scheduler.h"
+#include "SerialCommandHandler.h"
+#include "TimeZone.h"
+#include "Timebase.h"
+
+#define BENCH_ITERATIONS 32
+
+// Same pins as main.cpp; nothing is attached under simavr
+Scheduler scheduler;
+Clock clock;
+Display display;
+RTClock rtc;
+Buzzer buzzer(9);
+HTSensor dht11(A0);
+Button button(A1);
+SerialCommandHandler serialHandler;
+TimeZone zone;
+
+static uint16_t overhead = 0;
+
+struct BenchResult
+{
+  uint16_t min;
+  uint16_t max;
+  uint32_t total;
+};
+
+typedef void (*BenchCase)(uint8_t iteration);
+
+// Cycles for one call; anything past 65535 cycles reads as 0xFFFF
+static uint16_t measure(BenchCase fn, uint8_t iteration)
+{
+  uint8_t sreg = SREG;
+  cli();
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TCNT1 = 0;
+  TIFR1 = _BV(TOV1);
+  TCCR1B = _BV(CS10);
+  fn(iteration);
+  TCCR1B = 0;
+  uint16_t cycles = TCNT1;
+  bool overflow = TIFR1 & _BV(TOV1);
+  SREG = sreg;
+
+  if (overflow)
+  {
+    return 0xFFFF;
+  }
+  return cycles > overhead ? cycles - overhead : 0;
+}
+
+static void run(const __FlashStringHelper *name, BenchCase fn)
+{
+  BenchResult result = {0xFFFF, 0, 0};
+
+  // One call first, not counted: a command that saves settings writes the
+  // EEPROM (3.3 ms a byte) only the first time, as put() skips equal bytes
+  fn(0);
+
+  for (uint8_t i = 0; i < BENCH_ITERATIONS; i++)
+  {
+    Serial.flush(); // Output from the previous call must not be counted
+    uint16_t cycles = measure(fn, i);
+    result.min = min(result.min, cycles);
+    result.max = max(result.max, cycles);
+    result.total += cycles;
+  }
+
+  Serial.print(F("BENCH "));
+  Serial.print(name);
+  Serial.print(' ');
+  Serial.print(BENCH_ITERATIONS);
+  Serial.print(' ');
+  Serial.print(result.min);
+  Serial.print(' ');
+  Serial.print(result.max);
+  Serial.print(' ');
+  Serial.println(result.total / BENCH_ITERATIONS);
+}
+
+// Cases
+
+static void benchEmpty(uint8_t)
+{
+}
+
+static void benchRefreshDigit(uint8_t)
+{
+  display.refreshNextDigit();
+}
+
+static const char PATTERN_CHARS[] = "0123456789AbCdEFHLnoPrSUYz *";
+
+static void benchPatternForChar(uint8_t iteration)
+{
+  volatile uint8_t pattern = Display::getPatternForChar(PATTERN_CHARS[iteration % (sizeof(PATTERN_CHARS) - 1)]);
+  (void)pattern;
+}
+
+static void benchTimeString(uint8_t)
+{
+  char text[DISPLAY_CHARS];
+  volatile char first = clock.getTimeString(text)[0];
+  (void)first;
+}
+
+// Formatting alone, into a sink that drops the text
+struct NullSink : public Print
+{
+  size_t write(uint8_t) override
+  {
+    return 1;
+  }
+};
+
+static NullSink sink;
+
+static void benchPrintDateTime(uint8_t iteration)
+{
+  Format::printDate(sink, iteration % 28 + 1, iteration % 12 + 1, 2000 + iteration * 3);
+  Format::printTime(sink, iteration % 24, iteration, 59 - iteration);
+}
+
+// One instant per day across the DS1307's range
+static EpochTime benchInstant(uint8_t iteration)
+{
+  return 946684800UL + iteration * (36525UL / BENCH_ITERATIONS) * Epoch::SECONDS_PER_DAY + iteration * 2711UL;
+}
+
+static void benchEpochToDate(uint8_t iteration)
+{
+  volatile uint8_t day = Epoch::toDate(benchInstant(iteration)).day;
+  (void)day;
+}
+
+static void benchEpochFromFields(uint8_t iteration)
+{
+  Date date = {(uint8_t)(iteration % 28 + 1), (uint8_t)(iteration % 12 + 1), (uint16_t)(2000 + iteration * 3)};
+  volatile EpochTime time = Epoch::fromFields(date, {12, 34, 56});
+  (void)time;
+}
+
+// Consecutive seconds inside one DST period, as the clock converts them
+static void benchTimeZoneToLocal(uint8_t iteration)
+{
+  volatile EpochTime local = zone.toLocal(1719792000UL + iteration); // 2024-07-01
+  (void)local;
+}
+
+// With a correction set; millis() stands still with interrupts off, so
+// this is the call within one millisecond, as the loop mostly makes it
+static void benchTimebaseMillis(uint8_t)
+{
+  volatile uint32_t now = Timebase::millis();
+  (void)now;
+}
+
+static void benchButtonUpdate(uint8_t)
+{
+  button.update();
+}
+
+static void benchParseAlarmSet(uint8_t)
+{
+  serialHandler.execute("alarm 1 set 0700");
+}
+
+static void benchParseTimerSet(uint8_t)
+{
+  serialHandler.execute("timer set 000530");
+}
+
+static void benchParseUnknown(uint8_t)
+{
+  serialHandler.execute("bogus");
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  // Objects are wired up but no hardware is started: the RTC, sensor and
+  // buzzer would wait for devices that are not there
+  display.begin(3, 4, 5, 6, 8, 7);
+  display.setEnabled(false); // refreshNextDigit() is called directly
+  display.print("123456");
+  button.begin();
+  clock.begin(&rtc, &dht11, &buzzer, &scheduler);
+  serialHandler.begin(&clock, &scheduler);
+  zone.select(2); // Berlin, with DST
+  zone.toLocal(1719792000UL);
+  Timebase::setCorrection(3000);
+  Serial.flush();
+
+  overhead = 0;
+  overhead = measure(benchEmpty, 0);
+
+  Serial.println(F("BENCH_BEGIN"));
+  Serial.print(F("BENCH_INFO f_cpu "));
+  Serial.print(F_CPU);
+  Serial.print(F(" overhead "));
+  Serial.println(overhead);
+
+  run(F("display_refresh_digit"), benchRefreshDigit);
+  run(F("pattern_for_char"), benchPatternForChar);
+  run(F("clock_time_string"), benchTimeString);
+  run(F("format_date_time"), benchPrintDateTime);
+  run(F("epoch_to_date"), benchEpochToDate);
+  run(F("epoch_from_fields"), benchEpochFromFields);
+  run(F("timezone_to_local"), benchTimeZoneToLocal);
+  run(F("timebase_millis"), benchTimebaseMillis);
+  run(F("button_update"), benchButtonUpdate);
+  run(F("serial_alarm_set"), benchParseAlarmSet);
+  run(F("serial_timer_set"), benchParseTimerSet);
+  run(F("serial_unknown"), benchParseUnknown);
+
+  Serial.println(F("BENCH_END"));
+  Serial.flush();
+
+  // Stop; simavr ends the run on sleep with interrupts disabled
+  cli();
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  sleep_cpu();
+}
+
+void loop()
+{
+}
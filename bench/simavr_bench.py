@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Run the cycle benchmarks under simavr and write a JSON report.
+
+    pio run -e bench
+    python3 bench/simavr_bench.py -o bench-report.json
+
+The benchmark firmware (bench/firmware/bench_main.cpp) prints
+"BENCH <name> <iterations> <min> <max> <mean>" lines over serial. This
+script runs it in simavr, or reads a serial log captured from a real
+board with --log, and converts the lines to JSON. Pass --baseline with an
+earlier report to get the per-case change in the report and on stdout.
+"""
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+
+ANSI = re.compile(r"\x1b\[[0-9;]*m")
+BENCH = re.compile(r"BENCH (\w+) (\d+) (\d+) (\d+) (\d+)")
+INFO = re.compile(r"BENCH_INFO f_cpu (\d+) overhead (\d+)")
+
+
+def run_simavr(simavr, elf, mcu, f_cpu, timeout):
+    cmd = [simavr, "-m", mcu, "-f", str(f_cpu), elf]
+    try:
+        result = subprocess.run(cmd, capture_output=True, text=True, timeout=timeout)
+    except subprocess.TimeoutExpired as e:
+        # Output up to the timeout is still useful if BENCH_END was printed
+        out = e.stdout or ""
+        return out.decode(errors="replace") if isinstance(out, bytes) else out
+    return result.stdout + result.stderr
+
+
+def parse(text, mcu):
+    report = {"mcu": mcu, "f_cpu": None, "overhead_cycles": None, "complete": False, "results": {}}
+    for line in text.splitlines():
+        line = ANSI.sub("", line)
+        info = INFO.search(line)
+        if info:
+            report["f_cpu"] = int(info.group(1))
+            report["overhead_cycles"] = int(info.group(2))
+            continue
+        if "BENCH_END" in line:
+            report["complete"] = True
+            continue
+        bench = BENCH.search(line)
+        if bench:
+            name, iterations, low, high, mean = bench.groups()
+            entry = {
+                "iterations": int(iterations),
+                "min_cycles": int(low),
+                "max_cycles": int(high),
+                "mean_cycles": int(mean),
+            }
+            if report["f_cpu"]:
+                entry["mean_us"] = round(int(mean) * 1e6 / report["f_cpu"], 2)
+            report["results"][name] = entry
+    return report
+
+
+def compare(report, baseline):
+    for name, entry in report["results"].items():
+        old = baseline.get("results", {}).get(name)
+        if old and old["mean_cycles"]:
+            entry["baseline_mean_cycles"] = old["mean_cycles"]
+            entry["change_pct"] = round(100.0 * (entry["mean_cycles"] - old["mean_cycles"]) / old["mean_cycles"], 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--elf", default=".pio/build/bench/firmware.elf")
+    parser.add_argument("--simavr", default="simavr")
+    parser.add_argument("--mcu", default="atmega328p")
+    parser.add_argument("--f-cpu", type=int, default=16000000)
+    parser.add_argument("--timeout", type=float, default=60)
+    parser.add_argument("--log", help="parse a captured serial log instead of running simavr")
+    parser.add_argument("--baseline", help="earlier JSON report to compare against")
+    parser.add_argument("-o", "--output", help="write the JSON report here (default stdout)")
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log) as f:
+            text = f.read()
+    else:
+        text = run_simavr(args.simavr, args.elf, args.mcu, args.f_cpu, args.timeout)
+
+    report = parse(text, args.mcu)
+    if not report["results"]:
+        sys.stderr.write("no BENCH lines found\n")
+        return 1
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            compare(report, json.load(f))
+
+    out = json.dumps(report, indent=2, sort_keys=True)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(out + "\n")
+        for name, entry in sorted(report["results"].items()):
+            change = entry.get("change_pct")
+            print("%-24s %7d cycles%s" % (name, entry["mean_cycles"],
+                                          "" if change is None else " (%+.1f%%)" % change))
+    else:
+        print(out)
+    return 0 if report["complete"] else 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,118 @@
+#ifndef ACTIVITY_LOG_H
+#define ACTIVITY_LOG_H
+
+#include <Arduino.h>
+#include "Epoch.h"
+#include "Events.h"
+
+class Clock;
+
+// Records in the EEPROM ring
+#define LOG_RECORDS 96
+// A time anchor at least this often, so a wrapped ring still has one
+#define LOG_ANCHOR_EVERY 24
+// Rate limit: a burst of this many records, then one per LOG_REFILL s
+#define LOG_BURST 8
+#define LOG_REFILL 60
+
+enum LogType
+{
+  LOG_EMPTY = 0,
+  LOG_TIME,            // Anchor: delta and data hold (UTC - 2000) / 256
+  LOG_POWER_UP,        // data: Watchdog::getResetReport()
+  LOG_ALARM_FIRED,     // data: index | round << 4
+  LOG_ALARM_DISMISSED, // data: index | round << 4
+  LOG_TIMER_DONE,      // data: minutes, up to 255
+  LOG_SETTINGS,        // data: SettingsItem bits
+  LOG_SENSOR_FAULT,    // data: SensorFaultCode
+  LOG_DROPPED,         // data: records the rate limit dropped, up to 255
+  LOG_MEMORY_LOW,      // data: headroom in bytes, up to 255
+  LOG_TYPE_COUNT
+};
+
+// One record as stored. The type is written last, so a write cut short by
+// a power loss leaves the old record's lap bit and reads as the old lap.
+struct LogRecord
+{
+  uint16_t delta; // s after the previous record
+  uint8_t data;
+  uint8_t type; // LogType, bit 7 the lap
+};
+
+// A record as read back
+struct LogEntry
+{
+  EpochTime time; // UTC; 0 before the first anchor of a wrapped ring
+  uint8_t type;
+  uint8_t data;
+};
+
+// Position while streaming the log, oldest record first
+struct LogCursor
+{
+  uint8_t index;
+  uint8_t left;
+  EpochTime time;
+};
+
+// What happened and when, kept across power cycles for "the alarm didn't
+// ring" reports.
+//
+// Events go into a ring of 4-byte records in EEPROM: the seconds since the
+// previous record, a type and a data byte. An anchor record with the
+// absolute time goes first after power-up, a jump of the clock or a gap of
+// over 18 hours, and every LOG_ANCHOR_EVERY records. There is no head
+// pointer to wear out one cell: each lap of the ring flips bit 7 of the
+// type, and begin() finds the head where it changes. The ring spreads the
+// writes over all its cells, and the rate limit caps them at one a minute
+// once a burst is spent, so a stuck event cannot wear the EEPROM out.
+class ActivityLog
+{
+private:
+  Clock *clock;
+  uint8_t head; // Next slot to write
+  uint8_t lap;  // 0x80 or 0 for the records of this lap
+  bool full;    // The ring has wrapped at least once
+  EpochTime lastTime; // Time the next delta counts from
+  bool anchored;
+  uint8_t sinceAnchor;
+  uint8_t tokens;
+  EpochTime lastRefill;
+  uint8_t dropped; // Since the last LOG_DROPPED record
+  uint16_t droppedTotal;
+
+  bool admit(EpochTime now);
+  void append(uint8_t type, uint8_t data);
+  void appendAt(EpochTime now, uint8_t type, uint8_t data);
+  void write(uint16_t delta, uint8_t type, uint8_t data);
+  void anchor(EpochTime now);
+  void scan();
+  static bool isRecord(const LogRecord &record);
+
+public:
+  ActivityLog();
+
+  // Finds the head of the ring and records the power-up with why the
+  // board started
+  void begin(Clock *clock, uint8_t resetReport = 0);
+
+  // Subscribe to the events to record
+  void record(const AlarmFired &event);
+  void record(const AlarmDismissed &event);
+  void record(const TimerCompleted &event);
+  void record(const SettingsChanged &event);
+  void record(const SensorFault &event);
+  void record(const MemoryLow &event);
+
+  // Streaming, one EEPROM record at a time: rewind, then next() until false
+  void rewind(LogCursor &cursor) const;
+  bool next(LogCursor &cursor, LogEntry &entry) const;
+
+  uint8_t getCount() const;
+  uint16_t getDropped() const; // Since power-on
+  void clear();
+
+  static const __FlashStringHelper *getTypeName(uint8_t type);
+};
+
+#endif // ACTIVITY_LOG_H
@@ -2,27 +2,43 @@
 #define ALARM_H
 
 #include <Arduino.h>
-#include "RTClock.h"
+#include "AlarmScheduler.h"
 
 // Forward declaration
 class Buzzer;
 
-struct AlarmData
+// Ringing state machine:
+//   ARMED -> RINGING (alarm fires)
+//   RINGING -> SNOOZED (snooze button, or unattended for RING_TIMEOUT)
+//   SNOOZED -> RINGING (snooze interval elapsed, escalated pattern)
+//   RINGING/SNOOZED -> ARMED (dismissed, or snooze limit reached)
+enum AlarmState
 {
-  uint8_t hour;
-  uint8_t minute;
-  bool enabled;
+  ALARM_ARMED,
+  ALARM_RINGING,
+  ALARM_SNOOZED
+};
+
+struct SnoozeConfig
+{
+  uint8_t minutes; // Snooze interval
+  uint8_t limit;   // Snoozes before the alarm is dismissed
 };
 
 class Alarm
 {
 private:
-  AlarmData data;
-  bool triggered;
-  unsigned long triggerStartTime;
-  uint16_t ALARM_DURATION = 10000; // 10 seconds
+  AlarmScheduler scheduler;
+  AlarmState state;
+  int8_t activeAlarm;
+  unsigned long stateStartTime;
+  uint8_t snoozeCount;
+  SnoozeConfig snoozeConfig;
+  static const unsigned long RING_TIMEOUT = 60000; // Auto-snooze after 1 minute
   Buzzer *buzzer;
 
+  void startRinging();
+
 public:
   Alarm();
 
@@ -30,27 +46,42 @@ public:
   void begin(Buzzer *buzzer = nullptr);
 
   // Alarm control
-  void enable();
-  void disable();
-  void stop();
+  void enable(uint8_t index);
+  void disable(uint8_t index);
+  void snooze();
+  void dismiss();
+  void clockAdjusted();
+
+  // Snooze configuration
+  void setSnooze(const SnoozeConfig &config);
+  SnoozeConfig getSnooze() const;
 
   // Alarm setting
-  void setTime(uint8_t hour, uint8_t minute);
-  void adjustHour();
-  void adjustMinute();
+  void setTime(uint8_t index, uint8_t hour, uint8_t minute);
+  void setDays(uint8_t index, uint8_t days);
+  void setData(uint8_t index, const AlarmData &data);
 
   // Status queries
-  bool isEnabled() const;
+  bool isEnabled(uint8_t index) const;
   bool isTriggered() const;
-  bool shouldTrigger(const Time &currentTime) const;
+  AlarmState getState() const;
+  uint8_t getSnoozeCount() const;
+  int8_t getTriggeredAlarm() const;
+  int8_t getNextAlarm() const;
+  uint32_t getNextFireTime() const;
+
+  // Fire records
+  void restoreFiredFor(const uint32_t records[MAX_ALARMS]);
+  uint32_t getFiredFor(uint8_t index) const;
+  bool takeRecordsChanged();
 
   // Getters
-  uint8_t getHour() const;
-  uint8_t getMinute() const;
-  AlarmData getTime() const;
+  uint8_t getHour(uint8_t index) const;
+  uint8_t getMinute(uint8_t index) const;
+  AlarmData getTime(uint8_t index) const;
 
-  // Update method (called every loop)
-  void update(const Time &currentTime);
+  // Update method (called on each SecondTick with the current RTC time)
+  void update(uint32_t now);
 };
 
-#endif // ALARM_H
\ No newline at end of file
+#endif // ALARM_H
@@ -0,0 +1,81 @@
+#ifndef ALARM_SCHEDULER_H
+#define ALARM_SCHEDULER_H
+
+#include <Arduino.h>
+#include "Epoch.h"
+
+#define MAX_ALARMS 4
+
+// Day-of-week mask bits (bit 0 = Sunday, matching DateTime::dayOfTheWeek())
+#define ALARM_SUNDAY 0x01
+#define ALARM_MONDAY 0x02
+#define ALARM_TUESDAY 0x04
+#define ALARM_WEDNESDAY 0x08
+#define ALARM_THURSDAY 0x10
+#define ALARM_FRIDAY 0x20
+#define ALARM_SATURDAY 0x40
+#define ALARM_WEEKDAYS 0x3E
+#define ALARM_WEEKEND 0x41
+#define ALARM_EVERY_DAY 0x7F
+
+struct AlarmData
+{
+  uint8_t hour;
+  uint8_t minute;
+  bool enabled;
+  uint8_t days; // Day-of-week mask
+};
+
+// Alarm table with the next due alarm precomputed.
+// Times are EpochTime seconds in local time (UTC plus the TimeZone offset).
+//
+// Firing is edge-triggered: an alarm fires once the clock crosses its
+// scheduled instant, however late the loop gets there. Each alarm records the
+// instant (date and time) it last fired for, and only later instants are
+// eligible, which gives exactly-once firing across loop stalls, clock
+// adjustments and, with the records persisted, power cycles.
+class AlarmScheduler
+{
+private:
+  AlarmData alarms[MAX_ALARMS];
+  EpochTime firedFor[MAX_ALARMS]; // Last instant each alarm fired (or was consumed) for
+  EpochTime nextFireTime;
+  int8_t nextAlarm;   // -1 when nothing is scheduled
+  uint8_t editedMask; // Alarms edited since the last update
+  bool restored;      // Records loaded at boot, not yet bounded by the catch-up window
+  bool clockChanged;  // RTC was set since the last update
+  bool recordsChanged;
+  bool dirty;
+
+  void applyPending(EpochTime now);
+  void reschedule();
+  EpochTime nextOccurrence(const AlarmData &alarm, EpochTime after) const;
+
+public:
+  // Alarms missed while powered off are still fired if this recent
+  static const uint32_t CATCH_UP_WINDOW = 1800; // 30 minutes
+
+  AlarmScheduler();
+
+  // Table editing (takes effect on the next update)
+  void setAlarm(uint8_t index, const AlarmData &alarm);
+  void setTime(uint8_t index, uint8_t hour, uint8_t minute);
+  void setDays(uint8_t index, uint8_t days);
+  void setEnabled(uint8_t index, bool enabled);
+  void clockAdjusted();
+
+  // Fire records (persisted so power cycles cannot repeat or lose an alarm)
+  void restoreFiredFor(const EpochTime records[MAX_ALARMS]);
+  EpochTime getFiredFor(uint8_t index) const;
+  bool takeRecordsChanged();
+
+  // Getters
+  AlarmData getAlarm(uint8_t index) const;
+  int8_t getNextAlarm() const;
+  EpochTime getNextFireTime() const;
+
+  // Returns the index of the alarm that fired, or -1 (called every loop)
+  int8_t update(EpochTime now);
+};
+
+#endif // ALARM_SCHEDULER_H
@@ -12,6 +12,7 @@ private:
   bool wasPressedFlag;
   bool wasSinglePressedFlag;
   bool wasLongPressedFlag;
+  bool longPressPublished;
   unsigned long pressStartTime;
   unsigned long lastDebounceTime;
   const unsigned long debounceDelay = 50;
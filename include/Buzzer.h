@@ -3,11 +3,44 @@
 
 #include <Arduino.h>
 
+// One step of a melody; frequency 0 is a rest, duration 0 ends the melody
+struct Note {
+  uint16_t frequency; // Hz
+  uint16_t duration;  // ms
+};
+
+// Built-in melodies (PROGMEM), in escalation order for alarms
+#define MELODY_CLASSIC 0
+#define MELODY_FAST 1
+#define MELODY_URGENT 2
+#define MELODY_CHIME 3
+#define MELODY_COUNT 4
+
+// Melody sequencer. On AVR the pitch is generated by Timer1 in CTC mode
+// (hardware toggle of OC1A when the buzzer is on D9) and the compare
+// interrupt advances through the PROGMEM note table, so playback is
+// sample-accurate and costs nothing in loop().
 class Buzzer {
 private:
   int pin;
-  bool isPlaying;
-  unsigned long alarmStartTime;
+  const Note *melody;         // PROGMEM note table, nullptr for a single tone
+  volatile uint8_t noteIndex;
+  volatile uint32_t ticksLeft; // Timer interrupts until the current note ends
+  volatile bool isPlaying;
+  bool isAlarm;
+  bool looping;
+#ifdef __AVR__
+  volatile uint8_t *pinPort;
+  uint8_t pinMask;
+  bool hardwareToggle;        // Buzzer on OC1A, no ISR pin work needed
+  volatile bool softToggle;   // Other pins are toggled by the ISR during tones
+#else
+  unsigned long noteEndTime;  // Host builds advance notes from update()
+#endif
+
+  void startNote(uint16_t frequency, uint16_t duration);
+  void nextNote();
+  void halt();
 
 public:
   Buzzer(int pin);
@@ -16,13 +49,22 @@ public:
   void update();
   
   // Control methods
-  void playAlarm();
+  void playAlarm(uint8_t level = 0); // Higher levels play more urgent melodies
   void stopAlarm();
   bool isAlarmPlaying() const;
   
+  // Melody playback
+  void play(const Note *melody, bool loop = false);
+  void playMelody(uint8_t index, bool loop = false);
+  bool isBusy() const;
+  static const __FlashStringHelper *getMelodyName(uint8_t index);
+  
   // Utility methods
   void playTone(int frequency, unsigned long duration);
   void stopTone();
+
+  // Timer interrupt hook
+  void tick();
 };
 
-#endif 
\ No newline at end of file
+#endif 
@@ -0,0 +1,60 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <Arduino.h>
+#include "Epoch.h"
+
+// RTC seconds per estimate: 30 us of edge jitter is then 0.03 ppm
+#define CALIBRATION_WINDOW 900
+// Change in the estimate worth an EEPROM write
+#define CALIBRATION_SAVE_STEP 20
+
+// Measures how fast micros() runs against the DS1307 and sets the
+// correction in Timebase.
+//
+// Clock passes in each RTC second with the micros() of its square wave
+// edge. Over a window of CALIBRATION_WINDOW unbroken seconds the micros()
+// counted less a million per second is the error in ppm. Each window moves
+// the estimate a quarter of the way to its own figure, so edge jitter and
+// warm-up average out. A gap in the seconds, or an interval more than
+// Timebase::MAX_PPM off (the RTC was written, the board slept through
+// power-down), starts a new window.
+class Calibration
+{
+private:
+  EpochTime lastSecond; // 0 before the first edge of a window
+  uint32_t lastMicros;
+  uint16_t windowSeconds;
+  int32_t windowError; // us counted beyond a million a second
+  int16_t estimate;    // ppm
+  int16_t saved;       // Last value handed out to be persisted
+  uint8_t windows;     // Completed since power-on, saturating
+  bool valid;          // Measured or restored
+  bool changed;
+
+  void setEstimate(int16_t ppm);
+
+public:
+  Calibration();
+
+  // An RTC second and the micros() its edge was seen at
+  void update(EpochTime second, uint32_t edgeMicros);
+  // Drops the current window; the time was set
+  void restart();
+
+  // A persisted estimate, applied at once
+  void restore(int16_t ppm);
+  // Back to no correction, measuring afresh
+  void reset();
+  // True once after the estimate has moved CALIBRATION_SAVE_STEP from the
+  // value last persisted
+  bool takeEstimateChanged();
+
+  bool hasEstimate() const;
+  int16_t getEstimate() const; // ppm micros() runs fast
+  int16_t getSaved() const;
+  uint16_t getWindowSeconds() const;
+  uint8_t getWindowCount() const;
+};
+
+#endif // CALIBRATION_H
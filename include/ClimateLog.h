@@ -0,0 +1,124 @@
+#ifndef CLIMATE_LOG_H
+#define CLIMATE_LOG_H
+
+#include <Arduino.h>
+#include "Epoch.h"
+#include "Events.h"
+
+// Blocks in the EEPROM ring, each a header and a payload of nibble codes
+#define CLIMATE_BLOCKS 9
+#define CLIMATE_BLOCK_BYTES 64
+#define CLIMATE_DEFAULT_INTERVAL 5 // min
+#define CLIMATE_MAX_INTERVAL 240   // min
+
+// Start of a block: the first sample in full. The sequence numbers the
+// blocks in the order written and is stored last, so a block is only
+// valid once its header is complete.
+struct ClimateHeader
+{
+  EpochTime time; // UTC of the first sample
+  int8_t temperature;
+  int8_t humidity;
+  uint8_t interval; // min between samples
+  uint8_t sequence; // 1..CLIMATE_SEQUENCE_MAX, 0 or 0xFF free
+};
+
+#define CLIMATE_SEQUENCE_MAX 254
+#define CLIMATE_PAYLOAD_BYTES (CLIMATE_BLOCK_BYTES - sizeof(ClimateHeader))
+
+struct ClimateSample
+{
+  EpochTime time; // UTC
+  int8_t temperature;
+  int8_t humidity;
+};
+
+// Position while decoding, oldest sample first
+struct ClimateCursor
+{
+  uint8_t block;
+  uint8_t left;   // Blocks still to visit
+  uint8_t nibble; // Next code in the block, NO_BLOCK before its header
+  uint8_t run;    // Repeats of the last sample still to return
+  uint8_t interval;
+  ClimateSample sample;
+};
+
+// What the ring holds, for the compression report
+struct ClimateStats
+{
+  uint16_t samples;
+  uint16_t bytes; // Headers and the payload nibbles used
+  EpochTime first;
+  EpochTime last;
+};
+
+// Temperature and humidity history that survives power loss.
+//
+// Every interval minutes, on the minute, the latest SensorSample is stored
+// as the change from the one before. Most changes are 0 or 1, so a sample
+// is one nibble of a small codebook: the nine changes of -1..+1 in both
+// values, and runs of 2-6 samples without change. Anything bigger is an
+// escape nibble and two zig-zag varints, 3 bits to the nibble. A block
+// starts with a full sample and its time; the times of the others follow
+// from the interval, and a missed sample, a clock change or a new interval
+// starts a new block. The oldest block is overwritten when the ring is
+// full. Like the activity log, the ring has no head pointer: begin() finds
+// the newest block by its sequence number.
+class ClimateLog
+{
+public:
+  static const uint8_t NO_BLOCK = 0xFF;
+
+private:
+  uint8_t interval; // min, 0 when off
+  uint8_t block;    // Newest block, NO_BLOCK while the ring is empty
+  uint8_t sequence; // Of that block
+  bool open;        // Samples still go on in it
+  uint8_t nibble;   // Next free code in it
+  uint8_t runNibble; // Last code, while it can grow into a longer run
+  uint8_t run;       // Samples in that code
+  EpochTime lastTime;
+  int8_t temperature; // Last sample stored
+  int8_t humidity;
+  ClimateSample latest; // From the sensor, waiting for the next slot
+  bool fresh;
+
+  void scan();
+  void store(EpochTime now);
+  bool append(int8_t temperature, int8_t humidity);
+  void openBlock(EpochTime now);
+  void writeNibble(uint8_t index, uint8_t code);
+  void writeVarint(uint16_t value);
+  uint8_t measure(uint8_t block, ClimateSample &last, uint16_t &samples) const;
+  static uint8_t readNibble(uint8_t block, uint8_t index);
+  static uint8_t varintNibbles(uint16_t value);
+  static bool isValid(const ClimateHeader &header);
+
+public:
+  ClimateLog();
+
+  // Loads the interval and finds the newest block, to go on with it
+  void begin();
+
+  // Subscribe to the sensor and the minute
+  void onSample(const SensorSample &sample);
+  void onMinute(const MinuteTick &tick);
+
+  // Minutes between samples, 0 for off; a change starts a new block
+  void setInterval(uint8_t minutes);
+  uint8_t getInterval() const;
+
+  // Streaming, decoded straight from EEPROM: rewind, then next() until false
+  void rewind(ClimateCursor &cursor) const;
+  bool next(ClimateCursor &cursor, ClimateSample &sample) const;
+
+  ClimateStats getStats() const;
+  void clear();
+
+  // Zig-zag: small changes of either sign map to small unsigned values
+  static uint16_t zigzag(int16_t value);
+  static int16_t unzigzag(uint16_t value);
+};
+
+#endif // CLIMATE_LOG_H
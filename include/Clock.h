@@ -3,14 +3,42 @@
 
 #include <Arduino.h>
 #include "RTClock.h"
+#include "TimeZone.h"
+#include "Calibration.h"
 #include "Timer.h"
 #include "Alarm.h"
 #include "HTSensor.h"
+#include "Scheduler.h"
+#include "EventBus.h"
+#include "Format.h"
 
 
 // Forward declarations
 class Buzzer;
 
+// Settings pages (one page per alarm entry)
+const uint8_t SETTING_TIME = 0;
+const uint8_t SETTING_DATE = 1;
+const uint8_t SETTING_ALARM = 2;
+const uint8_t SETTING_TIMER = SETTING_ALARM + MAX_ALARMS;
+const uint8_t SETTINGS_COUNT = SETTING_TIMER + 1;
+
+// Fields of the settings draft that differ from the live values
+#define DRAFT_TIME 0x01
+#define DRAFT_DATE 0x02
+#define DRAFT_TIMER 0x04
+#define DRAFT_ALARM 0x10 // Shifted left by the alarm index
+
+// Settings mode edits, kept in RAM until committed. Time and date are an
+// offset so the clock keeps running while it is being set.
+struct SettingsDraft
+{
+  int32_t offset; // s added to the local time
+  AlarmData alarms[MAX_ALARMS];
+  Time timer;
+  uint8_t changed; // DRAFT_* bits
+};
+
 class Clock
 {
 private:
@@ -19,50 +47,101 @@ private:
   Buzzer *buzzer;
   Alarm alarm;
   Timer timer;
+  TimeZone zone;
+  Calibration calibration;
+  SettingsDraft draft;
+
+  EpochTime getLocalTime() const;
+  EpochTime getDraftTime() const;
+  bool setLocalTime(EpochTime local);
+  void saveCalibration();
+  void alarmsChanged();
+  static void formatAlarm(char *text, uint8_t index, const AlarmData &alarmData);
+  static void formatClimate(char *text, int8_t value, char unit);
 
 public:
   Clock();
 
-  void begin(RTClock *rtc, HTSensor *dht11, Buzzer *buzzer);
+  void begin(RTClock *rtc, HTSensor *dht11, Buzzer *buzzer, Scheduler *scheduler);
   void update();
 
-  // Getters
+  // Subscribe to SecondTick; checks the alarms
+  void onSecondTick(const SecondTick &tick);
+
+  // Getters (local time)
   Time getTime() const;
   Date getDate() const;
-  AlarmData getAlarmTime();
+  EpochTime getUnixTime() const; // UTC, as held by the RTC
+  uint32_t getSecondMicros() const; // micros() when the RTC second started
+  AlarmData getAlarmTime(uint8_t index);
   TimerData getTimerTime();
   int8_t getTemperature() const;
   int8_t getHumidity() const;
 
-  char *getTimeString() const;
-  char *getDateString() const;
-  char *getAlarmTimeString() const;
-  char *getTimerString() const;
-  char *getTemperatureString() const;
-  char *getHumidityString() const;
+  // Display texts, written to the caller's DISPLAY_CHARS buffer and
+  // returned for passing on to Display::print()
+  char *getTimeString(char *text) const;
+  char *getDateString(char *text) const;
+  char *getAlarmTimeString(char *text) const;
+  char *getAlarmTimeString(char *text, uint8_t index) const;
+  char *getTimerString(char *text) const;
+  char *getTemperatureString(char *text) const;
+  char *getHumidityString(char *text) const;
+
+  // RTC: time and date are local, unix time is UTC. False if the RTC
+  // write failed on the bus.
+  bool setTime(const Time &time);
+  bool setDate(const Date &date);
+  bool setUnixTime(EpochTime time); // UTC
+  uint16_t getBusRecoveries() const; // I2C timeouts cleared by clocking SCL
+  bool isTimeLost() const;           // The RTC had stopped and is not set yet
+
+  // Time zone (persisted)
+  bool setTimeZone(uint8_t zone);
+  const TimeZone &getTimeZone() const;
 
-  // RTC
-  void setTime(const Time &time);
-  void setDate(const Date &date);
+  // Resonator calibration against the RTC (persisted)
+  const Calibration &getCalibration() const;
+  void resetCalibration();
 
-  // Settings
-  void adjustSetting(int setting, int part);
+  // Settings mode: edits go to a draft, applied in one go by commit
+  void beginSettings();
+  void adjustSetting(uint8_t setting, uint8_t part);
+  char *getSettingString(char *text, uint8_t setting) const;
+  bool commitSettings(); // False if the RTC did not take the time or date
+  void cancelSettings();
+
+  // Settings storage
   void loadSettings();
   void saveSettings();
+  void saveAlarmRecords();
 
   // Alarm
   bool isAlarmTriggered() const;
-  void stopAlarm();
-  void setAlarmTime(uint8_t hour, uint8_t minute);
-  void enableAlarm();
-  void disableAlarm();
-  void setAlarmData(const AlarmData &alarmData);
+  AlarmState getAlarmState() const;
+  uint8_t getAlarmSnoozeCount() const;
+  void snoozeAlarm();
+  void dismissAlarm();
+  void setAlarmSnooze(const SnoozeConfig &config);
+  SnoozeConfig getAlarmSnooze() const;
+  void setAlarmTime(uint8_t index, uint8_t hour, uint8_t minute);
+  void setAlarmDays(uint8_t index, uint8_t days);
+  void enableAlarm(uint8_t index);
+  void disableAlarm(uint8_t index);
+  void setAlarmData(uint8_t index, const AlarmData &alarmData);
+  int8_t getNextAlarm() const;
+  uint32_t getNextAlarmTime() const;
+
+  // Buzzer
+  bool previewMelody(uint8_t index);
+  void stopMelody();
 
   // Timer
   void startTimer();
   void stopTimer();
   void resetTimer();
   void setTimerTime(uint8_t hour, uint8_t minute, uint8_t second);
+  bool isTimerRunning() const;
 };
 
 #endif
\ No newline at end of file
@@ -23,9 +23,12 @@ private:
   // 7-segment display patterns for letters
   static const uint8_t letterPatterns[26];
 
+  // Refresh state; one digit is lit per Timer2 tick
+  volatile uint8_t scanDigit;
+  volatile bool enabled;
+
   void displayDigit(uint8_t pattern);
-  void multiplexDisplay();
-  uint8_t getPatternForChar(char c);
+  void selectDigit(uint8_t code);
 
 public:
   Display();
@@ -47,6 +50,15 @@ public:
   void setDotState(bool dotState);
   void update();
 
+  // Multiplexing runs from the Timer2 compare interrupt, so the main loop
+  // is free to sleep. refreshNextDigit() is the interrupt body.
+  void refreshNextDigit();
+  void setEnabled(bool enabled);
+  bool isEnabled() const;
+
+  // Segment pattern for a character (no dot)
+  static uint8_t getPatternForChar(char c);
+
   // Helper methods
   void showNumber(int number, int position);
   void showDigit(uint8_t digit, int position);
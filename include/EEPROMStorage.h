@@ -5,33 +5,133 @@
 #include <EEPROM.h>
 #include "RTClock.h"
 #include "Alarm.h"
+#include "Profiler.h"
+#include "ActivityLog.h"
+#include "ClimateLog.h"
 
 class EEPROMStorage
 {
 private:
-  static const int MAGIC_NUMBER = 0x1234;
+  // The magics are uint16_t, not int: int is 2 bytes on the AVR but 4 on
+  // the host, and the image has to be the same on both
+  static const uint16_t MAGIC_NUMBER = 0x1236; // Bumped for the snooze settings layout
   static const int MAGIC_ADDRESS = 0;
   static const int SETTINGS_ADDRESS = 4;
+  static const uint16_t RECORDS_MAGIC_NUMBER = 0x5AF1;
+  static const int RECORDS_MAGIC_ADDRESS = 32;
+  static const int RECORDS_ADDRESS = 34;
+  static const int TIME_ZONE_ADDRESS = RECORDS_ADDRESS + MAX_ALARMS * sizeof(uint32_t);
+  static const int CALIBRATION_ADDRESS = TIME_ZONE_ADDRESS + 1;
+  static const int CLIMATE_INTERVAL_ADDRESS = CALIBRATION_ADDRESS + 4;
+  static const int LOG_ADDRESS = 64;
+  static const int CLIMATE_ADDRESS = LOG_ADDRESS + LOG_RECORDS * 4;
+  static const int EEPROM_BYTES = 1024; // ATmega328P
 
+  // Resonator correction with its complement, so erased and cleared cells
+  // both read as none
+  struct CalibrationRecord
+  {
+    int16_t ppm;
+    int16_t check;
+  };
+
+  // Climate log interval, with its complement like the calibration
+  struct IntervalRecord
+  {
+    uint8_t minutes;
+    uint8_t check;
+  };
+
+  // Written field by field, as the AVR packs them: a host compiler pads
+  // Date (and so Settings) to align the year
   struct Settings
   {
     Time time;
     Date date;
-    AlarmData alarm;
+    AlarmData alarms[MAX_ALARMS];
+    SnoozeConfig snooze;
   };
 
+  static const int SETTINGS_DATE = SETTINGS_ADDRESS + 3;
+  static const int SETTINGS_ALARMS = SETTINGS_DATE + 4;
+  static const int SETTINGS_SNOOZE = SETTINGS_ALARMS + MAX_ALARMS * 4;
+
+  // Stored as they are in RAM, so they must not be padded anywhere
+  static_assert(sizeof(Time) == 3 && sizeof(AlarmData) == 4 && sizeof(SnoozeConfig) == 2,
+                "Settings fields are padded");
+  static_assert(sizeof(LogRecord) == 4 && sizeof(ClimateHeader) == 8 && sizeof(CalibrationRecord) == 4,
+                "EEPROM records are padded");
+  static_assert(SETTINGS_SNOOZE + sizeof(SnoozeConfig) <= RECORDS_MAGIC_ADDRESS,
+                "Settings overlap the alarm fire records");
+  static_assert(RECORDS_MAGIC_ADDRESS + sizeof(uint16_t) <= RECORDS_ADDRESS,
+                "Alarm fire records overlap their magic");
+  static_assert(CALIBRATION_ADDRESS + sizeof(CalibrationRecord) <= CLIMATE_INTERVAL_ADDRESS,
+                "Calibration overlaps the climate log interval");
+  static_assert(CLIMATE_INTERVAL_ADDRESS + sizeof(IntervalRecord) <= LOG_ADDRESS,
+                "Climate log interval overlaps the activity log");
+  static_assert(LOG_RECORDS * sizeof(LogRecord) == CLIMATE_ADDRESS - LOG_ADDRESS,
+                "Activity log size does not match the climate log address");
+  static_assert(CLIMATE_ADDRESS + CLIMATE_BLOCKS * CLIMATE_BLOCK_BYTES <= EEPROM_BYTES,
+                "Climate log does not fit the EEPROM");
+
 public:
   EEPROMStorage();
 
   // Settings storage
-  void saveSettings(const Time &time, const Date &date, const AlarmData &alarm);
-  bool loadSettings(Time &time, Date &date, AlarmData &alarm);
+  void saveSettings(const Time &time, const Date &date, const AlarmData alarms[MAX_ALARMS],
+                    const SnoozeConfig &snooze);
+  bool loadSettings(Time &time, Date &date, AlarmData alarms[MAX_ALARMS], SnoozeConfig &snooze);
+
+  // Alarm fire records (instant each alarm last fired for)
+  void saveAlarmRecords(const uint32_t records[MAX_ALARMS]);
+  bool loadAlarmRecords(uint32_t records[MAX_ALARMS]);
+
+  // Selected time zone (index into the TimeZone table)
+  void saveTimeZone(uint8_t zone);
+  bool loadTimeZone(uint8_t &zone);
+
+  // Resonator correction measured by Calibration, ppm
+  void saveCalibration(int16_t ppm);
+  bool loadCalibration(int16_t &ppm);
+  void clearCalibration();
+
+  // Activity log ring (see ActivityLog)
+  void readLogRecord(uint8_t index, LogRecord &record);
+  void writeLogRecord(uint8_t index, const LogRecord &record);
+  void eraseLog();
+
+  // Climate log ring (see ClimateLog): block headers and payload bytes
+  void saveClimateInterval(uint8_t minutes);
+  bool loadClimateInterval(uint8_t &minutes);
+  void readClimateHeader(uint8_t block, ClimateHeader &header);
+  void writeClimateHeader(uint8_t block, const ClimateHeader &header);
+  uint8_t readClimateByte(uint8_t block, uint8_t offset);
+  void writeClimateByte(uint8_t block, uint8_t offset, uint8_t value);
+  void eraseClimateBlock(uint8_t block);
+  void eraseClimate();
 
   // Utility methods
   bool hasValidSettings();
   void clearSettings();
 
 private:
+  // EEPROM.put(), counting the bytes that really get rewritten
+  template <typename T>
+  void put(int address, const T &value)
+  {
+#ifdef CLOCK_PROFILE
+    const uint8_t *bytes = (const uint8_t *)&value;
+    for (uint8_t i = 0; i < sizeof(T); i++)
+    {
+      if (EEPROM.read(address + i) != bytes[i])
+      {
+        PROFILE_COUNT(COUNTER_EEPROM_WRITE, 1);
+      }
+    }
+#endif
+    EEPROM.put(address, value);
+  }
+
   void writeSettings(const Settings &settings);
   bool readSettings(Settings &settings);
 };
@@ -0,0 +1,52 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <Arduino.h>
+
+// Time and Date structures
+struct Time
+{
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+};
+
+struct Date
+{
+  uint8_t day;
+  uint8_t month;
+  uint16_t year;
+};
+
+// Seconds since 1970-01-01 00:00:00, as returned by RTClock::getUnixTime()
+// and used by the alarm table. Instants compare and subtract as plain
+// integers; fields are only needed for display and editing. Valid for
+// 1970-2099, which covers the DS1307's 2000-2099.
+typedef uint32_t EpochTime;
+
+// Calendar arithmetic on EpochTime. Month lengths come from a table in
+// flash, and years are found by 4-year cycle, with no loop over the years.
+class Epoch
+{
+public:
+  static const uint32_t SECONDS_PER_MINUTE = 60;
+  static const uint32_t SECONDS_PER_HOUR = 3600;
+  static const uint32_t SECONDS_PER_DAY = 86400UL;
+
+  // Calendar
+  static bool isLeapYear(uint16_t year);
+  static uint8_t daysInMonth(uint16_t year, uint8_t month);
+  static uint8_t dayOfWeek(EpochTime time); // 0 = Sunday
+
+  // Fields to instant and back
+  static EpochTime fromFields(const Date &date, const Time &time);
+  static Date toDate(EpochTime time);
+  static Time toTime(EpochTime time);
+
+  // Days and times of day
+  static uint16_t toDays(const Date &date); // Days since 1970-01-01
+  static EpochTime startOfDay(EpochTime time);
+  static uint32_t toSeconds(const Time &time); // Seconds since midnight
+};
+
+#endif // EPOCH_H
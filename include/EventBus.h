@@ -0,0 +1,71 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <Arduino.h>
+#include "Events.h"
+
+// Static publish/subscribe. Each event type has one subscriber table, fixed
+// at compile time and kept in flash; publish() calls the handlers in order,
+// synchronously. There is no queue and no registration at run time.
+//
+// The program that owns the objects declares who listens to what, once:
+//
+//   static void chime(const TimerCompleted &) { buzzer.playMelody(MELODY_CHIME); }
+//   EVENT_SUBSCRIBERS(TimerCompleted, chime);
+//
+// Event types without a table in the program have no subscribers; the
+// defaults in EventBus.cpp are weak and give way to EVENT_SUBSCRIBERS.
+
+template <typename E>
+struct EventTable
+{
+  void (*const *handlers)(const E &event); // PROGMEM array
+  uint8_t count;
+};
+
+template <typename E>
+class EventBus
+{
+public:
+  typedef void (*Handler)(const E &event);
+
+  static void publish(const E &event)
+  {
+    const Handler *handlers = (const Handler *)pgm_read_ptr(&subscribers.handlers);
+    uint8_t count = pgm_read_byte(&subscribers.count);
+    for (uint8_t i = 0; i < count; i++)
+    {
+      Handler handler = (Handler)pgm_read_ptr(&handlers[i]);
+      handler(event);
+    }
+  }
+
+private:
+  static const EventTable<E> subscribers; // PROGMEM
+};
+
+template <typename E>
+inline void publish(const E &event)
+{
+  EventBus<E>::publish(event);
+}
+
+// Every event type, so each table is known wherever events are published
+template <> const EventTable<SecondTick> EventBus<SecondTick>::subscribers;
+template <> const EventTable<MinuteTick> EventBus<MinuteTick>::subscribers;
+template <> const EventTable<AlarmFired> EventBus<AlarmFired>::subscribers;
+template <> const EventTable<TimerCompleted> EventBus<TimerCompleted>::subscribers;
+template <> const EventTable<ButtonEvent> EventBus<ButtonEvent>::subscribers;
+template <> const EventTable<SensorSample> EventBus<SensorSample>::subscribers;
+template <> const EventTable<AlarmDismissed> EventBus<AlarmDismissed>::subscribers;
+template <> const EventTable<SettingsChanged> EventBus<SettingsChanged>::subscribers;
+template <> const EventTable<SensorFault> EventBus<SensorFault>::subscribers;
+template <> const EventTable<MemoryLow> EventBus<MemoryLow>::subscribers;
+
+#define EVENT_SUBSCRIBERS(Type, ...)                                                  \
+  static const EventBus<Type>::Handler Type##Subscribers[] PROGMEM = {__VA_ARGS__};   \
+  template <>                                                                         \
+  const EventTable<Type> EventBus<Type>::subscribers PROGMEM = {                      \
+      Type##Subscribers, sizeof(Type##Subscribers) / sizeof(Type##Subscribers[0])}
+
+#endif // EVENT_BUS_H
@@ -0,0 +1,102 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdint.h>
+
+// Events published on the EventBus. Each is passed by reference to the
+// subscribers in the order of their table, then forgotten.
+
+// A new RTC second has been read. Fields are UTC, as kept by the RTC;
+// Clock::getTime() has the local time.
+struct SecondTick
+{
+  uint32_t unixTime;
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+};
+
+// The RTC reached second 0 of a minute (UTC)
+struct MinuteTick
+{
+  uint32_t unixTime;
+  uint8_t hour;
+  uint8_t minute;
+};
+
+// An alarm started ringing; round counts the snoozes before it
+struct AlarmFired
+{
+  uint8_t index;
+  uint8_t round;
+};
+
+// A ringing or snoozed alarm was stopped for good: dismissed, switched
+// off, or out of snooze rounds
+struct AlarmDismissed
+{
+  uint8_t index;
+  uint8_t round;
+};
+
+// The countdown timer reached zero
+struct TimerCompleted
+{
+  uint32_t duration; // ms
+};
+
+enum ButtonAction
+{
+  BUTTON_DOWN,   // Debounced press
+  BUTTON_SINGLE, // Released after a short press
+  BUTTON_LONG,   // Held for the long press delay, once per press
+  BUTTON_UP,     // Any other release (long or too short)
+};
+
+struct ButtonEvent
+{
+  uint8_t pin;
+  ButtonAction action;
+};
+
+// A new DHT reading; a value out of range keeps the last good one
+struct SensorSample
+{
+  int8_t temperature; // deg C
+  int8_t humidity;    // %
+};
+
+// Settings changed by the user, a command or a time sync
+enum SettingsItem
+{
+  SETTINGS_CLOCK = 0x01, // RTC time or date set
+  SETTINGS_ZONE = 0x02,
+  SETTINGS_ALARMS = 0x04, // Alarm times, days or snooze
+  SETTINGS_TIMER = 0x08,
+};
+
+struct SettingsChanged
+{
+  uint8_t items; // SettingsItem bits
+};
+
+enum SensorFaultCode
+{
+  SENSOR_NO_REPLY = 1,
+  SENSOR_OUT_OF_RANGE = 2,
+};
+
+// The DHT stopped giving good readings; published once until it recovers
+struct SensorFault
+{
+  uint8_t code; // SensorFaultCode
+};
+
+// The stack came within the threshold of the heap; published once until
+// the headroom recovers
+struct MemoryLow
+{
+  uint16_t headroom; // bytes
+};
+
+#endif // EVENTS_H
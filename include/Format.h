@@ -0,0 +1,35 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <Arduino.h>
+
+// Characters of a display text; not terminated
+#define DISPLAY_CHARS 6
+
+// Numbers as text without the heap: into a caller's buffer, or straight to
+// a Print such as Serial. Digits come from multiplying by a scaled
+// reciprocal and shifting, as the ATmega has no divide instruction and the
+// library's division loop takes a few hundred cycles a digit.
+class Format
+{
+public:
+  // Quotients by reciprocal: divideBy10 for any 8-bit value,
+  // divideBy100 for values up to 9999
+  static uint8_t divideBy10(uint8_t value);
+  static uint8_t divideBy100(uint16_t value);
+
+  // Two digits with a leading zero, for 0-99
+  static void twoDigits(char *buffer, uint8_t value);
+
+  // Three two-digit fields, as on the display: "hhmmss", "ddmmyy"
+  static void display(char *buffer, uint8_t first, uint8_t second, uint8_t third);
+
+  // Serial output: "hh:mm:ss", "hh:mm", "dd.mm.yyyy" and the days of an
+  // alarm as "MTWTF--", Monday first
+  static void printTime(Print &out, uint8_t hour, uint8_t minute, uint8_t second);
+  static void printTime(Print &out, uint8_t hour, uint8_t minute);
+  static void printDate(Print &out, uint8_t day, uint8_t month, uint16_t year);
+  static void printDays(Print &out, uint8_t days);
+};
+
+#endif // FORMAT_H
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <DHT.h>
+#include "Scheduler.h"
 
 #define DHTTYPE DHT11
 
@@ -11,20 +12,22 @@ class HTSensor
 private:
   DHT dht;
   int pin;
-  unsigned long lastTemperatureUpdate = 0;
-  unsigned long lastHumidityUpdate = 0;
   int8_t temperature = 0;
   int8_t humidity = 0;
+  bool faulty = false; // SensorFault published, no good reading since
   static const unsigned long UPDATE_INTERVAL = 3000;
 
+  void read();
+  static void readTask(void *sensor);
+
 public:
   HTSensor(int pin);
 
-  void begin();
+  void begin(Scheduler *scheduler);
 
-  // Getters
+  // Getters (last sampled values)
   int8_t getTemperature();
   int8_t getHumidity();
 };
 
-#endif
\ No newline at end of file
+#endif
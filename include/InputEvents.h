@@ -0,0 +1,48 @@
+#ifndef INPUT_EVENTS_H
+#define INPUT_EVENTS_H
+
+#include <stdint.h>
+#include "RingBuffer.h"
+
+// Events raised in interrupt handlers and consumed by loop(). Each is a few
+// bytes and copied whole through a RingBuffer; timestamps are the low 16
+// bits of millis() in the handler, enough to order and debounce them.
+
+// DS1307 square wave falling edge: a new second has started
+struct TickEvent
+{
+  uint16_t count; // Edges since boot, wraps
+};
+
+// Raw level change on a button pin, before debouncing
+struct ButtonEdgeEvent
+{
+  uint8_t pin;
+  uint8_t level;
+  uint16_t time;
+};
+
+// One byte from the UART receiver
+struct SerialRxEvent
+{
+  uint8_t data;
+  uint8_t error; // Frame or overrun error flags from UCSR0A, 0 if clean
+};
+
+// A decoded DHT11 frame
+struct SensorFrameEvent
+{
+  int8_t temperature; // deg C
+  uint8_t humidity;   // %
+  uint8_t ok;         // Checksum matched
+  uint16_t time;
+};
+
+// Queue sizes for each handoff: enough for the longest loop() stall they
+// have to ride out (a tick per second, bursts of bounce edges, a command line)
+typedef RingBuffer<TickEvent, 4> TickQueue;
+typedef RingBuffer<ButtonEdgeEvent, 16> ButtonEdgeQueue;
+typedef RingBuffer<SerialRxEvent, 64> SerialRxQueue;
+typedef RingBuffer<SensorFrameEvent, 2> SensorFrameQueue;
+
+#endif // INPUT_EVENTS_H
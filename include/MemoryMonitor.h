@@ -0,0 +1,64 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <Arduino.h>
+#include "Scheduler.h"
+
+// Byte written over the free RAM at boot; anything else has been used
+#define MEMORY_PAINT 0xC5
+// MemoryLow below this many untouched bytes between heap and stack
+#define MEMORY_LOW_HEADROOM 128
+#define MEMORY_CHECK_INTERVAL 5000 // ms
+
+// RAM use, in bytes
+struct MemoryStats
+{
+  uint16_t staticSize;  // .data and .bss
+  uint16_t heapUsed;    // Heap start to its top, free blocks included
+  uint16_t heapFree;    // In the free list, below the top
+  uint8_t fragments;    // Blocks in the free list
+  uint16_t largestFree; // Largest block malloc() could return now
+  uint16_t stackNow;
+  uint16_t stackPeak;   // Deepest the stack has been since boot
+  uint16_t headroom;    // Never touched, between the heap and the stack peak
+};
+
+// Watches for the stack and heap growing into each other.
+//
+// The startup code paints the RAM above .bss with MEMORY_PAINT before
+// main() runs. Whatever the stack or heap writes later is no longer paint,
+// so the run of paint left between them is the closest they have come:
+// the stack high-water mark without instrumenting any function. The heap
+// side walks the allocator's free list, as String churn leaves holes there
+// that a larger block cannot use.
+//
+// A scheduler task checks the headroom and publishes MemoryLow once when it
+// falls below the threshold, again only after it has recovered. Only the
+// AVR build measures anything; elsewhere the stats read as zero.
+class MemoryMonitor
+{
+private:
+  static uint16_t lowHeadroom;
+  static bool low;
+
+  static void checkTask(void *context);
+
+public:
+  // Threshold 0 turns the warning off; the stats are there either way
+  static void begin(Scheduler *scheduler, uint16_t lowHeadroom = MEMORY_LOW_HEADROOM);
+
+  // Scans the painted region: about 0.6 ms per kB free at 16 MHz
+  static MemoryStats read();
+  static bool isMeasured();
+
+  // Publishes MemoryLow when the headroom crosses the threshold
+  static void check(uint16_t headroom);
+
+  // The lowest byte the stack has written between start (the heap top) and
+  // end: where the first run of paint ends. Blocks freed off the top of the
+  // heap are no longer paint but lie below the run, so they are skipped.
+  // unused is the length of the run, 0 if the two have met.
+  static const uint8_t *findStackPeak(const uint8_t *start, const uint8_t *end, uint16_t &unused);
+};
+
+#endif // MEMORY_MONITOR_H
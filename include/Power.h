@@ -0,0 +1,91 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+#include "RTClock.h"
+
+// CPU states, in order of increasing savings
+enum PowerState
+{
+  POWER_ACTIVE,
+  POWER_IDLE, // Clocks running, CPU halted until the next interrupt
+  POWER_DOWN, // Everything stopped but the RTC square wave and pin changes
+  POWER_STATE_COUNT
+};
+
+// What ended a sleep
+enum WakeSource
+{
+  WAKE_TIMER,  // millis tick, display refresh or buzzer interrupt
+  WAKE_RTC,    // DS1307 square wave second edge
+  WAKE_BUTTON, // Pin change on a button
+  WAKE_UART,   // Received byte, or its start bit in power-down
+  WAKE_SOURCE_COUNT
+};
+
+enum NightMode
+{
+  NIGHT_OFF,
+  NIGHT_ON,   // Display off until switched back
+  NIGHT_AUTO  // Display off inside the configured window
+};
+
+#define MAX_WAKE_PINS 4
+#define NIGHT_AWAKE_WINDOW 10000 // Display stays on this long after input
+
+// Sleeps the MCU between interrupts and keeps rough energy accounting.
+// Idle sleep is always safe: every interrupt wakes it and millis() keeps
+// counting. Power-down stops millis(), so the caller only asks for it when
+// nothing millis-based is pending; the RTC square wave then wakes the MCU
+// once a second.
+class Power
+{
+private:
+  RTClock *rtc;
+  uint8_t wakePins[MAX_WAKE_PINS];
+  uint8_t wakePinCount;
+
+  NightMode nightMode;
+  uint16_t nightStart; // Minutes since midnight
+  uint16_t nightEnd;
+  unsigned long lastActivity;
+
+  // Accounting
+  uint32_t stateSeconds[POWER_STATE_COUNT];
+  uint32_t stateMicros[POWER_STATE_COUNT]; // Below one second, carried over
+  uint16_t wakeCount[WAKE_SOURCE_COUNT];
+  unsigned long lastMark;
+
+  void account(PowerState state, uint32_t micros);
+  void armPinWake(bool armed);
+  WakeSource sleepOnce(bool powerDown);
+
+public:
+  Power();
+
+  void begin(RTClock *rtc, const uint8_t *buttonPins, uint8_t count);
+
+  // Halt until the next interrupt; see class comment for powerDown
+  void sleep(bool powerDown);
+
+  // Night mode
+  void setNightMode(NightMode mode);
+  void setNightWindow(uint16_t startMinute, uint16_t endMinute);
+  NightMode getNightMode() const;
+  uint16_t getNightStart() const;
+  uint16_t getNightEnd() const;
+  bool isNight(const Time &now) const;
+  void notifyActivity();
+  bool isAwake() const;
+
+  // Statistics
+  uint32_t getStateSeconds(PowerState state) const;
+  uint16_t getWakeCount(WakeSource source) const;
+  uint16_t getAverageCurrent() const; // Estimate in 0.1 mA
+  void resetStats();
+  static uint16_t getStateCurrent(PowerState state);
+  static const __FlashStringHelper *getStateName(PowerState state);
+  static const __FlashStringHelper *getWakeSourceName(WakeSource source);
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+
+// Loop stages, in the order loop() runs them
+enum LoopStage
+{
+  STAGE_SERIAL,  // Serial command handling
+  STAGE_TASKS,   // Scheduler tasks
+  STAGE_BUTTONS, // Button debouncing and the UI events it raises
+  STAGE_CLOCK,   // RTC, alarms and persistence
+  STAGE_LOOP,    // Whole pass, sleep excluded
+  STAGE_COUNT
+};
+
+// Event counters
+enum ProfileCounter
+{
+  COUNTER_I2C,          // RTC transactions
+  COUNTER_EEPROM_WRITE, // Bytes actually rewritten
+  COUNTER_COUNT
+};
+
+// Histogram buckets grow by 4x: <16us, <64us, <256us, <1ms, <4ms, <16ms,
+// <64ms, and everything slower
+#define PROFILE_BUCKETS 8
+#define PROFILE_FIRST_BUCKET 16 // us
+
+// Build with -D CLOCK_PROFILE (env:nanoatmega328_profile) to enable.
+// Without it the macros below expand to nothing and no code or RAM is used.
+#ifdef CLOCK_PROFILE
+
+struct StageProfile
+{
+  uint16_t histogram[PROFILE_BUCKETS]; // Saturating counts
+  uint32_t maxMicros;
+  uint32_t totalMicros;
+  uint32_t samples;
+};
+
+class Profiler
+{
+private:
+  static StageProfile stages[STAGE_COUNT];
+  static uint32_t counters[COUNTER_COUNT];
+  static uint32_t loopStart;
+  static uint32_t stageStart;
+
+  static void record(LoopStage stage, uint32_t micros);
+
+public:
+  static void beginLoop();
+  static void mark(LoopStage stage); // Ends the stage that just ran
+  static void endLoop();
+  static void count(ProfileCounter counter, uint16_t amount = 1);
+
+  static const StageProfile &getStage(LoopStage stage);
+  static uint32_t getCounter(ProfileCounter counter);
+  static uint32_t getBucketLimit(uint8_t bucket); // Exclusive, in us
+  static void reset();
+
+  static const __FlashStringHelper *getStageName(LoopStage stage);
+  static const __FlashStringHelper *getCounterName(ProfileCounter counter);
+};
+
+#define PROFILE_BEGIN_LOOP() Profiler::beginLoop()
+#define PROFILE_MARK(stage) Profiler::mark(stage)
+#define PROFILE_END_LOOP() Profiler::endLoop()
+#define PROFILE_COUNT(counter, amount) Profiler::count(counter, amount)
+
+#else
+
+#define PROFILE_BEGIN_LOOP()
+#define PROFILE_MARK(stage)
+#define PROFILE_END_LOOP()
+#define PROFILE_COUNT(counter, amount)
+
+#endif // CLOCK_PROFILE
+
+#endif // PROFILER_H
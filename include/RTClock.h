@@ -4,21 +4,18 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <RTClib.h>
+#include "Epoch.h"
 
-// Time and Date structures
-struct Time
-{
-  uint8_t hour;
-  uint8_t minute;
-  uint8_t second;
-};
+// Fallback poll period when the SQW output is not wired
+#define RTC_POLL_INTERVAL 200
+// Polling takes over when no SQW edge came for this long
+#define RTC_SQW_TIMEOUT 1500 // ms
 
-struct Date
-{
-  uint8_t day;
-  uint8_t month;
-  uint16_t year;
-};
+// An I2C transfer gives up after this long instead of hanging the loop
+#define RTC_I2C_TIMEOUT 25000 // us
+
+// Where a stopped RTC is started from: the DS1307's first second, UTC
+#define RTC_UNSET_TIME 946684800UL // 2000-01-01 00:00:00
 
 class RTClock
 {
@@ -26,19 +23,58 @@ private:
   RTC_DS1307 rtcModule;
   uint8_t sdaPin;
   uint8_t sclPin;
+  int8_t sqwPin;
+  bool squareWave; // Edges are arriving
+  bool timeLost;   // Found stopped at begin(), not set since
+
+  // Last reading; refreshed once per second instead of on every getter
+  DateTime current;
+  unsigned long lastPoll;
+  uint32_t secondMicros; // micros() when the current second started
+  uint16_t busRecoveries;
+
+  static volatile bool secondTick;
+  static volatile uint16_t tickCount;
+  static volatile uint32_t edgeMicros;
+  static void onSquareWave();
+
+  bool refresh();
+  void publishTick();
+  bool checkBus();
+  void recoverBus();
 
 public:
   RTClock();
 
-  void begin(uint8_t sdaPin, uint8_t sclPin);
+  // sqwPin must be an external interrupt pin (D2/D3), or -1 to poll
+  void begin(uint8_t sdaPin, uint8_t sclPin, int8_t sqwPin = -1);
+
+  // Re-reads the module when a new second starts and publishes SecondTick
+  // (and MinuteTick at second 0); true if it did
+  bool update();
+  bool hasSquareWave() const; // Edges seen within RTC_SQW_TIMEOUT
+  uint16_t getTickCount() const;
+
+  // A power-down ended without the edge that was due: millis() stood
+  // still, so update() cannot time the square wave out by itself
+  void missedEdge();
+
+  // micros() at the start of the current second: the square wave edge, or
+  // when polling noticed the change (up to RTC_POLL_INTERVAL late)
+  uint32_t getSecondMicros() const;
+
+  // UTC (cached, see update); Clock converts it to local time
+  EpochTime getUnixTime();
+
+  // The oscillator had stopped (battery out): the RTC was started from
+  // RTC_UNSET_TIME and needs setting
+  bool isTimeLost() const;
 
-  // Time and date getters
-  Time getTime();
-  Date getDate();
+  // One write, no read; false if the bus timed out, the time unchanged
+  bool setUnixTime(EpochTime time);
 
-  // Time and date setters
-  void setTime(const Time &time);
-  void setDate(const Date &date);
+  // Times a transfer timed out and the bus was clocked free
+  uint16_t getBusRecoveries() const;
 
   // RTC module access
   RTC_DS1307 *getModule();
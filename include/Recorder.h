@@ -0,0 +1,80 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <Arduino.h>
+
+// Recorded inputs
+enum RecordType
+{
+  RECORD_TICK,   // RTC second, as the loop picked it up
+  RECORD_BUTTON, // Raw button level change; data = pin | level << 7
+  RECORD_SERIAL, // One received byte
+  RECORD_GAP,    // Only carries time past the 14-bit delta
+};
+
+// Events kept; the oldest are overwritten. 3 bytes each.
+#ifndef RECORD_CAPACITY
+#define RECORD_CAPACITY 96
+#endif
+
+#define RECORD_MAX_DELTA 0x3FFF // ms
+
+// Build with -D CLOCK_RECORD (env:nanoatmega328_record) to enable. A
+// normal build leaves out the 3 * RECORD_CAPACITY byte event buffer and the
+// rec commands, and the hooks in the input paths cost nothing.
+#ifdef CLOCK_RECORD
+
+struct RecordEvent
+{
+  uint16_t header; // Type in the top 2 bits, ms since the previous event below
+  uint8_t data;
+};
+
+class Recorder
+{
+private:
+  static RecordEvent events[RECORD_CAPACITY];
+  static uint8_t first;
+  static uint8_t count;
+  static uint16_t dropped;
+  static uint32_t baseTime;
+  static uint32_t lastMillis;
+  static bool recording;
+
+  static void push(RecordType type, uint16_t delta, uint8_t data);
+  static void add(RecordType type, uint8_t data);
+
+public:
+  // Clears the buffer; unixTime is the RTC time right now
+  static void start(uint32_t unixTime);
+  static void stop();
+  static bool isRecording();
+
+  static void tick();
+  static void button(uint8_t pin, bool level);
+  static void serial(uint8_t c);
+
+  // Oldest kept event first
+  static uint8_t getCount();
+  static RecordType getEvent(uint8_t index, uint16_t &delta, uint8_t &data);
+  static uint16_t getDropped();
+
+  // RTC time at the oldest kept event, counting the ticks overwritten since start()
+  static uint32_t getBaseTime();
+};
+
+#define RECORD_START(unixTime) Recorder::start(unixTime)
+#define RECORD_TICK() Recorder::tick()
+#define RECORD_BUTTON(pin, level) Recorder::button(pin, level)
+#define RECORD_SERIAL(c) Recorder::serial(c)
+
+#else
+
+#define RECORD_START(unixTime)
+#define RECORD_TICK()
+#define RECORD_BUTTON(pin, level)
+#define RECORD_SERIAL(c)
+
+#endif // CLOCK_RECORD
+
+#endif // RECORDER_H
@@ -0,0 +1,107 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+#ifndef __AVR__
+#include <atomic>
+#endif
+
+// Single-producer, single-consumer queue for handing events from an
+// interrupt to loop() (or between two threads on the host).
+//
+// The producer only writes head and the consumer only writes tail. Both are
+// free-running 8-bit counters, masked on use; one-byte loads and stores are
+// atomic on the AVR, so neither side ever disables interrupts. Size must be
+// a power of two no larger than 128, which keeps head - tail unambiguous.
+//
+// Each index is published after the slot it covers is written (or read), so
+// the other side never sees a half-copied item. On the AVR that needs only a
+// compiler barrier; on the host, acquire/release atomics do the same job.
+template <typename T, uint8_t Size>
+class RingBuffer
+{
+  static_assert(Size >= 2 && Size <= 128 && (Size & (Size - 1)) == 0,
+                "RingBuffer size must be a power of two from 2 to 128");
+
+private:
+  static const uint8_t MASK = Size - 1;
+
+  T items[Size];
+#ifdef __AVR__
+  volatile uint8_t head;
+  volatile uint8_t tail;
+
+  static void barrier() { asm volatile("" ::: "memory"); }
+  static uint8_t load(const volatile uint8_t &index) { return index; }
+  static void store(volatile uint8_t &index, uint8_t value)
+  {
+    barrier();
+    index = value;
+  }
+  static uint8_t acquire(const volatile uint8_t &index)
+  {
+    uint8_t value = index;
+    barrier();
+    return value;
+  }
+#else
+  std::atomic<uint8_t> head;
+  std::atomic<uint8_t> tail;
+
+  static uint8_t load(const std::atomic<uint8_t> &index) { return index.load(std::memory_order_relaxed); }
+  static void store(std::atomic<uint8_t> &index, uint8_t value) { index.store(value, std::memory_order_release); }
+  static uint8_t acquire(const std::atomic<uint8_t> &index) { return index.load(std::memory_order_acquire); }
+#endif
+
+public:
+  RingBuffer() : head(0), tail(0) {}
+
+  // Producer side. False, and nothing stored, when the queue is full.
+  bool push(const T &item)
+  {
+    uint8_t h = load(head);
+    if ((uint8_t)(h - acquire(tail)) == Size)
+    {
+      return false;
+    }
+    items[h & MASK] = item;
+    store(head, h + 1);
+    return true;
+  }
+
+  // Consumer side. False when the queue is empty.
+  bool pop(T &item)
+  {
+    uint8_t t = load(tail);
+    if (acquire(head) == t)
+    {
+      return false;
+    }
+    item = items[t & MASK];
+    store(tail, t + 1);
+    return true;
+  }
+
+  // Consumer side: look at the oldest item without taking it
+  bool peek(T &item) const
+  {
+    uint8_t t = load(tail);
+    if (acquire(head) == t)
+    {
+      return false;
+    }
+    item = items[t & MASK];
+    return true;
+  }
+
+  // Consumer side: drop everything queued so far
+  void clear() { store(tail, acquire(head)); }
+
+  // Exact from the consumer; from anywhere else a snapshot that may already be stale
+  uint8_t available() const { return acquire(head) - acquire(tail); }
+  bool isEmpty() const { return available() == 0; }
+  bool isFull() const { return available() == Size; }
+  static uint8_t capacity() { return Size; }
+};
+
+#endif // RING_BUFFER_H
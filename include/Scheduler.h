@@ -0,0 +1,67 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+#define MAX_TASKS 10
+
+typedef void (*TaskCallback)(void *context);
+typedef int8_t TaskId; // -1 when no task
+
+struct Task
+{
+  const __FlashStringHelper *name;
+  TaskCallback callback;
+  void *context;
+  uint32_t nextRun; // Absolute millis() deadline
+  uint32_t period;  // 0 for one-shot tasks
+  uint16_t lateCount;
+  uint16_t maxLateness;
+  bool active;
+};
+
+// Cooperative deadline scheduler with a static task table.
+// Modules register periodic and one-shot tasks instead of keeping their own
+// "millis() - lastX > interval" checks. The earliest deadline is cached, so
+// run() is a single comparison when nothing is due and the loop can sleep
+// until getNextWakeTime(). Deadlines are on the calibrated Timebase.
+class Scheduler
+{
+private:
+  Task tasks[MAX_TASKS];
+  uint32_t nextWake;
+  uint8_t activeCount;
+  uint32_t runCount;
+
+  TaskId add(const __FlashStringHelper *name, TaskCallback callback, void *context,
+             uint32_t delay, uint32_t period);
+  void updateNextWake();
+
+public:
+  // A task that starts later than this is counted as late
+  static const uint16_t LATE_THRESHOLD = 20; // ms
+
+  Scheduler();
+
+  // Registration
+  TaskId every(const __FlashStringHelper *name, uint32_t period, TaskCallback callback, void *context = nullptr);
+  TaskId after(const __FlashStringHelper *name, uint32_t delay, TaskCallback callback, void *context = nullptr);
+  void cancel(TaskId id);
+  void restart(TaskId id);
+
+  // Run every task that is due (called every loop)
+  void run();
+
+  // Next wake time
+  bool hasTasks() const;
+  uint32_t getNextWakeTime() const;
+  uint32_t getTimeUntilNextTask() const;
+
+  // Late-task statistics
+  uint8_t getTaskCount() const;
+  const Task *getTask(uint8_t index) const;
+  uint32_t getRunCount() const;
+  void resetStats();
+};
+
+#endif // SCHEDULER_H
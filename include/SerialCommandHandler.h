@@ -3,17 +3,33 @@
 
 #include <Arduino.h>
 #include "Clock.h"
+#include "Scheduler.h"
+#include "Power.h"
+#include "Profiler.h"
+#include "Recorder.h"
+#include "TimeSync.h"
+#include "ActivityLog.h"
+#include "ClimateLog.h"
+
+// Leading EEPROM bytes (settings and alarm records) included in 'rec dump'
+#define RECORD_EEPROM_BYTES 64
 
 class SerialCommandHandler
 {
 private:
   Clock *clock;
+  Scheduler *scheduler;
+  Power *power;
+  TimeSync *timeSync;
+  ActivityLog *activityLog;
+  ClimateLog *climateLog;
 
   // Input state variables
   bool waitingForTimeInput;
   bool waitingForDateInput;
   String timeInputBuffer;
   String dateInputBuffer;
+  uint32_t lineMicros; // micros() when the current line was taken
 
   // Command processing
   void processCommand(const String &command);
@@ -29,12 +45,43 @@ private:
   // New helper methods for DRY refactoring
   void handleTimeCommand(const String &timeStr);
   void handleDateCommand(const String &dateStr);
+  void handleTimeZoneCommand(const String &zoneStr);
+  void showTimeZone();
   void handleAlarmCommand(const String &alarmCmd);
-  void handleAlarmSetCommand(const String &timeStr);
+  void handleAlarmEntryCommand(uint8_t index, const String &alarmCmd);
+  void handleAlarmSetCommand(uint8_t index, const String &timeStr);
+  void handleAlarmDaysCommand(uint8_t index, const String &daysStr);
+  void handleAlarmSnoozeCommand(const String &snoozeStr);
+  void showAlarmList();
   void handleTimerCommand(const String &timerCmd);
   void handleTimerSetCommand(const String &timeStr);
+  void handleBuzzerCommand(const String &buzzerCmd);
   void showAlarmHelp();
   void showTimerHelp();
+  void showBuzzerHelp();
+  void showTasks();
+  void showMemory();
+  void showWatchdog();
+  void printResetCause(uint8_t report);
+  void showPower();
+  void handleNightCommand(const String &nightCmd);
+  void showNight();
+  void handleSyncCommand(const String &syncCmd);
+  void showSync();
+  void showCalibration();
+  void showLog();
+  void printLogEntry(const LogEntry &entry);
+  void handleClimateCommand(const String &climateCmd);
+  void showClimate();
+  void exportClimate();
+#ifdef CLOCK_PROFILE
+  void showProfile();
+#endif
+#ifdef CLOCK_RECORD
+  void recordInput(const String &line);
+  void showRecorder();
+  void dumpRecorder();
+#endif
   
   // Parsing and validation helpers
   Time parseTimeString(const String &timeStr);
@@ -46,11 +93,12 @@ private:
 public:
   SerialCommandHandler();
 
-  void begin(Clock *clock);
+  void begin(Clock *clock, Scheduler *scheduler = nullptr, Power *power = nullptr,
+             TimeSync *timeSync = nullptr, ActivityLog *activityLog = nullptr,
+             ClimateLog *climateLog = nullptr);
   void update();
   void handleSerialInput();
-  String formatTime(int hour, int minute, int second);
-  String formatDate(int day, int month, int year);
+  void execute(const String &line); // One input line, as if typed
 };
 
 #endif // SERIAL_COMMAND_HANDLER_H
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <Arduino.h>
+#include "Clock.h"
+#include "Scheduler.h"
+
+// Sets the RTC from a host clock to well under a second.
+//
+// The host measures its offset from this board's micros() with 'sync'
+// exchanges (see SerialCommandHandler), then asks for UTC second N to be
+// written at the micros() instant its own clock reaches N. The DS1307
+// restarts its one second divider when the time is written, so from then
+// on its second edges line up with the host's. The write is made by a
+// one-shot task that wakes a little early and waits out the rest.
+class TimeSync
+{
+private:
+  Clock *clock;
+  Scheduler *scheduler;
+  TaskId task;
+  uint32_t applyAt; // micros()
+  EpochTime applyTime;
+  int32_t lastLateness; // us the last write was after its instant
+  bool writeFailed;     // The last write timed out on the bus
+
+  static void onApply(void *context);
+  void apply();
+
+public:
+  // Furthest ahead an instant may be, well inside the micros() wrap
+  static const uint32_t MAX_LEAD = 10000000UL; // us
+  // The task runs this early; the rest is a busy wait
+  static const uint8_t WAKE_EARLY = 3; // ms
+
+  TimeSync();
+
+  void begin(Clock *clock, Scheduler *scheduler);
+
+  // Writes time to the RTC at micros() == at; false if that has passed or
+  // is too far ahead. Replaces a write still pending.
+  bool schedule(uint32_t at, EpochTime time);
+  void cancel();
+  bool isPending() const;
+  int32_t getLastLateness() const;
+  bool hasWriteFailed() const;
+};
+
+#endif // TIME_SYNC_H
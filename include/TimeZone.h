@@ -0,0 +1,76 @@
+#ifndef TIME_ZONE_H
+#define TIME_ZONE_H
+
+#include <Arduino.h>
+#include "Epoch.h"
+
+// When daylight saving time starts or ends: the given weekday of a week of
+// the month, at an hour of the local time in force before the change. The
+// same as "Mm.w.d/h" in a POSIX TZ string.
+struct DstRule
+{
+  uint8_t month;     // 1-12, 0 for a zone without DST
+  uint8_t week;      // 1-4, 5 = last
+  uint8_t dayOfWeek; // 0 = Sunday
+  uint8_t hour;
+};
+
+// One entry of the zone table (PROGMEM)
+struct TimeZoneRule
+{
+  char name[12];
+  int16_t offset; // Standard time, minutes east of UTC
+  uint8_t save;   // Minutes added while DST is in force
+  DstRule start;
+  DstRule end;
+};
+
+// The RTC keeps UTC; this maps it to the wall clock of the selected zone.
+// The offset in force and the period it holds for are cached, so until the
+// next DST change toLocal() is one comparison and one add. Crossing a
+// change, or a jump of the clock, works out the new period from the rules.
+// The rules are the current ones, applied to every year from 2000 to 2099.
+class TimeZone
+{
+private:
+  uint8_t zone;
+
+  // Offset in force for [periodStart, periodStart + periodLength)
+  mutable EpochTime periodStart;
+  mutable uint32_t periodLength;
+  mutable int32_t offset; // s
+
+  void getRule(TimeZoneRule &rule) const;
+  void findPeriod(EpochTime utc) const;
+  static EpochTime changeTime(const DstRule &change, uint16_t year, int32_t offsetBefore);
+
+public:
+  static const uint8_t COUNT;
+
+  TimeZone();
+
+  // Zone index in the table; false if out of range
+  bool select(uint8_t zone);
+  uint8_t getSelected() const;
+  static const __FlashStringHelper *getName(uint8_t zone);
+
+  EpochTime toLocal(EpochTime utc) const
+  {
+    // Unsigned, so instants before the period also fail the test
+    if (utc - periodStart >= periodLength)
+    {
+      findPeriod(utc);
+    }
+    return utc + offset;
+  }
+
+  // Local times skipped by the change to DST map to the instant the same
+  // distance after it; repeated ones map to their second occurrence
+  EpochTime toUtc(EpochTime local) const;
+
+  int32_t getOffset(EpochTime utc) const; // s east of UTC
+  bool isDst(EpochTime utc) const;
+  EpochTime getNextChange(EpochTime utc) const; // 0 without DST
+};
+
+#endif // TIME_ZONE_H
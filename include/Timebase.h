@@ -0,0 +1,40 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <Arduino.h>
+
+// millis() corrected for the resonator's frequency error.
+//
+// The Nano's ceramic resonator can be thousands of ppm off, so a countdown
+// timed by millis() runs fast or slow against the RTC. Calibration measures
+// the error against the DS1307's second edges and sets it here; the
+// corrected count then keeps RTC seconds while staying monotonic and
+// continuous when the correction changes. Anything timing a duration for
+// the user (Scheduler, Timer, Button, Alarm, Buzzer) reads it instead of
+// millis(). Not for interrupt handlers: the state is updated unguarded.
+class Timebase
+{
+private:
+  static int16_t ppm;      // How fast millis() runs, parts per million
+  static int32_t slowdown; // ppm of the raw count to take out
+  static uint32_t lastRaw; // millis() at the last read
+  static uint32_t behind;  // ms taken out so far
+  static int32_t residue;  // Millionths of a ms not yet taken out
+
+public:
+  // Largest error accepted; further off is not a working resonator
+  static const int16_t MAX_PPM = 20000;
+
+  static uint32_t millis();
+
+  // A duration in true ms as counted by the board's clock, and back. For
+  // hardware timers and raw micros() deadlines.
+  static uint32_t toRaw(uint32_t ms);
+  static uint32_t fromRaw(uint32_t ms);
+
+  // Clamped to +/-MAX_PPM. Applies from now on; the count does not jump.
+  static void setCorrection(int16_t ppm);
+  static int16_t getCorrection();
+};
+
+#endif // TIMEBASE_H
@@ -2,6 +2,8 @@
 #define TIMER_H
 
 #include <Arduino.h>
+#include "Scheduler.h"
+#include "Epoch.h"
 
 struct TimerData {
   uint8_t hour;
@@ -11,16 +13,33 @@ struct TimerData {
   bool completed;
 };
 
+// Countdown timer driven by an absolute millis() deadline, on the
+// calibrated Timebase so an hour is an hour of the RTC.
+// The remaining time is derived from the deadline on demand, so loop latency
+// never accumulates as drift. Unsigned arithmetic keeps it correct across the
+// 49-day millis() rollover. With a scheduler, completion is a one-shot task
+// at the deadline instead of a per-loop check.
 class Timer {
 private:
-  TimerData data;
-  unsigned long lastUpdate;
+  uint32_t duration;  // Configured countdown length in ms
+  uint32_t elapsed;   // Time consumed by previous run segments (pause/resume)
+  uint32_t startTime; // millis() when the current run segment started
+  uint32_t endTime;   // Absolute millis() deadline while running
+  bool running;
+  bool completed;
+  Scheduler *scheduler;
+  TaskId deadlineTask;
+
+  void setDuration(uint32_t durationMs);
+  void scheduleDeadline();
+  void cancelDeadline();
+  static void deadlineReached(void *timer);
 
 public:
   Timer();
   
   // Initialization
-  void begin();
+  void begin(Scheduler *scheduler = nullptr);
   
   // Timer control
   void start();
@@ -30,22 +49,17 @@ public:
   
   // Timer setting
   void setTime(uint8_t hour, uint8_t minute, uint8_t second);
-  void adjustHour();
-  void adjustMinute();
-  void adjustSecond();
   
   // Status queries
   bool isRunning() const;
   bool isCompleted() const;
+  uint32_t getRemainingMillis() const;
   
-  // Getters
+  // Getters (remaining time, rounded up to whole seconds)
   uint8_t getHour() const;
   uint8_t getMinute() const;
   uint8_t getSecond() const;
   TimerData getTime() const;
-  
-  // String representation
-  char* getTimeString() const;
 };
 
-#endif // TIMER_H 
\ No newline at end of file
+#endif // TIMER_H
@@ -0,0 +1,172 @@
+#ifndef USER_INTERFACE_H
+#define USER_INTERFACE_H
+
+#include <Arduino.h>
+#include "Clock.h"
+#include "Display.h"
+#include "Scheduler.h"
+#include "Events.h"
+
+#define UI_BUTTONS 4
+
+// UI states. DISPLAY and SETTINGS are composite: they hold the transitions
+// their children share and are never current themselves.
+enum UiState : uint8_t
+{
+  UI_DISPLAY,
+  UI_SHOW_TIME,
+  UI_SHOW_DATE,
+  UI_SHOW_CLIMATE, // Temperature and humidity in turn
+  UI_SHOW_ALARM,   // Next alarm
+  UI_SHOW_TIMER,
+  UI_SETTINGS,
+  UI_SET_TIME, // One page per SETTING_*, in the same order
+  UI_SET_DATE,
+  UI_SET_ALARM_1,
+  UI_SET_ALARM_2,
+  UI_SET_ALARM_3,
+  UI_SET_ALARM_4,
+  UI_SET_TIMER,
+  UI_STATE_COUNT,
+  UI_NO_STATE = 0xFF
+};
+
+// Events the UI reacts to. Button events come in groups of UI_BUTTONS, in
+// ButtonAction order, so a ButtonEvent maps to action * UI_BUTTONS + button.
+enum UiEvent : uint8_t
+{
+  UI_PRESS_1, // BUTTON_DOWN
+  UI_PRESS_2,
+  UI_PRESS_3,
+  UI_PRESS_4,
+  UI_CLICK_1, // BUTTON_SINGLE
+  UI_CLICK_2,
+  UI_CLICK_3,
+  UI_CLICK_4,
+  UI_LONG_1, // BUTTON_LONG
+  UI_LONG_2,
+  UI_LONG_3,
+  UI_LONG_4,
+  UI_RELEASE_1, // BUTTON_UP
+  UI_RELEASE_2,
+  UI_RELEASE_3,
+  UI_RELEASE_4,
+  UI_SECOND,  // RTC second tick
+  UI_DOT,     // Every DOT_INTERVAL
+  UI_CLIMATE, // Every CLIMATE_INTERVAL
+  UI_BLINK,   // Every BLINK_INTERVAL, in settings only
+  UI_TIMEOUT,      // SETTINGS_MODE_TIMEOUT without a button press in settings
+  UI_WRITE_FAILED, // Raised by commitSettings when the RTC did not take the time
+  UI_EVENT_COUNT,
+  UI_NO_EVENT = 0xFF
+};
+
+class UserInterface;
+typedef void (*UiAction)(UserInterface *ui);
+
+// One row of the state table (PROGMEM)
+struct UiStateInfo
+{
+  uint8_t parent; // UI_NO_STATE at the top
+  UiAction entry;
+  UiAction exit;
+  UiAction render; // Leaves only: what the display shows in this state
+};
+
+// One row of the transition table (PROGMEM). A state without a row for an
+// event passes it to its parent. target UI_NO_STATE is an internal
+// transition: the action runs and the state is neither left nor entered.
+struct UiTransition
+{
+  uint8_t state;
+  uint8_t event;
+  uint8_t target;
+  UiAction action; // Runs between the exits and the entries
+};
+
+// Display and settings modes as a hierarchical state machine. Everything
+// the UI does is a table row: the display is printed on entry to a state
+// and on the events that change what it shows, never from loop().
+class UserInterface
+{
+private:
+  Display *display;
+  Clock *clock;
+  Scheduler *scheduler;
+  const uint8_t *buttonPins;
+
+  uint8_t state;
+  bool dotOn;
+  bool showTemperature;
+  bool blinkOn;
+  TaskId blinkTaskId;
+  TaskId timeoutTaskId;
+  uint8_t raised; // Event an action raised, dispatched after its transition
+
+  static const UiStateInfo states[UI_STATE_COUNT];
+  static const UiTransition transitions[];
+  static const uint8_t transitionCount;
+
+  static const uint16_t DOT_INTERVAL = 500;            // ms
+  static const uint16_t CLIMATE_INTERVAL = 3000;       // ms
+  static const uint8_t BLINK_INTERVAL = 50;            // ms
+  static const uint16_t SETTINGS_MODE_TIMEOUT = 30000; // ms
+
+  void transition(uint8_t target, UiAction action);
+  bool contains(uint8_t outer, uint8_t inner) const;
+  static UiStateInfo readState(uint8_t state);
+  int8_t buttonIndex(uint8_t pin) const;
+
+  // Scheduled events
+  static void dotTask(void *ui);
+  static void climateTask(void *ui);
+  static void blinkTask(void *ui);
+  static void timeoutTask(void *ui);
+
+  // Table actions
+  static void render(UserInterface *ui);
+  static void renderTime(UserInterface *ui);
+  static void renderDate(UserInterface *ui);
+  static void renderClimate(UserInterface *ui);
+  static void renderAlarm(UserInterface *ui);
+  static void renderTimer(UserInterface *ui);
+  static void renderSetting(UserInterface *ui);
+  static void toggleDot(UserInterface *ui);
+  static void hideDot(UserInterface *ui);
+  static void toggleClimate(UserInterface *ui);
+  static void openSettings(UserInterface *ui);
+  static void closeSettings(UserInterface *ui);
+  static void commitSettings(UserInterface *ui);
+  static void cancelSettings(UserInterface *ui);
+  static void restartBlink(UserInterface *ui);
+  static void toggleBlink(UserInterface *ui);
+  static void adjustFirst(UserInterface *ui);
+  static void adjustSecond(UserInterface *ui);
+  static void adjustThird(UserInterface *ui);
+
+public:
+  UserInterface();
+
+  // buttonPins holds UI_BUTTONS pins, button 1 first
+  void begin(Display *display, Clock *clock, Scheduler *scheduler, const uint8_t *buttonPins);
+
+  // Feed an event; the current state or its nearest ancestor with a row
+  // for it handles it, otherwise it is ignored
+  void dispatch(uint8_t event);
+
+  // Button events go through the alarm first: a ringing or snoozed alarm
+  // takes the clicks, and the UI only sees the release. Any button holds
+  // off the settings timeout.
+  void handleButton(const ButtonEvent &event);
+
+  uint8_t getState() const;
+  bool isInSettings() const;
+
+  // Table access, for tests and diagnostics
+  static uint8_t getParent(uint8_t state);
+  static bool isLeaf(uint8_t state);
+  static uint8_t getTransitionCount();
+  static UiTransition getTransition(uint8_t index);
+};
+
+#endif // USER_INTERFACE_H
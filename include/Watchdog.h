@@ -0,0 +1,77 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <Arduino.h>
+#include "Profiler.h"
+
+// Reset flags, as in MCUSR
+enum ResetFlag
+{
+  RESET_POWER_ON = 0x01,
+  RESET_EXTERNAL = 0x02, // Reset pin, including the upload reset
+  RESET_BROWN_OUT = 0x04,
+  RESET_WATCHDOG = 0x08,
+};
+
+// Stages besides the LoopStage values: setup() before the first pass, and
+// a watchdog reset that left no record (interrupts were off)
+#define WATCHDOG_SETUP STAGE_COUNT
+#define WATCHDOG_UNKNOWN 0x0F
+
+// Interrupt after this long without feed(), reset after twice that
+#define WATCHDOG_TIMEOUT 2000 // ms
+
+// Resets the board when the loop stops coming round, and tells which stage
+// it was stuck in.
+//
+// The WDT runs in interrupt-then-reset mode. When a pass misses the
+// deadline, the interrupt stores the stage the loop was in to RAM that
+// the startup code leaves alone (.noinit); if the loop still has not fed
+// the watchdog one timeout later, the WDT resets the board. The next
+// begin() finds the record next to the watchdog reset flag and hands it to
+// the activity log with the power-up, which keeps it in EEPROM. A pass
+// that was late but made it back is only counted.
+//
+// Build with -D CLOCK_NO_WATCHDOG for boards whose bootloader leaves the
+// WDT running after a reset (the Nano's old one), as they would reset over
+// and over.
+class Watchdog
+{
+private:
+  static volatile uint8_t stage;
+  static volatile bool fired; // Interrupt taken, no feed since
+  static uint8_t resetFlags;
+  static uint8_t stalledStage;
+  static uint16_t lateCount;
+
+public:
+  // MCUSR as the startup code found it, before clearing it
+  static uint8_t readResetFlags();
+
+  // Takes the stall record a watchdog reset left, then starts the WDT
+  static void begin(uint8_t resetFlags);
+
+  // Once per pass, and in loops that take long on purpose
+  static void feed();
+
+  // Where the loop is; kept for the interrupt
+  static void enter(uint8_t stage)
+  {
+    Watchdog::stage = stage;
+  }
+
+  // The WDT interrupt
+  static void onTimeout();
+
+  static uint8_t getResetFlags();
+  static uint8_t getStalledStage(); // After a watchdog reset
+  static uint16_t getLateCount();   // Passes over WATCHDOG_TIMEOUT since boot
+
+  // For the power-up record: ResetFlag bits, and the stalled stage in the
+  // high nibble after a watchdog reset
+  static uint8_t getResetReport();
+
+  static const __FlashStringHelper *getStageName(uint8_t stage);
+};
+
+#endif // WATCHDOG_H
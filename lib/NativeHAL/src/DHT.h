@@ -0,0 +1,23 @@
+#ifndef NATIVE_HAL_DHT_H
+#define NATIVE_HAL_DHT_H
+
+#include <stdint.h>
+
+#define DHT11 11
+#define DHT22 22
+
+// DHT sensor returning the values set with halSetDht()
+class DHT
+{
+private:
+  uint8_t pin;
+  uint8_t type;
+
+public:
+  DHT(uint8_t pin, uint8_t type, uint8_t count = 6);
+  void begin(uint8_t usec = 55);
+  float readTemperature(bool fahrenheit = false, bool force = false);
+  float readHumidity(bool force = false);
+};
+
+#endif // NATIVE_HAL_DHT_H
@@ -0,0 +1,41 @@
+#ifndef NATIVE_HAL_EEPROM_H
+#define NATIVE_HAL_EEPROM_H
+
+#include <stdint.h>
+
+// 1 KB of EEPROM like the ATmega328P, erased to 0xFF
+class EEPROMClass
+{
+public:
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  void update(int address, uint8_t value);
+  uint16_t length();
+
+  template <typename T>
+  T &get(int address, T &value)
+  {
+    uint8_t *bytes = (uint8_t *)&value;
+    for (unsigned int i = 0; i < sizeof(T); i++)
+    {
+      bytes[i] = read(address + i);
+    }
+    return value;
+  }
+
+  // Like the AVR library, only cells that differ are written
+  template <typename T>
+  const T &put(int address, const T &value)
+  {
+    const uint8_t *bytes = (const uint8_t *)&value;
+    for (unsigned int i = 0; i < sizeof(T); i++)
+    {
+      update(address + i, bytes[i]);
+    }
+    return value;
+  }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // NATIVE_HAL_EEPROM_H
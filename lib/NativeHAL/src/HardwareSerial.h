@@ -0,0 +1,28 @@
+#ifndef NATIVE_HAL_HARDWARE_SERIAL_H
+#define NATIVE_HAL_HARDWARE_SERIAL_H
+
+#include "Print.h"
+#include "WString.h"
+
+// Serial port backed by in-memory queues; tests feed input and read the
+// output through NativeHAL.h
+class HardwareSerial : public Print
+{
+public:
+  void begin(unsigned long baud);
+  void end();
+  int available();
+  int peek();
+  int read();
+  void flush();
+  void setTimeout(unsigned long timeout);
+  String readString();
+  String readStringUntil(char terminator);
+  size_t write(uint8_t c) override;
+  using Print::write;
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // NATIVE_HAL_HARDWARE_SERIAL_H
@@ -0,0 +1,648 @@
+#include "Arduino.h"
+#include "NativeHAL.h"
+#include "EEPROM.h"
+#include "Wire.h"
+#include "DHT.h"
+#include <deque>
+#include <string>
+
+// Virtual microsecond clock; millis() and micros() are 32-bit views of it
+// like on the AVR core, the RTC runs from the full 64-bit value
+static uint64_t halClock = 0;
+
+// GPIO
+static uint8_t pinModes[NUM_DIGITAL_PINS];
+static uint8_t pinOutputs[NUM_DIGITAL_PINS];
+static uint8_t pinInputs[NUM_DIGITAL_PINS];
+static uint8_t shiftOutputs[NUM_DIGITAL_PINS];
+static unsigned int tones[NUM_DIGITAL_PINS];
+static void (*shiftOutHook)(uint8_t, uint8_t) = nullptr;
+
+// Interrupts
+static void (*interruptHandlers[2])() = {nullptr, nullptr};
+
+// Serial
+static std::deque<char> serialInput;
+static std::string serialOutput;
+
+// EEPROM
+static const uint16_t EEPROM_SIZE = 1024;
+static uint8_t eeprom[EEPROM_SIZE];
+static uint32_t eepromWrites = 0;
+
+// RTC; writing the time restarts its one second divider, like the DS1307
+static const uint32_t RTC_POWER_ON_TIME = 1704067200UL; // 2024-01-01 00:00:00
+static uint32_t rtcBaseTime = RTC_POWER_ON_TIME;
+static uint64_t rtcBaseClock = 0;
+static uint32_t rtcSecond = 1000000; // Board us per RTC second
+static bool rtcPresent = true;
+static bool rtcRunning = true;
+static bool rtcManualTicks = false;
+static uint8_t rtcSqwMode = 0;
+static uint8_t rtcSqwInterrupt = 0;
+static const uint8_t SQW_1HZ = 0x10;
+
+// DHT
+static float dhtTemperature = 21.0f;
+static float dhtHumidity = 45.0f;
+
+// I2C
+static uint32_t i2cTransactions = 0;
+static uint8_t i2cHang = 0;
+static uint32_t wireTimeout = 0;
+static bool wireTimeoutFlag = false;
+
+// Start from the power-on state without tests having to ask for it
+static struct PowerOn
+{
+  PowerOn() { halReset(); }
+} powerOn;
+
+static uint32_t rtcTimeAt(uint64_t clock)
+{
+  if (!rtcRunning || rtcManualTicks)
+  {
+    return rtcBaseTime;
+  }
+  return rtcBaseTime + (uint32_t)((clock - rtcBaseClock) / rtcSecond);
+}
+
+static void advanceClock(uint64_t us)
+{
+  uint64_t end = halClock + us;
+
+  // The square wave falls as each second starts. The handler runs with the
+  // clock at its edge, so micros() there is the edge time.
+  void (*handler)() = interruptHandlers[rtcSqwInterrupt];
+  if (rtcSqwMode == SQW_1HZ && handler)
+  {
+    uint32_t second = rtcTimeAt(halClock);
+    uint32_t after = rtcTimeAt(end);
+    while (second != after)
+    {
+      second++;
+      halClock = rtcBaseClock + (uint64_t)(second - rtcBaseTime) * rtcSecond;
+      handler();
+    }
+  }
+  halClock = end;
+}
+
+void halReset()
+{
+  halClock = 0;
+  for (uint8_t i = 0; i < NUM_DIGITAL_PINS; i++)
+  {
+    pinModes[i] = INPUT;
+    pinOutputs[i] = LOW;
+    pinInputs[i] = LOW;
+    shiftOutputs[i] = 0;
+    tones[i] = 0;
+  }
+  shiftOutHook = nullptr;
+  interruptHandlers[0] = interruptHandlers[1] = nullptr;
+  serialInput.clear();
+  serialOutput.clear();
+  halEepromErase();
+  rtcBaseTime = RTC_POWER_ON_TIME;
+  rtcBaseClock = 0;
+  rtcSecond = 1000000;
+  rtcPresent = true;
+  rtcRunning = true;
+  rtcManualTicks = false;
+  rtcSqwMode = 0;
+  rtcSqwInterrupt = 0;
+  dhtTemperature = 21.0f;
+  dhtHumidity = 45.0f;
+  i2cTransactions = 0;
+  i2cHang = 0;
+  wireTimeout = 0;
+  wireTimeoutFlag = false;
+}
+
+// Time
+
+unsigned long millis()
+{
+  return (uint32_t)(halClock / 1000ULL);
+}
+
+unsigned long micros()
+{
+  return (uint32_t)halClock;
+}
+
+void delay(unsigned long ms)
+{
+  advanceClock(ms * 1000ULL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  advanceClock(us);
+}
+
+void halSetMillis(uint32_t ms)
+{
+  // Keep the RTC where it was; only the millis() counter jumps
+  uint32_t rtcTime = rtcTimeAt(halClock);
+  halClock = ms * 1000ULL;
+  rtcBaseTime = rtcTime;
+  rtcBaseClock = halClock;
+}
+
+void halAdvanceMillis(uint32_t ms)
+{
+  advanceClock(ms * 1000ULL);
+}
+
+void halAdvanceMicros(uint32_t us)
+{
+  advanceClock(us);
+}
+
+// GPIO
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if (pin == PIN_WIRE_SCL && pinModes[pin] == OUTPUT && pinOutputs[pin] == LOW && mode != OUTPUT && i2cHang)
+  {
+    i2cHang--; // SCL released: one clock pulse for the hung device
+  }
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    pinModes[pin] = mode;
+    if (mode == INPUT_PULLUP)
+    {
+      pinInputs[pin] = HIGH;
+    }
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    pinOutputs[pin] = value ? HIGH : LOW;
+  }
+}
+
+int digitalRead(uint8_t pin)
+{
+  if (pin >= NUM_DIGITAL_PINS)
+  {
+    return LOW;
+  }
+  if (pin == PIN_WIRE_SDA && pinModes[pin] != OUTPUT && i2cHang)
+  {
+    return LOW;
+  }
+  return pinModes[pin] == OUTPUT ? pinOutputs[pin] : pinInputs[pin];
+}
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value)
+{
+  (void)clockPin;
+  if (bitOrder == LSBFIRST)
+  {
+    // Store in MSB-first order so tests see what the register holds
+    uint8_t reversed = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+      reversed |= ((value >> i) & 1) << (7 - i);
+    }
+    value = reversed;
+  }
+  if (dataPin < NUM_DIGITAL_PINS)
+  {
+    shiftOutputs[dataPin] = value;
+  }
+  if (shiftOutHook)
+  {
+    shiftOutHook(dataPin, value);
+  }
+}
+
+void halSetPin(uint8_t pin, uint8_t level)
+{
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    pinInputs[pin] = level ? HIGH : LOW;
+  }
+}
+
+uint8_t halGetPin(uint8_t pin)
+{
+  return pin < NUM_DIGITAL_PINS ? pinOutputs[pin] : LOW;
+}
+
+uint8_t halGetPinMode(uint8_t pin)
+{
+  return pin < NUM_DIGITAL_PINS ? pinModes[pin] : INPUT;
+}
+
+uint8_t halGetShiftOut(uint8_t dataPin)
+{
+  return dataPin < NUM_DIGITAL_PINS ? shiftOutputs[dataPin] : 0;
+}
+
+void halOnShiftOut(void (*hook)(uint8_t dataPin, uint8_t value))
+{
+  shiftOutHook = hook;
+}
+
+// Tone
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration)
+{
+  (void)duration;
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    tones[pin] = frequency;
+  }
+}
+
+void noTone(uint8_t pin)
+{
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    tones[pin] = 0;
+  }
+}
+
+unsigned int halGetTone(uint8_t pin)
+{
+  return pin < NUM_DIGITAL_PINS ? tones[pin] : 0;
+}
+
+// Interrupts
+
+void attachInterrupt(uint8_t interruptNumber, void (*callback)(), int mode)
+{
+  (void)mode;
+  if (interruptNumber < 2)
+  {
+    interruptHandlers[interruptNumber] = callback;
+  }
+}
+
+void detachInterrupt(uint8_t interruptNumber)
+{
+  if (interruptNumber < 2)
+  {
+    interruptHandlers[interruptNumber] = nullptr;
+  }
+}
+
+// Serial
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long baud)
+{
+  (void)baud;
+}
+
+void HardwareSerial::end()
+{
+}
+
+int HardwareSerial::available()
+{
+  return serialInput.size();
+}
+
+int HardwareSerial::peek()
+{
+  return serialInput.empty() ? -1 : (uint8_t)serialInput.front();
+}
+
+int HardwareSerial::read()
+{
+  if (serialInput.empty())
+  {
+    return -1;
+  }
+  uint8_t c = serialInput.front();
+  serialInput.pop_front();
+  return c;
+}
+
+void HardwareSerial::flush()
+{
+}
+
+void HardwareSerial::setTimeout(unsigned long timeout)
+{
+  (void)timeout;
+}
+
+String HardwareSerial::readString()
+{
+  String result;
+  while (!serialInput.empty())
+  {
+    result += (char)read();
+  }
+  return result;
+}
+
+// Input is all there is, so this returns at once instead of timing out
+String HardwareSerial::readStringUntil(char terminator)
+{
+  String result;
+  while (!serialInput.empty())
+  {
+    char c = (char)read();
+    if (c == terminator)
+    {
+      break;
+    }
+    result += c;
+  }
+  return result;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  serialOutput += (char)c;
+  return 1;
+}
+
+void halSerialInput(const char *text)
+{
+  while (*text)
+  {
+    serialInput.push_back(*text++);
+  }
+}
+
+const char *halSerialOutput()
+{
+  return serialOutput.c_str();
+}
+
+void halSerialClear()
+{
+  serialOutput.clear();
+}
+
+// EEPROM
+
+EEPROMClass EEPROM;
+
+uint8_t EEPROMClass::read(int address)
+{
+  return address >= 0 && address < EEPROM_SIZE ? eeprom[address] : 0xFF;
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+  if (address >= 0 && address < EEPROM_SIZE)
+  {
+    eeprom[address] = value;
+    eepromWrites++;
+  }
+}
+
+void EEPROMClass::update(int address, uint8_t value)
+{
+  if (read(address) != value)
+  {
+    write(address, value);
+  }
+}
+
+uint16_t EEPROMClass::length()
+{
+  return EEPROM_SIZE;
+}
+
+uint8_t *halEeprom()
+{
+  return eeprom;
+}
+
+uint32_t halEepromWrites()
+{
+  return eepromWrites;
+}
+
+void halEepromErase()
+{
+  memset(eeprom, 0xFF, sizeof(eeprom));
+  eepromWrites = 0;
+}
+
+// I2C
+
+TwoWire Wire;
+
+void TwoWire::begin()
+{
+}
+
+void TwoWire::end()
+{
+}
+
+void TwoWire::setClock(uint32_t frequency)
+{
+  (void)frequency;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+  (void)address;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+  (void)sendStop;
+  i2cTransactions++;
+  if (i2cHang && wireTimeout)
+  {
+    wireTimeoutFlag = true;
+    return 5; // Timeout, as the AVR Wire reports it
+  }
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop)
+{
+  (void)address;
+  (void)quantity;
+  (void)sendStop;
+  i2cTransactions++;
+  if (i2cHang && wireTimeout)
+  {
+    wireTimeoutFlag = true;
+  }
+  return 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+  (void)data;
+  return 1;
+}
+
+int TwoWire::available()
+{
+  return 0;
+}
+
+int TwoWire::read()
+{
+  return -1;
+}
+
+void TwoWire::setWireTimeout(uint32_t timeout, bool resetWithTimeout)
+{
+  (void)resetWithTimeout;
+  wireTimeout = timeout;
+}
+
+bool TwoWire::getWireTimeoutFlag()
+{
+  return wireTimeoutFlag;
+}
+
+void TwoWire::clearWireTimeoutFlag()
+{
+  wireTimeoutFlag = false;
+}
+
+uint32_t halI2cTransactions()
+{
+  return i2cTransactions;
+}
+
+void halSetI2cHang(uint8_t clocks)
+{
+  i2cHang = clocks;
+}
+
+uint8_t halI2cHang()
+{
+  return i2cHang;
+}
+
+// RTC
+
+void halSetRtc(uint32_t unixTime)
+{
+  rtcBaseTime = unixTime;
+  rtcBaseClock = halClock;
+  rtcRunning = true;
+}
+
+uint32_t halGetRtc()
+{
+  return rtcTimeAt(halClock);
+}
+
+void halSetClockError(int32_t ppm)
+{
+  // From the start of the current second, so no edge moves
+  if (rtcRunning && !rtcManualTicks)
+  {
+    uint32_t second = rtcTimeAt(halClock);
+    rtcBaseClock += (uint64_t)(second - rtcBaseTime) * rtcSecond;
+    rtcBaseTime = second;
+  }
+  rtcSecond = 1000000 + ppm;
+}
+
+void halSetRtcPresent(bool present)
+{
+  rtcPresent = present;
+}
+
+bool halRtcPresent()
+{
+  return rtcPresent;
+}
+
+bool halRtcRunning()
+{
+  return rtcRunning;
+}
+
+void halStopRtc()
+{
+  rtcBaseTime = rtcTimeAt(halClock);
+  rtcRunning = false;
+}
+
+void halSetRtcManualTicks(bool manual)
+{
+  rtcBaseTime = rtcTimeAt(halClock);
+  rtcBaseClock = halClock;
+  rtcManualTicks = manual;
+}
+
+void halRtcTick()
+{
+  rtcBaseTime++;
+  void (*handler)() = interruptHandlers[rtcSqwInterrupt];
+  if (rtcSqwMode == SQW_1HZ && handler)
+  {
+    handler();
+  }
+}
+
+void halSetRtcSqwMode(uint8_t mode)
+{
+  rtcSqwMode = mode;
+}
+
+uint8_t halGetRtcSqwMode()
+{
+  return rtcSqwMode;
+}
+
+void halSetRtcSqwInterrupt(uint8_t interruptNumber)
+{
+  rtcSqwInterrupt = interruptNumber < 2 ? interruptNumber : 0;
+}
+
+// DHT
+
+DHT::DHT(uint8_t pin, uint8_t type, uint8_t count) : pin(pin), type(type)
+{
+  (void)count;
+}
+
+void DHT::begin(uint8_t usec)
+{
+  (void)usec;
+}
+
+float DHT::readTemperature(bool fahrenheit, bool force)
+{
+  (void)force;
+  return fahrenheit ? dhtTemperature * 1.8f + 32 : dhtTemperature;
+}
+
+float DHT::readHumidity(bool force)
+{
+  (void)force;
+  return dhtHumidity;
+}
+
+void halSetDht(float temperature, float humidity)
+{
+  dhtTemperature = temperature;
+  dhtHumidity = humidity;
+}
+
+float halGetDhtTemperature()
+{
+  return dhtTemperature;
+}
+
+float halGetDhtHumidity()
+{
+  return dhtHumidity;
+}
@@ -0,0 +1,67 @@
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+#include <stdint.h>
+
+// Test-side control of the simulated hardware
+
+// Power-on state: time 0, pins low, EEPROM erased, RTC running at
+// 2024-01-01 00:00:00, DHT reading 21 C / 45 %, serial queues empty
+void halReset();
+
+// Virtual time; advancing it also runs the RTC and its square wave
+void halSetMillis(uint32_t ms);
+void halAdvanceMillis(uint32_t ms);
+void halAdvanceMicros(uint32_t us);
+
+// GPIO
+void halSetPin(uint8_t pin, uint8_t level); // Drive an input pin
+uint8_t halGetPin(uint8_t pin);             // Level written by the firmware
+uint8_t halGetPinMode(uint8_t pin);
+uint8_t halGetShiftOut(uint8_t dataPin); // Last byte shifted out
+void halOnShiftOut(void (*hook)(uint8_t dataPin, uint8_t value));
+unsigned int halGetTone(uint8_t pin); // 0 when silent
+
+// Serial
+void halSerialInput(const char *text);
+const char *halSerialOutput();
+void halSerialClear();
+
+// EEPROM
+uint8_t *halEeprom();
+uint32_t halEepromWrites(); // Cells actually rewritten
+void halEepromErase();
+
+// RTC (DS1307)
+void halSetRtc(uint32_t unixTime);
+uint32_t halGetRtc();
+// The board's resonator runs ppm fast (negative: slow) against the RTC:
+// each RTC second then lasts 1000000 + ppm us of micros()
+void halSetClockError(int32_t ppm);
+void halSetRtcPresent(bool present);
+bool halRtcPresent();
+bool halRtcRunning();
+// Oscillator stopped, as after the backup battery ran out; halSetRtc() or
+// the firmware's next write starts it again
+void halStopRtc();
+// Manual ticks stop the RTC following virtual time; each halRtcTick() then
+// advances it one second and fires the square wave (trace replay)
+void halSetRtcManualTicks(bool manual);
+void halRtcTick();
+void halSetRtcSqwMode(uint8_t mode);
+uint8_t halGetRtcSqwMode();
+void halSetRtcSqwInterrupt(uint8_t interruptNumber); // Default INT0 (D2)
+
+// DHT
+void halSetDht(float temperature, float humidity);
+float halGetDhtTemperature();
+float halGetDhtHumidity();
+
+// I2C
+uint32_t halI2cTransactions();
+// A device holds SDA (A4) low until it sees this many SCL (A5) pulses;
+// until then transfers time out, if a Wire timeout is set
+void halSetI2cHang(uint8_t clocks);
+uint8_t halI2cHang();
+
+#endif // NATIVE_HAL_H
@@ -0,0 +1,185 @@
+#include "Print.h"
+#include <math.h>
+#include <string.h>
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--)
+  {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::write(const char *str)
+{
+  return str ? write((const uint8_t *)str, strlen(str)) : 0;
+}
+
+size_t Print::printNumber(unsigned long value, uint8_t base)
+{
+  char digits[8 * sizeof(unsigned long) + 1];
+  char *p = &digits[sizeof(digits) - 1];
+  *p = '\0';
+  if (base < 2)
+  {
+    base = 10;
+  }
+  do
+  {
+    unsigned long digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value);
+  return write(p);
+}
+
+size_t Print::print(const __FlashStringHelper *str)
+{
+  return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const String &str)
+{
+  return write((const uint8_t *)str.c_str(), str.length());
+}
+
+size_t Print::print(const char *str)
+{
+  return write(str);
+}
+
+size_t Print::print(char c)
+{
+  return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base)
+{
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base)
+{
+  return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base)
+{
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base)
+{
+  // The AVR core prints negative numbers in other bases as two's complement
+  // of a 32-bit long; only decimal gets a sign
+  if (base == 10 && value < 0)
+  {
+    return write('-') + printNumber((unsigned long)-value, 10);
+  }
+  return printNumber(base == 10 ? (unsigned long)value : (uint32_t)value, base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+  return printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits)
+{
+  if (isnan(value))
+  {
+    return write("nan");
+  }
+  if (isinf(value))
+  {
+    return write("inf");
+  }
+
+  size_t n = 0;
+  if (value < 0.0)
+  {
+    n += write('-');
+    value = -value;
+  }
+
+  // Round the way the AVR core does, then print the parts
+  double rounding = 0.5;
+  for (int i = 0; i < digits; i++)
+  {
+    rounding /= 10.0;
+  }
+  value += rounding;
+
+  unsigned long whole = (unsigned long)value;
+  double remainder = value - (double)whole;
+  n += printNumber(whole, 10);
+  if (digits > 0)
+  {
+    n += write('.');
+  }
+  while (digits-- > 0)
+  {
+    remainder *= 10.0;
+    unsigned int digit = (unsigned int)remainder;
+    n += write((uint8_t)('0' + digit));
+    remainder -= digit;
+  }
+  return n;
+}
+
+size_t Print::println(const __FlashStringHelper *str)
+{
+  return print(str) + println();
+}
+
+size_t Print::println(const String &str)
+{
+  return print(str) + println();
+}
+
+size_t Print::println(const char *str)
+{
+  return print(str) + println();
+}
+
+size_t Print::println(char c)
+{
+  return print(c) + println();
+}
+
+size_t Print::println(unsigned char value, int base)
+{
+  return print(value, base) + println();
+}
+
+size_t Print::println(int value, int base)
+{
+  return print(value, base) + println();
+}
+
+size_t Print::println(unsigned int value, int base)
+{
+  return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base)
+{
+  return print(value, base) + println();
+}
+
+size_t Print::println(unsigned long value, int base)
+{
+  return print(value, base) + println();
+}
+
+size_t Print::println(double value, int digits)
+{
+  return print(value, digits) + println();
+}
+
+size_t Print::println()
+{
+  return write("\r\n");
+}
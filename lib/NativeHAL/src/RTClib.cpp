@@ -0,0 +1,177 @@
+#include "RTClib.h"
+#include "NativeHAL.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t DS1307_ADDRESS = 0x68;
+static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
+
+static uint16_t date2days(uint16_t y, uint8_t m, uint8_t d)
+{
+  if (y >= 2000U)
+  {
+    y -= 2000U;
+  }
+  uint16_t days = d;
+  for (uint8_t i = 1; i < m; ++i)
+  {
+    days += daysInMonth[i - 1];
+  }
+  if (m > 2 && y % 4 == 0)
+  {
+    ++days;
+  }
+  return days + 365 * y + (y + 3) / 4 - 1;
+}
+
+static uint32_t time2ulong(uint16_t days, uint8_t h, uint8_t m, uint8_t s)
+{
+  return ((days * 24UL + h) * 60 + m) * 60 + s;
+}
+
+static uint8_t conv2d(const char *p)
+{
+  uint8_t v = 0;
+  if ('0' <= *p && *p <= '9')
+  {
+    v = *p - '0';
+  }
+  return 10 * v + *++p - '0';
+}
+
+DateTime::DateTime(uint32_t t)
+{
+  t -= SECONDS_FROM_1970_TO_2000;
+  ss = t % 60;
+  t /= 60;
+  mm = t % 60;
+  t /= 60;
+  hh = t % 24;
+  uint16_t days = t / 24;
+  uint8_t leap;
+  for (yOff = 0;; ++yOff)
+  {
+    leap = yOff % 4 == 0;
+    if (days < 365U + leap)
+    {
+      break;
+    }
+    days -= 365 + leap;
+  }
+  for (m = 1; m < 12; ++m)
+  {
+    uint8_t daysPerMonth = daysInMonth[m - 1];
+    if (leap && m == 2)
+    {
+      ++daysPerMonth;
+    }
+    if (days < daysPerMonth)
+    {
+      break;
+    }
+    days -= daysPerMonth;
+  }
+  d = days + 1;
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min,
+                   uint8_t sec)
+{
+  if (year >= 2000U)
+  {
+    year -= 2000U;
+  }
+  yOff = year;
+  m = month;
+  d = day;
+  hh = hour;
+  mm = min;
+  ss = sec;
+}
+
+// "Mmm dd yyyy", "hh:mm:ss" as produced by __DATE__ and __TIME__
+DateTime::DateTime(const char *date, const char *time)
+{
+  static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+  yOff = conv2d(date + 9);
+  m = 1;
+  for (uint8_t i = 0; i < 12; i++)
+  {
+    if (strncmp(date, months + 3 * i, 3) == 0)
+    {
+      m = i + 1;
+      break;
+    }
+  }
+  d = conv2d(date + 4);
+  hh = conv2d(time);
+  mm = conv2d(time + 3);
+  ss = conv2d(time + 6);
+}
+
+DateTime::DateTime(const __FlashStringHelper *date, const __FlashStringHelper *time)
+    : DateTime(reinterpret_cast<const char *>(date), reinterpret_cast<const char *>(time))
+{
+}
+
+uint8_t DateTime::dayOfTheWeek() const
+{
+  uint16_t day = date2days(yOff, m, d);
+  return (day + 6) % 7; // Jan 1, 2000 was a Saturday
+}
+
+uint32_t DateTime::unixtime() const
+{
+  return time2ulong(date2days(yOff, m, d), hh, mm, ss) + SECONDS_FROM_1970_TO_2000;
+}
+
+uint32_t DateTime::secondstime() const
+{
+  return time2ulong(date2days(yOff, m, d), hh, mm, ss);
+}
+
+// One register access on the bus, so I2C counts match the hardware
+static void transaction()
+{
+  Wire.beginTransmission(DS1307_ADDRESS);
+  Wire.endTransmission();
+}
+
+bool RTC_DS1307::begin(TwoWire *)
+{
+  transaction();
+  return halRtcPresent();
+}
+
+uint8_t RTC_DS1307::isrunning()
+{
+  transaction();
+  return halRtcRunning();
+}
+
+void RTC_DS1307::adjust(const DateTime &dt)
+{
+  transaction();
+  if (!Wire.getWireTimeoutFlag()) // A write cut off by a hung bus never lands
+  {
+    halSetRtc(dt.unixtime());
+  }
+}
+
+DateTime RTC_DS1307::now()
+{
+  transaction();
+  return DateTime(halGetRtc());
+}
+
+Ds1307SqwPinMode RTC_DS1307::readSqwPinMode()
+{
+  transaction();
+  return (Ds1307SqwPinMode)halGetRtcSqwMode();
+}
+
+void RTC_DS1307::writeSqwPinMode(Ds1307SqwPinMode mode)
+{
+  transaction();
+  halSetRtcSqwMode(mode);
+}
@@ -0,0 +1,57 @@
+#ifndef NATIVE_HAL_RTCLIB_H
+#define NATIVE_HAL_RTCLIB_H
+
+#include <stdint.h>
+#include "Wire.h"
+
+class __FlashStringHelper;
+
+#define SECONDS_FROM_1970_TO_2000 946684800UL
+
+// Calendar conversions identical to Adafruit RTClib (valid 2000-2099)
+class DateTime
+{
+protected:
+  uint8_t yOff, m, d, hh, mm, ss;
+
+public:
+  DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
+  DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0,
+           uint8_t sec = 0);
+  DateTime(const char *date, const char *time);
+  DateTime(const __FlashStringHelper *date, const __FlashStringHelper *time);
+
+  uint16_t year() const { return 2000U + yOff; }
+  uint8_t month() const { return m; }
+  uint8_t day() const { return d; }
+  uint8_t hour() const { return hh; }
+  uint8_t minute() const { return mm; }
+  uint8_t second() const { return ss; }
+  uint8_t dayOfTheWeek() const; // 0 = Sunday
+  uint32_t unixtime() const;
+  uint32_t secondstime() const;
+};
+
+enum Ds1307SqwPinMode
+{
+  DS1307_OFF = 0x00,
+  DS1307_ON = 0x80,
+  DS1307_SquareWave1HZ = 0x10,
+  DS1307_SquareWave4kHz = 0x11,
+  DS1307_SquareWave8kHz = 0x12,
+  DS1307_SquareWave32kHz = 0x13
+};
+
+// DS1307 backed by the simulated clock in NativeHAL
+class RTC_DS1307
+{
+public:
+  bool begin(TwoWire *wire = &Wire);
+  uint8_t isrunning();
+  void adjust(const DateTime &dt);
+  DateTime now();
+  Ds1307SqwPinMode readSqwPinMode();
+  void writeSqwPinMode(Ds1307SqwPinMode mode);
+};
+
+#endif // NATIVE_HAL_RTCLIB_H
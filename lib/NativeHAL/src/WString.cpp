@@ -0,0 +1,312 @@
+#include "WString.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+String::String(const char *str) : buffer(nullptr), len(0), capacity(0)
+{
+  copy(str ? str : "", str ? strlen(str) : 0);
+}
+
+String::String(const __FlashStringHelper *str) : String(reinterpret_cast<const char *>(str))
+{
+}
+
+String::String(const String &other) : buffer(nullptr), len(0), capacity(0)
+{
+  copy(other.buffer, other.len);
+}
+
+String::String(char c) : buffer(nullptr), len(0), capacity(0)
+{
+  char str[2] = {c, '\0'};
+  copy(str, 1);
+}
+
+String::String(int value, unsigned char base) : String((long)value, base)
+{
+}
+
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base)
+{
+}
+
+String::String(long value, unsigned char base) : buffer(nullptr), len(0), capacity(0)
+{
+  if (value < 0 && base == 10)
+  {
+    String digits((unsigned long)-value, base);
+    copy("-", 1);
+    append(digits.buffer, digits.len);
+  }
+  else
+  {
+    String digits((unsigned long)value, base);
+    copy(digits.buffer, digits.len);
+  }
+}
+
+String::String(unsigned long value, unsigned char base) : buffer(nullptr), len(0), capacity(0)
+{
+  char digits[8 * sizeof(unsigned long) + 1];
+  char *p = &digits[sizeof(digits) - 1];
+  *p = '\0';
+  if (base < 2)
+  {
+    base = 10;
+  }
+  do
+  {
+    unsigned long digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value);
+  copy(p, strlen(p));
+}
+
+String::~String()
+{
+  free(buffer);
+}
+
+String &String::operator=(const String &other)
+{
+  if (this != &other)
+  {
+    copy(other.buffer, other.len);
+  }
+  return *this;
+}
+
+String &String::operator=(const char *str)
+{
+  return copy(str ? str : "", str ? strlen(str) : 0);
+}
+
+bool String::reserve(unsigned int size)
+{
+  if (buffer && capacity >= size)
+  {
+    return true;
+  }
+  char *grown = (char *)realloc(buffer, size + 1);
+  if (!grown)
+  {
+    return false;
+  }
+  if (!buffer)
+  {
+    grown[0] = '\0';
+  }
+  buffer = grown;
+  capacity = size;
+  return true;
+}
+
+String &String::copy(const char *str, unsigned int length)
+{
+  if (reserve(length))
+  {
+    memmove(buffer, str, length);
+    len = length;
+    buffer[len] = '\0';
+  }
+  return *this;
+}
+
+String &String::append(const char *str, unsigned int length)
+{
+  if (reserve(len + length))
+  {
+    memmove(buffer + len, str, length);
+    len += length;
+    buffer[len] = '\0';
+  }
+  return *this;
+}
+
+bool String::concat(const String &str)
+{
+  append(str.buffer, str.len);
+  return true;
+}
+
+bool String::concat(const char *str)
+{
+  if (str)
+  {
+    append(str, strlen(str));
+  }
+  return true;
+}
+
+bool String::concat(char c)
+{
+  append(&c, 1);
+  return true;
+}
+
+String &String::operator+=(const String &str)
+{
+  concat(str);
+  return *this;
+}
+
+String &String::operator+=(const char *str)
+{
+  concat(str);
+  return *this;
+}
+
+String &String::operator+=(char c)
+{
+  concat(c);
+  return *this;
+}
+
+String operator+(const String &lhs, const String &rhs)
+{
+  String result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+String operator+(const String &lhs, const char *rhs)
+{
+  String result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+String operator+(const String &lhs, char rhs)
+{
+  String result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+bool String::equals(const String &other) const
+{
+  return len == other.len && memcmp(buffer, other.buffer, len) == 0;
+}
+
+bool String::equals(const char *str) const
+{
+  return strcmp(buffer, str ? str : "") == 0;
+}
+
+bool String::startsWith(const String &prefix) const
+{
+  return prefix.len <= len && memcmp(buffer, prefix.buffer, prefix.len) == 0;
+}
+
+bool String::endsWith(const String &suffix) const
+{
+  return suffix.len <= len && memcmp(buffer + len - suffix.len, suffix.buffer, suffix.len) == 0;
+}
+
+char String::charAt(unsigned int index) const
+{
+  return index < len ? buffer[index] : '\0';
+}
+
+char String::operator[](unsigned int index) const
+{
+  return charAt(index);
+}
+
+char &String::operator[](unsigned int index)
+{
+  static char dummy;
+  if (index >= len)
+  {
+    dummy = '\0';
+    return dummy;
+  }
+  return buffer[index];
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+  if (from >= len)
+  {
+    return -1;
+  }
+  const char *found = strchr(buffer + from, c);
+  return found ? found - buffer : -1;
+}
+
+int String::indexOf(const String &str, unsigned int from) const
+{
+  if (from >= len)
+  {
+    return -1;
+  }
+  const char *found = strstr(buffer + from, str.buffer);
+  return found ? found - buffer : -1;
+}
+
+String String::substring(unsigned int from) const
+{
+  return substring(from, len);
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+  if (from > to)
+  {
+    unsigned int swap = from;
+    from = to;
+    to = swap;
+  }
+  if (from >= len)
+  {
+    return String();
+  }
+  if (to > len)
+  {
+    to = len;
+  }
+  String result;
+  result.copy(buffer + from, to - from);
+  return result;
+}
+
+long String::toInt() const
+{
+  return atol(buffer);
+}
+
+void String::trim()
+{
+  unsigned int start = 0;
+  while (start < len && isspace((unsigned char)buffer[start]))
+  {
+    start++;
+  }
+  unsigned int end = len;
+  while (end > start && isspace((unsigned char)buffer[end - 1]))
+  {
+    end--;
+  }
+  memmove(buffer, buffer + start, end - start);
+  len = end - start;
+  buffer[len] = '\0';
+}
+
+void String::toLowerCase()
+{
+  for (unsigned int i = 0; i < len; i++)
+  {
+    buffer[i] = tolower((unsigned char)buffer[i]);
+  }
+}
+
+void String::toUpperCase()
+{
+  for (unsigned int i = 0; i < len; i++)
+  {
+    buffer[i] = toupper((unsigned char)buffer[i]);
+  }
+}
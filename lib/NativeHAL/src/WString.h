@@ -0,0 +1,75 @@
+#ifndef NATIVE_HAL_WSTRING_H
+#define NATIVE_HAL_WSTRING_H
+
+#include <stddef.h>
+
+class __FlashStringHelper;
+
+// Subset of the Arduino String class, with the same semantics for the
+// members the firmware calls (indices are clamped, toInt() stops at the
+// first non-digit)
+class String
+{
+private:
+  char *buffer;
+  unsigned int len;
+  unsigned int capacity;
+
+  bool reserve(unsigned int size);
+  String &copy(const char *str, unsigned int length);
+  String &append(const char *str, unsigned int length);
+
+public:
+  String(const char *str = "");
+  String(const __FlashStringHelper *str);
+  String(const String &other);
+  explicit String(char c);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  ~String();
+
+  String &operator=(const String &other);
+  String &operator=(const char *str);
+
+  // Concatenation
+  bool concat(const String &str);
+  bool concat(const char *str);
+  bool concat(char c);
+  String &operator+=(const String &str);
+  String &operator+=(const char *str);
+  String &operator+=(char c);
+  friend String operator+(const String &lhs, const String &rhs);
+  friend String operator+(const String &lhs, const char *rhs);
+  friend String operator+(const String &lhs, char rhs);
+
+  // Comparison
+  bool equals(const String &other) const;
+  bool equals(const char *str) const;
+  bool operator==(const String &other) const { return equals(other); }
+  bool operator==(const char *str) const { return equals(str); }
+  bool operator!=(const String &other) const { return !equals(other); }
+  bool operator!=(const char *str) const { return !equals(str); }
+  bool startsWith(const String &prefix) const;
+  bool endsWith(const String &suffix) const;
+
+  // Access
+  unsigned int length() const { return len; }
+  const char *c_str() const { return buffer; }
+  char charAt(unsigned int index) const;
+  char operator[](unsigned int index) const;
+  char &operator[](unsigned int index);
+  int indexOf(char c, unsigned int from = 0) const;
+  int indexOf(const String &str, unsigned int from = 0) const;
+  String substring(unsigned int from) const;
+  String substring(unsigned int from, unsigned int to) const;
+
+  // Conversion and modification
+  long toInt() const;
+  void trim();
+  void toLowerCase();
+  void toUpperCase();
+};
+
+#endif // NATIVE_HAL_WSTRING_H
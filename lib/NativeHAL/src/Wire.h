@@ -0,0 +1,29 @@
+#ifndef NATIVE_HAL_WIRE_H
+#define NATIVE_HAL_WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// I2C bus with no devices; the RTC stub talks to the simulated clock
+// directly. Transactions are only counted, and time out while
+// halSetI2cHang() holds the bus.
+class TwoWire
+{
+public:
+  void begin();
+  void end();
+  void setClock(uint32_t frequency);
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool sendStop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+  size_t write(uint8_t data);
+  int available();
+  int read();
+  void setWireTimeout(uint32_t timeout = 25000, bool resetWithTimeout = false);
+  bool getWireTimeoutFlag();
+  void clearWireTimeoutFlag();
+};
+
+extern TwoWire Wire;
+
+#endif // NATIVE_HAL_WIRE_H
@@ -0,0 +1,137 @@
+#include "replay.h"
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+// Strip the simulator's "[0d 00:00:00.000] < " so its own dumps load too
+static const char *payload(const char *line)
+{
+  const char *echo = line[0] == '[' ? strstr(line, "] < ") : nullptr;
+  return echo ? echo + 4 : line;
+}
+
+bool loadTrace(const char *path, Trace &trace)
+{
+  FILE *file = fopen(path, "r");
+  if (!file)
+  {
+    perror(path);
+    return false;
+  }
+
+  char buffer[512];
+  bool inTrace = false;
+  bool complete = false;
+  while (!complete && fgets(buffer, sizeof(buffer), file))
+  {
+    const char *line = payload(buffer);
+    if (!inTrace)
+    {
+      const char *start = strstr(line, "REC start ");
+      if (start)
+      {
+        trace.startTime = strtoul(start + 10, nullptr, 10);
+        const char *dropped = strstr(start, " dropped ");
+        trace.truncated = dropped && strtoul(dropped + 9, nullptr, 10) > 0;
+        inTrace = true;
+      }
+      continue;
+    }
+
+    if (!strncmp(line, "REC_END", 7))
+    {
+      complete = true;
+    }
+    else if (!strncmp(line, "EEPROM ", 7))
+    {
+      for (const char *hex = line + 7; isxdigit(hex[0]) && isxdigit(hex[1]); hex += 2)
+      {
+        char byte[3] = {hex[0], hex[1], 0};
+        trace.eeprom.push_back(strtoul(byte, nullptr, 16));
+      }
+    }
+    else
+    {
+      TraceEvent event = {};
+      unsigned long ms;
+      unsigned pin = 0, value = 0;
+      char type;
+      int fields = sscanf(line, "%lu %c %u %u", &ms, &type, &pin, &value);
+      if (fields < 2)
+      {
+        continue;
+      }
+      event.ms = ms;
+      event.type = type;
+      event.pin = type == 'B' ? pin : 0;
+      event.value = type == 'B' ? value : pin;
+      trace.events.push_back(event);
+    }
+  }
+  fclose(file);
+
+  if (!complete)
+  {
+    fprintf(stderr, "%s: no complete REC start ... REC_END block\n", path);
+  }
+  return complete;
+}
+
+void prepareReplay(const Trace &trace)
+{
+  // A board's image as is: EEPROMStorage keeps the same layout on the host
+  memcpy(halEeprom(), trace.eeprom.data(), trace.eeprom.size() < 1024 ? trace.eeprom.size() : 1024);
+
+  // The trace's own ticks move the RTC from here on
+  halSetRtc(trace.startTime);
+  halSetRtcManualTicks(true);
+}
+
+void replayTrace(const Trace &trace, uint32_t passes, double compress)
+{
+  std::string line;
+  for (uint32_t pass = 0; pass < passes; pass++)
+  {
+    // The start of the first line may have been overwritten; don't send the rest
+    bool skipLine = trace.truncated;
+    uint64_t origin = simMillis();
+    for (size_t i = 0; i < trace.events.size(); i++)
+    {
+      const TraceEvent &event = trace.events[i];
+      uint64_t due = origin + (uint64_t)(event.ms / compress);
+      if (due > simMillis())
+      {
+        simRun(due - simMillis());
+      }
+
+      switch (event.type)
+      {
+      case 'T':
+        skipLine = false; // Only serial bytes before anything else are suspect
+        halRtcTick();
+        break;
+      case 'B':
+        skipLine = false;
+        halSetPin(event.pin, event.value ? HIGH : LOW);
+        break;
+      case 'S':
+        if (skipLine)
+        {
+          skipLine = event.value != '\n';
+          break;
+        }
+        line += (char)event.value;
+        if (event.value == '\n')
+        {
+          halSerialInput(line.c_str()); // A whole line, as readStringUntil() took it
+          line.clear();
+        }
+        break;
+      }
+    }
+    simRun(1); // Let the last event be seen
+  }
+}
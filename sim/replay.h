@@ -0,0 +1,39 @@
+#ifndef SIM_REPLAY_H
+#define SIM_REPLAY_H
+
+#include <stdint.h>
+#include <vector>
+
+// A trace printed by 'rec dump' (firmware built with -D CLOCK_RECORD)
+struct TraceEvent
+{
+  uint32_t ms; // From the oldest recorded event
+  char type;   // 'T' RTC tick, 'B' button level, 'S' serial byte
+  uint8_t pin;
+  uint8_t value;
+};
+
+struct Trace
+{
+  uint32_t startTime = 0; // RTC time at the first event
+  bool truncated = false;  // Older events were overwritten
+  std::vector<uint8_t> eeprom;
+  std::vector<TraceEvent> events;
+};
+
+// Reads the lines between "REC start" and REC_END; anything around them
+// (other serial output, the simulator's own timestamps) is skipped
+bool loadTrace(const char *path, Trace &trace);
+
+// Puts the EEPROM image and RTC time in place; call before setup()
+void prepareReplay(const Trace &trace);
+
+// Feeds the events in at their recorded times. Each pass starts where the
+// last one ended; compress > 1 shortens every gap by that factor.
+void replayTrace(const Trace &trace, uint32_t passes, double compress);
+
+// Provided by sim_main.cpp
+void simRun(uint64_t ms);
+uint64_t simMillis();
+
+#endif // SIM_REPLAY_H
@@ -0,0 +1,588 @@
+// Accelerated-time simulator for the clock firmware.
+//
+// Built by env:sim: the real main.cpp (setup() and loop()) runs on
+// lib/NativeHAL, one loop() pass per millisecond of virtual time, which is
+// how often Timer0 wakes the idle-sleeping AVR. Nothing waits for the wall
+// clock unless --speed asks for it, so a day of clock time takes seconds.
+//
+// The six digits are rebuilt from what the firmware drives: the pattern
+// last shifted out and the digit picked by the BCD selector pins. Input
+// comes from a script (a file, or stdin) with one command per line:
+//
+//   wait <duration>           run for 500ms, 2s, 5m, 1h, 1d (plain number: ms)
+//   press <1-4> [duration]    press a button, 100ms unless given, then release
+//   hold <1-4> / release <1-4>
+//   serial <text>             type a line into the serial port
+//   rtc <YYYY-MM-DD> <HH:MM:SS>
+//   dht <temperature> <humidity>
+//   show                      print the display
+//   expect display <text>     check the digits, dots ignored ("1230 5")
+//   expect serial <text>      check serial output since the last expect
+//   expect tone / expect silent
+//   quit
+//
+// A failed expect prints the reason and the simulator exits with status 1,
+// so scripts double as end-to-end tests.
+//
+// --replay feeds a trace from 'rec dump' back in at full speed, before any
+// script runs. --passes repeats it and --compress shortens its gaps, which
+// turns a recorded session into load on the input path.
+
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <RTClib.h>
+#include "Display.h"
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <sys/select.h>
+
+// The firmware sketch
+void setup();
+void loop();
+
+// Same wiring as main.cpp
+static const uint8_t BUTTON_PINS[] = {A1, A2, A3, 12};
+static const uint8_t BCD_PINS[] = {3, 4, 5};
+#define SHIFT_PIN 8
+#define BUZZER_PIN 9
+
+#define DEFAULT_PRESS 100 // ms
+
+struct Options
+{
+  double speed = 0; // Virtual ms per real ms; 0 runs flat out
+  bool live = false;
+  bool trace = false;
+  bool quiet = false;
+  bool interactive = false;
+  const char *script = nullptr;
+  const char *replay = nullptr;
+  uint32_t passes = 1;
+  double compress = 1;
+};
+
+static Options options;
+
+// What the digits show; index 0 is the leftmost digit
+static uint8_t frame[6];
+static uint8_t shownFrame[6];
+static bool frameShown = false;
+
+static uint64_t virtualMillis = 0;
+static std::string serialLog; // Output since the last 'expect serial'
+static std::string serialLine;
+
+static struct timespec realStart;
+static uint64_t virtualStart = 0;
+
+// Display
+
+static void captureDigit()
+{
+  uint8_t code = 0;
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    code |= halGetPin(BCD_PINS[i]) << i;
+  }
+
+  if (code == 0)
+  {
+    memset(frame, 0, sizeof(frame)); // Refresh stopped, display dark
+  }
+  else if (code <= 6)
+  {
+    frame[6 - code] = halGetShiftOut(SHIFT_PIN); // Code 1 is DIGIT_6
+  }
+}
+
+// Seven segments in three text rows, bit 0 = a ... bit 6 = g, bit 7 = dp
+static void renderRows(const uint8_t *digits, char rows[3][40])
+{
+  char *r0 = rows[0], *r1 = rows[1], *r2 = rows[2];
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    uint8_t p = digits[i];
+    const char *gap = (i == 2 || i == 4) ? "  " : "";
+    r0 += sprintf(r0, "%s %c  ", gap, p & 0x01 ? '_' : ' ');
+    r1 += sprintf(r1, "%s%c%c%c ", gap, p & 0x20 ? '|' : ' ', p & 0x40 ? '_' : ' ', p & 0x02 ? '|' : ' ');
+    r2 += sprintf(r2, "%s%c%c%c%c", gap, p & 0x10 ? '|' : ' ', p & 0x08 ? '_' : ' ', p & 0x04 ? '|' : ' ',
+                  p & 0x80 ? '.' : ' ');
+  }
+}
+
+static void printTimestamp(FILE *out)
+{
+  uint64_t s = virtualMillis / 1000;
+  fprintf(out, "[%llud %02u:%02u:%02u.%03u]", (unsigned long long)(s / 86400), (unsigned)(s / 3600 % 24),
+          (unsigned)(s / 60 % 60), (unsigned)(s % 60), (unsigned)(virtualMillis % 1000));
+}
+
+static void showFrame(bool inPlace)
+{
+  char rows[3][40];
+  renderRows(frame, rows);
+
+  if (inPlace && frameShown)
+  {
+    printf("\x1b[4A"); // Back over the previous frame
+  }
+  // Clear to the end of each line when drawing over an old frame
+  const char *eol = inPlace ? "\x1b[K\n" : "\n";
+  printTimestamp(stdout);
+  printf(" buzzer %s%s", halGetTone(BUZZER_PIN) ? "on" : "off", eol);
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    printf("  %s%s", rows[i], eol);
+  }
+  fflush(stdout);
+
+  memcpy(shownFrame, frame, sizeof(frame));
+  frameShown = true;
+}
+
+// Characters as the firmware would draw them, for 'expect display'
+static bool displayShows(const char *text, std::string &actual)
+{
+  static const char CHARSET[] = "0123456789 *ABCDEFGHIJLNOPRSUYZ";
+  bool match = strlen(text) == 6;
+  actual.clear();
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    uint8_t pattern = frame[i] & 0x7F;
+    char shown = '?';
+    for (const char *c = CHARSET; *c; c++)
+    {
+      if ((Display::getPatternForChar(*c) & 0x7F) == pattern)
+      {
+        shown = *c;
+        break;
+      }
+    }
+    actual += shown;
+    if (match && (Display::getPatternForChar(text[i]) & 0x7F) != pattern)
+    {
+      match = false;
+    }
+  }
+  return match;
+}
+
+// Running the firmware
+
+static void drainSerial()
+{
+  const char *out = halSerialOutput();
+  if (!*out)
+  {
+    return;
+  }
+  serialLog += out;
+  if (!options.quiet)
+  {
+    for (const char *c = out; *c; c++)
+    {
+      if (*c == '\n')
+      {
+        printTimestamp(stdout);
+        printf(" < %s\n", serialLine.c_str());
+        serialLine.clear();
+      }
+      else if (*c != '\r')
+      {
+        serialLine += *c;
+      }
+    }
+  }
+  halSerialClear();
+}
+
+static uint64_t realMillis()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - realStart.tv_sec) * 1000ULL + (now.tv_nsec - realStart.tv_nsec) / 1000000LL;
+}
+
+// Hold virtual time to --speed times the wall clock
+static void pace()
+{
+  if (options.speed <= 0)
+  {
+    return;
+  }
+  uint64_t due = (uint64_t)((virtualMillis - virtualStart) / options.speed);
+  uint64_t now = realMillis();
+  if (due > now + 1)
+  {
+    usleep((due - now) * 1000);
+  }
+}
+
+static void step()
+{
+  loop();
+  captureDigit();
+  drainSerial();
+
+  // A whole scan ends on DIGIT_1; report frames only once complete
+  bool scanDone = halGetPin(BCD_PINS[0]) == 0 && halGetPin(BCD_PINS[1]) == 1 && halGetPin(BCD_PINS[2]) == 1;
+  bool dark = halGetPin(BCD_PINS[0]) == 0 && halGetPin(BCD_PINS[1]) == 0 && halGetPin(BCD_PINS[2]) == 0;
+  if ((scanDone || dark) && memcmp(frame, shownFrame, sizeof(frame)) != 0)
+  {
+    if (options.trace)
+    {
+      showFrame(false);
+    }
+    else if (options.live && virtualMillis % 20 == 0)
+    {
+      showFrame(true);
+    }
+  }
+
+  halAdvanceMillis(1);
+  virtualMillis++;
+  if (virtualMillis % 16 == 0)
+  {
+    pace();
+  }
+}
+
+static void run(uint64_t ms)
+{
+  for (uint64_t i = 0; i < ms; i++)
+  {
+    step();
+  }
+}
+
+void simRun(uint64_t ms)
+{
+  run(ms);
+}
+
+uint64_t simMillis()
+{
+  return virtualMillis;
+}
+
+// Script commands
+
+static bool parseDuration(const char *text, uint64_t &ms)
+{
+  char *end;
+  double value = strtod(text, &end);
+  if (end == text || value < 0)
+  {
+    return false;
+  }
+  double scale = 1;
+  if (!strcmp(end, "") || !strcmp(end, "ms"))
+    scale = 1;
+  else if (!strcmp(end, "s"))
+    scale = 1000;
+  else if (!strcmp(end, "m"))
+    scale = 60000;
+  else if (!strcmp(end, "h"))
+    scale = 3600000;
+  else if (!strcmp(end, "d"))
+    scale = 86400000;
+  else
+    return false;
+  ms = (uint64_t)(value * scale);
+  return true;
+}
+
+static int buttonPin(const char *text)
+{
+  int n = atoi(text);
+  return n >= 1 && n <= 4 ? BUTTON_PINS[n - 1] : -1;
+}
+
+static bool fail(int line, const char *fmt, const char *detail)
+{
+  fflush(stdout);
+  fprintf(stderr, "line %d: ", line);
+  fprintf(stderr, fmt, detail);
+  fputc('\n', stderr);
+  return false;
+}
+
+// Returns false on a failed expect or a bad command; sets quit on 'quit'
+static bool execute(char *line, int lineNumber, bool &quit)
+{
+  char *comment = strchr(line, '#');
+  if (comment && strncmp(line, "serial", 6) != 0)
+  {
+    *comment = '\0';
+  }
+  line[strcspn(line, "\r\n")] = '\0';
+  for (size_t end = strlen(line); end > 0 && (line[end - 1] == ' ' || line[end - 1] == '\t'); end--)
+  {
+    line[end - 1] = '\0';
+  }
+
+  char *command = strtok(line, " \t");
+  if (!command)
+  {
+    return true;
+  }
+  char *rest = strtok(nullptr, "");
+  while (rest && (*rest == ' ' || *rest == '\t'))
+  {
+    rest++;
+  }
+  const char *args = rest ? rest : "";
+
+  if (!strcmp(command, "wait"))
+  {
+    uint64_t ms;
+    if (!parseDuration(args, ms))
+    {
+      return fail(lineNumber, "bad duration '%s'", args);
+    }
+    run(ms);
+  }
+  else if (!strcmp(command, "press") || !strcmp(command, "hold") || !strcmp(command, "release"))
+  {
+    char buffer[64];
+    strncpy(buffer, args, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    char *which = strtok(buffer, " \t");
+    char *duration = strtok(nullptr, " \t");
+    int pin = which ? buttonPin(which) : -1;
+    if (pin < 0)
+    {
+      return fail(lineNumber, "no button '%s'", args);
+    }
+    if (!strcmp(command, "release"))
+    {
+      halSetPin(pin, LOW);
+      return true;
+    }
+    halSetPin(pin, HIGH);
+    if (!strcmp(command, "press"))
+    {
+      uint64_t ms = DEFAULT_PRESS;
+      if (duration && !parseDuration(duration, ms))
+      {
+        return fail(lineNumber, "bad duration '%s'", duration);
+      }
+      run(ms);
+      halSetPin(pin, LOW);
+    }
+  }
+  else if (!strcmp(command, "serial"))
+  {
+    halSerialInput(args);
+    halSerialInput("\n");
+  }
+  else if (!strcmp(command, "rtc"))
+  {
+    unsigned year, month, day, hour, minute, second;
+    if (sscanf(args, "%u-%u-%u %u:%u:%u", &year, &month, &day, &hour, &minute, &second) != 6)
+    {
+      return fail(lineNumber, "bad date '%s', want YYYY-MM-DD HH:MM:SS", args);
+    }
+    halSetRtc(DateTime(year, month, day, hour, minute, second).unixtime());
+  }
+  else if (!strcmp(command, "dht"))
+  {
+    float temperature, humidity;
+    if (sscanf(args, "%f %f", &temperature, &humidity) != 2)
+    {
+      return fail(lineNumber, "bad reading '%s'", args);
+    }
+    halSetDht(temperature, humidity);
+  }
+  else if (!strcmp(command, "show"))
+  {
+    showFrame(false);
+  }
+  else if (!strcmp(command, "expect"))
+  {
+    if (!strncmp(args, "display ", 8))
+    {
+      std::string actual;
+      if (!displayShows(args + 8, actual))
+      {
+        std::string detail = std::string(args + 8) + "', display shows '" + actual;
+        return fail(lineNumber, "expected '%s'", detail.c_str());
+      }
+    }
+    else if (!strncmp(args, "serial ", 7))
+    {
+      bool found = serialLog.find(args + 7) != std::string::npos;
+      serialLog.clear();
+      if (!found)
+      {
+        return fail(lineNumber, "no serial output containing '%s'", args + 7);
+      }
+    }
+    else if (!strcmp(args, "tone") || !strcmp(args, "silent"))
+    {
+      bool sounding = halGetTone(BUZZER_PIN) != 0;
+      if (sounding != !strcmp(args, "tone"))
+      {
+        return fail(lineNumber, "buzzer is %s", sounding ? "sounding" : "silent");
+      }
+    }
+    else
+    {
+      return fail(lineNumber, "unknown expectation '%s'", args);
+    }
+  }
+  else if (!strcmp(command, "quit"))
+  {
+    quit = true;
+  }
+  else
+  {
+    return fail(lineNumber, "unknown command '%s'", command);
+  }
+  return true;
+}
+
+static int runScript(FILE *input)
+{
+  char line[256];
+  int lineNumber = 0;
+  bool quit = false;
+  while (!quit && fgets(line, sizeof(line), input))
+  {
+    lineNumber++;
+    if (!execute(line, lineNumber, quit))
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Free-running at --speed, taking commands from the terminal as they come
+static int runInteractive()
+{
+  char line[256];
+  int lineNumber = 0;
+  bool quit = false;
+  while (!quit)
+  {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(STDIN_FILENO, &fds);
+    struct timeval now = {0, 0};
+    if (select(STDIN_FILENO + 1, &fds, nullptr, nullptr, &now) > 0)
+    {
+      if (!fgets(line, sizeof(line), stdin))
+      {
+        break;
+      }
+      lineNumber++;
+      execute(line, lineNumber, quit); // Mistakes are reported, not fatal
+    }
+    run(10);
+  }
+  return 0;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+          "usage: sim [options] [script]\n"
+          "  --speed X    run at X times real time (default: as fast as possible)\n"
+          "  --live       redraw the display in place as it changes\n"
+          "  --trace      print every display change\n"
+          "  --quiet      hide serial output\n"
+          "  -i           interactive: keep running, read commands from stdin\n"
+          "  --replay F   replay a 'rec dump' trace first\n"
+          "  --passes N   replay it N times back to back\n"
+          "  --compress K divide the gaps between recorded events by K\n"
+          "Without a script, commands are read from stdin (not with --replay).\n");
+}
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--speed") && i + 1 < argc)
+      options.speed = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--live"))
+      options.live = true;
+    else if (!strcmp(argv[i], "--trace"))
+      options.trace = true;
+    else if (!strcmp(argv[i], "--quiet"))
+      options.quiet = true;
+    else if (!strcmp(argv[i], "-i"))
+      options.interactive = true;
+    else if (!strcmp(argv[i], "--replay") && i + 1 < argc)
+      options.replay = argv[++i];
+    else if (!strcmp(argv[i], "--passes") && i + 1 < argc)
+      options.passes = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--compress") && i + 1 < argc)
+      options.compress = atof(argv[++i]);
+    else if (argv[i][0] != '-' && !options.script)
+      options.script = argv[i];
+    else
+    {
+      usage();
+      return 2;
+    }
+  }
+
+  if (options.interactive)
+  {
+    options.live = true;
+    if (options.speed <= 0)
+    {
+      options.speed = 1;
+    }
+  }
+
+  FILE *input = stdin;
+  if (options.script && !(input = fopen(options.script, "r")))
+  {
+    perror(options.script);
+    return 2;
+  }
+
+  Trace trace;
+  if (options.replay)
+  {
+    if (!loadTrace(options.replay, trace) || options.compress <= 0)
+    {
+      return 2;
+    }
+    prepareReplay(trace);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &realStart);
+  setup();
+  drainSerial();
+
+  if (options.replay)
+  {
+    replayTrace(trace, options.passes, options.compress);
+
+    // Load figures: how hard the input path was driven and how fast it went
+    uint64_t wall = realMillis();
+    uint64_t events = (uint64_t)trace.events.size() * options.passes;
+    fprintf(stderr, "replayed %llu events in %llu virtual ms (%.1f/s), %llu ms wall\n",
+            (unsigned long long)events, (unsigned long long)virtualMillis,
+            virtualMillis ? events * 1000.0 / virtualMillis : 0.0, (unsigned long long)wall);
+    if (!options.script)
+    {
+      return 0;
+    }
+  }
+
+  int status = options.interactive ? runInteractive() : runScript(input);
+  if (options.live)
+  {
+    showFrame(true);
+  }
+  return status;
+}
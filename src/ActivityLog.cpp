@@ -0,0 +1,250 @@
+#include "ActivityLog.h"
+#include "Clock.h"
+#include "EEPROMStorage.h"
+
+// Anchors count 256 s units from here, 24 bits of them: past 2099
+static const EpochTime LOG_EPOCH = 946684800UL; // 2000-01-01, the DS1307's first year
+static const uint8_t LAP_BIT = 0x80;
+
+const char LOG_TIME_NAME[] PROGMEM = "time";
+const char LOG_POWER_UP_NAME[] PROGMEM = "power up";
+const char LOG_ALARM_FIRED_NAME[] PROGMEM = "alarm fired";
+const char LOG_ALARM_DISMISSED_NAME[] PROGMEM = "alarm dismissed";
+const char LOG_TIMER_DONE_NAME[] PROGMEM = "timer done";
+const char LOG_SETTINGS_NAME[] PROGMEM = "settings";
+const char LOG_SENSOR_FAULT_NAME[] PROGMEM = "sensor fault";
+const char LOG_DROPPED_NAME[] PROGMEM = "dropped";
+const char LOG_MEMORY_LOW_NAME[] PROGMEM = "memory low";
+
+const char *const LOG_TYPE_NAMES[LOG_TYPE_COUNT - 1] PROGMEM = {
+    LOG_TIME_NAME, LOG_POWER_UP_NAME, LOG_ALARM_FIRED_NAME, LOG_ALARM_DISMISSED_NAME,
+    LOG_TIMER_DONE_NAME, LOG_SETTINGS_NAME, LOG_SENSOR_FAULT_NAME, LOG_DROPPED_NAME,
+    LOG_MEMORY_LOW_NAME};
+
+ActivityLog::ActivityLog() : clock(nullptr), head(0), lap(0), full(false), lastTime(0), anchored(false),
+                             sinceAnchor(0), tokens(LOG_BURST), lastRefill(0), dropped(0), droppedTotal(0)
+{
+}
+
+void ActivityLog::begin(Clock *clock, uint8_t resetReport)
+{
+  this->clock = clock;
+  scan();
+  lastRefill = clock->getUnixTime();
+  append(LOG_POWER_UP, resetReport);
+}
+
+bool ActivityLog::isRecord(const LogRecord &record)
+{
+  // Erased cells read type 0x7F, cleared ones 0
+  uint8_t type = record.type & ~LAP_BIT;
+  return type != LOG_EMPTY && type < LOG_TYPE_COUNT;
+}
+
+void ActivityLog::scan()
+{
+  // The head is the first slot that is free or still holds the lap before
+  EEPROMStorage eeprom;
+  LogRecord record;
+  eeprom.readLogRecord(0, record);
+  head = 0;
+  lap = 0;
+  full = false;
+  if (!isRecord(record))
+  {
+    return;
+  }
+
+  uint8_t first = record.type & LAP_BIT;
+  for (uint8_t i = 1; i < LOG_RECORDS; i++)
+  {
+    eeprom.readLogRecord(i, record);
+    if (!isRecord(record) || (record.type & LAP_BIT) != first)
+    {
+      head = i;
+      lap = first;
+      full = isRecord(record);
+      return;
+    }
+  }
+
+  // One lap fills the ring; the next starts over at 0
+  lap = first ^ LAP_BIT;
+  full = true;
+}
+
+bool ActivityLog::admit(EpochTime now)
+{
+  // Refilled by RTC seconds, which also pass in power-down
+  if (now < lastRefill)
+  {
+    lastRefill = now; // The clock was set back
+  }
+  uint32_t refills = (now - lastRefill) / LOG_REFILL;
+  if (refills > 0)
+  {
+    tokens = refills >= (uint32_t)(LOG_BURST - tokens) ? LOG_BURST : tokens + refills;
+    lastRefill += refills * LOG_REFILL;
+  }
+
+  if (tokens == 0)
+  {
+    return false;
+  }
+  tokens--;
+  return true;
+}
+
+void ActivityLog::append(uint8_t type, uint8_t data)
+{
+  EpochTime now = clock->getUnixTime();
+  if (!admit(now))
+  {
+    if (dropped < 255)
+    {
+      dropped++;
+    }
+    droppedTotal++;
+    return;
+  }
+
+  // What the limit dropped goes in with the first record let through
+  if (dropped > 0)
+  {
+    appendAt(now, LOG_DROPPED, dropped);
+    dropped = 0;
+  }
+  appendAt(now, type, data);
+}
+
+void ActivityLog::appendAt(EpochTime now, uint8_t type, uint8_t data)
+{
+  // Before the first record, a jump back of the clock, a gap too long for
+  // the delta, or a long run without one: an anchor first
+  if (!anchored || now < lastTime || now - lastTime > 0xFFFF || sinceAnchor >= LOG_ANCHOR_EVERY)
+  {
+    anchor(now);
+  }
+  write(now >= lastTime ? now - lastTime : 0, type, data);
+  lastTime = now;
+  sinceAnchor++;
+}
+
+void ActivityLog::anchor(EpochTime now)
+{
+  uint32_t units = now > LOG_EPOCH ? (now - LOG_EPOCH) >> 8 : 0;
+  write((uint16_t)units, LOG_TIME, (uint8_t)(units >> 16));
+  lastTime = LOG_EPOCH + (units << 8);
+  anchored = true;
+  sinceAnchor = 0;
+}
+
+void ActivityLog::write(uint16_t delta, uint8_t type, uint8_t data)
+{
+  EEPROMStorage eeprom;
+  eeprom.writeLogRecord(head, {delta, data, (uint8_t)(type | lap)});
+  if (++head == LOG_RECORDS)
+  {
+    head = 0;
+    lap ^= LAP_BIT;
+    full = true;
+  }
+}
+
+void ActivityLog::record(const AlarmFired &event)
+{
+  append(LOG_ALARM_FIRED, event.index | event.round << 4);
+}
+
+void ActivityLog::record(const AlarmDismissed &event)
+{
+  append(LOG_ALARM_DISMISSED, event.index | event.round << 4);
+}
+
+void ActivityLog::record(const TimerCompleted &event)
+{
+  uint32_t minutes = event.duration / 60000UL;
+  append(LOG_TIMER_DONE, minutes < 255 ? minutes : 255);
+}
+
+void ActivityLog::record(const SettingsChanged &event)
+{
+  append(LOG_SETTINGS, event.items);
+}
+
+void ActivityLog::record(const SensorFault &event)
+{
+  append(LOG_SENSOR_FAULT, event.code);
+}
+
+void ActivityLog::record(const MemoryLow &event)
+{
+  append(LOG_MEMORY_LOW, event.headroom < 255 ? event.headroom : 255);
+}
+
+void ActivityLog::rewind(LogCursor &cursor) const
+{
+  cursor.index = full ? head : 0;
+  cursor.left = getCount();
+  cursor.time = 0;
+}
+
+bool ActivityLog::next(LogCursor &cursor, LogEntry &entry) const
+{
+  EEPROMStorage eeprom;
+  while (cursor.left > 0)
+  {
+    LogRecord record;
+    eeprom.readLogRecord(cursor.index, record);
+    cursor.index = cursor.index + 1 < LOG_RECORDS ? cursor.index + 1 : 0;
+    cursor.left--;
+
+    uint8_t type = record.type & ~LAP_BIT;
+    if (type == LOG_TIME)
+    {
+      cursor.time = LOG_EPOCH + (((uint32_t)record.data << 16 | record.delta) << 8);
+      continue;
+    }
+    if (!isRecord(record))
+    {
+      continue;
+    }
+    // Until the first anchor the time is unknown
+    if (cursor.time != 0)
+    {
+      cursor.time += record.delta;
+    }
+    entry = {cursor.time, type, record.data};
+    return true;
+  }
+  return false;
+}
+
+uint8_t ActivityLog::getCount() const
+{
+  return full ? LOG_RECORDS : head;
+}
+
+uint16_t ActivityLog::getDropped() const
+{
+  return droppedTotal;
+}
+
+void ActivityLog::clear()
+{
+  EEPROMStorage eeprom;
+  eeprom.eraseLog();
+  head = 0;
+  lap = 0;
+  full = false;
+  anchored = false;
+}
+
+const __FlashStringHelper *ActivityLog::getTypeName(uint8_t type)
+{
+  if (type == LOG_EMPTY || type >= LOG_TYPE_COUNT)
+  {
+    return nullptr;
+  }
+  return (const __FlashStringHelper *)pgm_read_ptr(&LOG_TYPE_NAMES[type - 1]);
+}
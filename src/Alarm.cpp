@@ -1,116 +1,208 @@
 #include "Alarm.h"
 #include "Buzzer.h"
+#include "EventBus.h"
+#include "Timebase.h"
 
-Alarm::Alarm() : triggered(false), triggerStartTime(0), buzzer(nullptr)
+Alarm::Alarm() : state(ALARM_ARMED), activeAlarm(-1), stateStartTime(0), snoozeCount(0),
+                 snoozeConfig{9, 3}, buzzer(nullptr)
 {
-  data = {7, 0, false};
 }
 
 void Alarm::begin(Buzzer *buzzer)
 {
   this->buzzer = buzzer;
-  triggered = false;
-  triggerStartTime = 0;
+  state = ALARM_ARMED;
+  activeAlarm = -1;
+  snoozeCount = 0;
 }
 
-void Alarm::enable()
+void Alarm::enable(uint8_t index)
 {
-  data.enabled = true;
+  scheduler.setEnabled(index, true);
 }
 
-void Alarm::disable()
+void Alarm::disable(uint8_t index)
 {
-  data.enabled = false;
-  triggered = false;
+  scheduler.setEnabled(index, false);
+  if (state != ALARM_ARMED && activeAlarm == index)
+  {
+    dismiss();
+  }
 }
 
-void Alarm::stop()
+void Alarm::startRinging()
 {
-  triggered = false;
+  state = ALARM_RINGING;
+  stateStartTime = Timebase::millis();
   if (buzzer)
+  {
+    // Each snooze round rings with a more urgent pattern
+    buzzer->playAlarm(snoozeCount);
+  }
+  publish(AlarmFired{(uint8_t)activeAlarm, snoozeCount});
+}
+
+void Alarm::snooze()
+{
+  if (state != ALARM_RINGING)
+  {
+    return;
+  }
+
+  if (snoozeCount >= snoozeConfig.limit)
+  {
+    dismiss();
+    return;
+  }
+
+  snoozeCount++;
+  state = ALARM_SNOOZED;
+  stateStartTime = Timebase::millis();
+  if (buzzer)
+  {
+    buzzer->stopAlarm();
+  }
+}
+
+void Alarm::dismiss()
+{
+  if (state == ALARM_RINGING && buzzer)
   {
     buzzer->stopAlarm();
   }
+  if (state != ALARM_ARMED)
+  {
+    publish(AlarmDismissed{(uint8_t)activeAlarm, snoozeCount});
+  }
+  state = ALARM_ARMED;
+  activeAlarm = -1;
+  snoozeCount = 0;
+}
+
+void Alarm::setSnooze(const SnoozeConfig &config)
+{
+  snoozeConfig = config;
+}
+
+SnoozeConfig Alarm::getSnooze() const
+{
+  return snoozeConfig;
+}
+
+void Alarm::clockAdjusted()
+{
+  scheduler.clockAdjusted();
 }
 
-void Alarm::setTime(uint8_t hour, uint8_t minute)
+void Alarm::setTime(uint8_t index, uint8_t hour, uint8_t minute)
 {
-  data.hour = hour;
-  data.minute = minute;
+  scheduler.setTime(index, hour, minute);
 }
 
-void Alarm::adjustHour()
+void Alarm::setDays(uint8_t index, uint8_t days)
 {
-  data.hour = (data.hour + 1) % 24;
+  scheduler.setDays(index, days);
 }
 
-void Alarm::adjustMinute()
+void Alarm::setData(uint8_t index, const AlarmData &data)
 {
-  data.minute = (data.minute + 1) % 60;
+  scheduler.setAlarm(index, data);
 }
 
-bool Alarm::isEnabled() const
+bool Alarm::isEnabled(uint8_t index) const
 {
-  return data.enabled;
+  return scheduler.getAlarm(index).enabled;
 }
 
 bool Alarm::isTriggered() const
 {
-  return triggered;
+  return state == ALARM_RINGING;
 }
 
-bool Alarm::shouldTrigger(const Time &currentTime) const
+AlarmState Alarm::getState() const
 {
-  return data.enabled &&
-         !triggered &&
-         currentTime.hour == data.hour &&
-         currentTime.minute == data.minute &&
-         currentTime.second < 30;
+  return state;
 }
 
-uint8_t Alarm::getHour() const
+uint8_t Alarm::getSnoozeCount() const
 {
-  return data.hour;
+  return snoozeCount;
 }
 
-uint8_t Alarm::getMinute() const
+int8_t Alarm::getTriggeredAlarm() const
 {
-  return data.minute;
+  return activeAlarm;
 }
 
-AlarmData Alarm::getTime() const
+int8_t Alarm::getNextAlarm() const
 {
-  return data;
+  return scheduler.getNextAlarm();
 }
 
-void Alarm::update(const Time &currentTime)
+uint32_t Alarm::getNextFireTime() const
 {
-  // Check if alarm should trigger
-  if (shouldTrigger(currentTime))
-  {
-    triggered = true;
-    triggerStartTime = millis();
-  }
+  return scheduler.getNextFireTime();
+}
+
+void Alarm::restoreFiredFor(const uint32_t records[MAX_ALARMS])
+{
+  scheduler.restoreFiredFor(records);
+}
+
+uint32_t Alarm::getFiredFor(uint8_t index) const
+{
+  return scheduler.getFiredFor(index);
+}
+
+bool Alarm::takeRecordsChanged()
+{
+  return scheduler.takeRecordsChanged();
+}
+
+uint8_t Alarm::getHour(uint8_t index) const
+{
+  return scheduler.getAlarm(index).hour;
+}
+
+uint8_t Alarm::getMinute(uint8_t index) const
+{
+  return scheduler.getAlarm(index).minute;
+}
 
-  // Handle buzzer when triggered
-  if (triggered && buzzer)
+AlarmData Alarm::getTime(uint8_t index) const
+{
+  return scheduler.getAlarm(index);
+}
+
+void Alarm::update(uint32_t now)
+{
+  // Check if the clock crossed the next alarm instant
+  int8_t fired = scheduler.update(now);
+  if (fired >= 0)
   {
-    buzzer->playAlarm();
+    // A new alarm restarts the sequence, even over a snoozed one
+    activeAlarm = fired;
+    snoozeCount = 0;
+    startRinging();
   }
 
-  // Auto-stop alarm after duration
-  if (triggered && millis() - triggerStartTime >= ALARM_DURATION)
+  // Timed transitions; the buzzer is only commanded when the state changes
+  switch (state)
   {
-    triggered = false;
-    if (buzzer)
+  case ALARM_RINGING:
+    if (Timebase::millis() - stateStartTime >= RING_TIMEOUT)
     {
-      buzzer->stopAlarm();
+      // Unattended: escalate through the snooze rounds, then give up
+      snooze();
     }
+    break;
+  case ALARM_SNOOZED:
+    if (Timebase::millis() - stateStartTime >= snoozeConfig.minutes * 60000UL)
+    {
+      startRinging();
+    }
+    break;
+  case ALARM_ARMED:
+    break;
   }
-
-  // Update buzzer state
-  if (buzzer)
-  {
-    buzzer->update();
-  }
-}
\ No newline at end of file
+}
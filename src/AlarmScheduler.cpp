@@ -0,0 +1,200 @@
+#include "AlarmScheduler.h"
+
+AlarmScheduler::AlarmScheduler() : nextFireTime(0), nextAlarm(-1), editedMask(0),
+                                   restored(false), clockChanged(false),
+                                   recordsChanged(false), dirty(true)
+{
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    alarms[i] = {7, 0, false, ALARM_EVERY_DAY};
+    firedFor[i] = 0;
+  }
+}
+
+void AlarmScheduler::setAlarm(uint8_t index, const AlarmData &alarm)
+{
+  if (index < MAX_ALARMS)
+  {
+    alarms[index] = alarm;
+    editedMask |= 1 << index;
+    dirty = true;
+  }
+}
+
+void AlarmScheduler::setTime(uint8_t index, uint8_t hour, uint8_t minute)
+{
+  if (index < MAX_ALARMS)
+  {
+    alarms[index].hour = hour;
+    alarms[index].minute = minute;
+    editedMask |= 1 << index;
+    dirty = true;
+  }
+}
+
+void AlarmScheduler::setDays(uint8_t index, uint8_t days)
+{
+  if (index < MAX_ALARMS)
+  {
+    alarms[index].days = days & ALARM_EVERY_DAY;
+    editedMask |= 1 << index;
+    dirty = true;
+  }
+}
+
+void AlarmScheduler::setEnabled(uint8_t index, bool enabled)
+{
+  if (index < MAX_ALARMS)
+  {
+    alarms[index].enabled = enabled;
+    editedMask |= 1 << index;
+    dirty = true;
+  }
+}
+
+void AlarmScheduler::clockAdjusted()
+{
+  clockChanged = true;
+  dirty = true;
+}
+
+void AlarmScheduler::restoreFiredFor(const EpochTime records[MAX_ALARMS])
+{
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    firedFor[i] = records[i];
+  }
+  restored = true;
+  dirty = true;
+}
+
+EpochTime AlarmScheduler::getFiredFor(uint8_t index) const
+{
+  return firedFor[index < MAX_ALARMS ? index : 0];
+}
+
+bool AlarmScheduler::takeRecordsChanged()
+{
+  bool changed = recordsChanged;
+  recordsChanged = false;
+  return changed;
+}
+
+AlarmData AlarmScheduler::getAlarm(uint8_t index) const
+{
+  return alarms[index < MAX_ALARMS ? index : 0];
+}
+
+int8_t AlarmScheduler::getNextAlarm() const
+{
+  return nextAlarm;
+}
+
+EpochTime AlarmScheduler::getNextFireTime() const
+{
+  return nextFireTime;
+}
+
+int8_t AlarmScheduler::update(EpochTime now)
+{
+  if (dirty)
+  {
+    applyPending(now);
+    reschedule();
+  }
+
+  if (nextAlarm < 0 || now < nextFireTime)
+  {
+    return -1;
+  }
+
+  // Record the instant for every alarm sharing it, so each fires exactly once
+  int8_t fired = nextAlarm;
+  EpochTime fireTime = nextFireTime;
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    if (alarms[i].enabled && nextOccurrence(alarms[i], firedFor[i]) == fireTime)
+    {
+      firedFor[i] = fireTime;
+    }
+  }
+  recordsChanged = true;
+
+  reschedule();
+  return fired;
+}
+
+void AlarmScheduler::applyPending(EpochTime now)
+{
+  EpochTime floor = now > CATCH_UP_WINDOW ? now - CATCH_UP_WINDOW : 0;
+
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    // Records far ahead of the clock come from a date that was since
+    // corrected; they would otherwise silence the alarm until then
+    bool stale = firedFor[i] > now + Epoch::SECONDS_PER_DAY;
+
+    if (restored)
+    {
+      // After a power cycle, instants crossed while off are still fired if
+      // recent and older ones are dropped. Loading the table at boot is not
+      // an edit, so it does not consume anything.
+      if (stale || firedFor[i] < floor)
+      {
+        firedFor[i] = floor;
+      }
+    }
+    else if ((clockChanged || (editedMask & (1 << i))) && (stale || firedFor[i] < now))
+    {
+      // Instants skipped by setting the clock or editing the alarm are
+      // consumed rather than fired late. Setting the clock back keeps the
+      // record, so an alarm that already fired does not repeat.
+      firedFor[i] = now;
+      recordsChanged = true;
+    }
+  }
+
+  restored = false;
+  clockChanged = false;
+  editedMask = 0;
+}
+
+EpochTime AlarmScheduler::nextOccurrence(const AlarmData &alarm, EpochTime after) const
+{
+  EpochTime dayStart = Epoch::startOfDay(after);
+  uint32_t offset = Epoch::toSeconds({alarm.hour, alarm.minute, 0});
+
+  // A week and a day covers every mask, including today's slot having passed
+  for (uint8_t day = 0; day <= 7; day++)
+  {
+    EpochTime candidate = dayStart + day * Epoch::SECONDS_PER_DAY + offset;
+    if (candidate > after && (alarm.days & (1 << Epoch::dayOfWeek(candidate))))
+    {
+      return candidate;
+    }
+  }
+  return 0;
+}
+
+void AlarmScheduler::reschedule()
+{
+  nextAlarm = -1;
+  nextFireTime = 0;
+
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    if (!alarms[i].enabled || !(alarms[i].days & ALARM_EVERY_DAY))
+    {
+      continue;
+    }
+
+    EpochTime candidate = nextOccurrence(alarms[i], firedFor[i]);
+    if (candidate != 0 && (nextAlarm < 0 || candidate < nextFireTime))
+    {
+      nextAlarm = i;
+      nextFireTime = candidate;
+    }
+  }
+
+  dirty = false;
+}
@@ -1,8 +1,11 @@
 #include "Button.h"
+#include "Recorder.h"
+#include "EventBus.h"
+#include "Timebase.h"
 
 Button::Button(int pin) : pin(pin), lastState(false), currentState(false),
                           wasPressedFlag(false), wasSinglePressedFlag(false), wasLongPressedFlag(false),
-                          pressStartTime(0), lastDebounceTime(0)
+                          longPressPublished(false), pressStartTime(0), lastDebounceTime(0)
 {
 }
 
@@ -20,11 +23,12 @@ void Button::update()
   // Check if the switch changed
   if (reading != lastState)
   {
-    lastDebounceTime = millis();
+    RECORD_BUTTON(pin, reading);
+    lastDebounceTime = Timebase::millis();
   }
 
   // If enough time has passed since the last change
-  if ((millis() - lastDebounceTime) > debounceDelay)
+  if ((Timebase::millis() - lastDebounceTime) > debounceDelay)
   {
     // If the button state has changed
     if (reading != currentState)
@@ -34,27 +38,39 @@ void Button::update()
       if (currentState)
       {
         // Button pressed
-        pressStartTime = millis();
+        pressStartTime = Timebase::millis();
         wasPressedFlag = true;
+        longPressPublished = false;
+        publish(ButtonEvent{(uint8_t)pin, BUTTON_DOWN});
       }
       else
       {
         // Button released
-        unsigned long pressDuration = millis() - pressStartTime;
+        unsigned long pressDuration = Timebase::millis() - pressStartTime;
 
         if (pressDuration < longPressDelay && pressDuration > 50)
         {
           // Single press (between 50ms and 3 seconds)
           wasSinglePressedFlag = true;
+          publish(ButtonEvent{(uint8_t)pin, BUTTON_SINGLE});
+        }
+        else
+        {
+          publish(ButtonEvent{(uint8_t)pin, BUTTON_UP});
         }
       }
     }
   }
 
   // Check for long press
-  if (currentState && (millis() - pressStartTime) >= longPressDelay)
+  if (currentState && (Timebase::millis() - pressStartTime) >= longPressDelay)
   {
     wasLongPressedFlag = true;
+    if (!longPressPublished)
+    {
+      longPressPublished = true;
+      publish(ButtonEvent{(uint8_t)pin, BUTTON_LONG});
+    }
   }
 
   lastState = reading;
@@ -119,7 +135,7 @@ unsigned long Button::getPressDuration() const
 {
   if (currentState)
   {
-    return millis() - pressStartTime;
+    return Timebase::millis() - pressStartTime;
   }
   return 0;
 }
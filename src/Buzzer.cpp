@@ -1,60 +1,219 @@
 #include "Buzzer.h"
+#include "Timebase.h"
 
-Buzzer::Buzzer(int pin) : pin(pin), isPlaying(false), alarmStartTime(0) {
+// Melodies as (frequency Hz, duration ms), rests have frequency 0.
+// The classic pattern matches the old Arduino program: three 200ms beeps
+// at 1000Hz separated by 100ms, then 400ms of silence.
+const Note MELODY_CLASSIC_NOTES[] PROGMEM = {
+    {1000, 200}, {0, 100}, {1000, 200}, {0, 100}, {1000, 200}, {0, 400}, {0, 0}};
+
+const Note MELODY_FAST_NOTES[] PROGMEM = {
+    {1000, 200}, {0, 100}, {1000, 200}, {0, 100}, {1000, 200}, {0, 200}, {0, 0}};
+
+const Note MELODY_URGENT_NOTES[] PROGMEM = {
+    {2000, 100}, {0, 50}, {2000, 100}, {0, 50}, {2000, 100}, {0, 50}, {2000, 100}, {0, 250}, {0, 0}};
+
+const Note MELODY_CHIME_NOTES[] PROGMEM = {
+    {880, 150}, {988, 150}, {1319, 300}, {0, 150}, {1319, 150}, {1760, 450}, {0, 600}, {0, 0}};
+
+const Note *const MELODIES[MELODY_COUNT] PROGMEM = {
+    MELODY_CLASSIC_NOTES, MELODY_FAST_NOTES, MELODY_URGENT_NOTES, MELODY_CHIME_NOTES};
+
+const char MELODY_CLASSIC_NAME[] PROGMEM = "classic";
+const char MELODY_FAST_NAME[] PROGMEM = "fast";
+const char MELODY_URGENT_NAME[] PROGMEM = "urgent";
+const char MELODY_CHIME_NAME[] PROGMEM = "chime";
+
+const char *const MELODY_NAMES[MELODY_COUNT] PROGMEM = {
+    MELODY_CLASSIC_NAME, MELODY_FAST_NAME, MELODY_URGENT_NAME, MELODY_CHIME_NAME};
+
+#ifdef __AVR__
+// Timer1 runs at F_CPU / 8; a rest ticks every millisecond
+static const uint8_t TIMER1_PRESCALER = 8;
+static const uint16_t REST_TICK_TOP = F_CPU / TIMER1_PRESCALER / 1000 - 1;
+
+static Buzzer *activeBuzzer = nullptr;
+
+ISR(TIMER1_COMPA_vect) {
+  activeBuzzer->tick();
+}
+#endif
+
+Buzzer::Buzzer(int pin) : pin(pin), melody(nullptr), noteIndex(0), ticksLeft(0),
+                          isPlaying(false), isAlarm(false), looping(false) {
 }
 
 void Buzzer::begin() {
   pinMode(pin, OUTPUT);
   digitalWrite(pin, LOW);
+
+#ifdef __AVR__
+  activeBuzzer = this;
+  pinPort = portOutputRegister(digitalPinToPort(pin));
+  pinMask = digitalPinToBitMask(pin);
+  hardwareToggle = digitalPinToTimer(pin) == TIMER1A;
+  softToggle = false;
+
+  // Timer1 stopped, CTC mode with OCR1A as TOP
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12);
+  TIMSK1 = 0;
+#endif
 }
 
 void Buzzer::update() {
-  if (isPlaying) {
-    unsigned long currentMillis = millis();
-    unsigned long elapsed = currentMillis - alarmStartTime;
-    
-    // Match old Arduino program's alarm pattern exactly:
-    // 0-200ms: tone on
-    // 200-300ms: tone off  
-    // 300-500ms: tone on
-    // 500-600ms: tone off
-    // 600-800ms: tone on
-    // 800-1200ms: tone off (then repeat)
-    
-    if ((elapsed < 200) || ((elapsed > 300) && (elapsed < 500)) || ((elapsed > 600) && (elapsed < 800))) {
-      tone(pin, 1000); // 1000Hz like old program
-    } else {
-      noTone(pin);
-    }
-    
-    // Reset cycle after 1200ms
-    if (elapsed > 1200) {
-      alarmStartTime = currentMillis;
+#ifndef __AVR__
+  // No timer interrupt on the host: advance notes from the loop
+  while (isPlaying && (long)(Timebase::millis() - noteEndTime) >= 0) {
+    nextNote();
+  }
+#endif
+}
+
+void Buzzer::startNote(uint16_t frequency, uint16_t duration) {
+#ifdef __AVR__
+  uint16_t top;
+  if (frequency > 0) {
+    // Compare match every half period; each match toggles the pin.
+    // 16Hz is the lowest pitch the 16-bit counter can reach.
+    if (frequency < 16) {
+      frequency = 16;
     }
+    top = F_CPU / TIMER1_PRESCALER / 2 / frequency - 1;
+    // Timer1 runs off the resonator; stretch the count to true time
+    ticksLeft = Timebase::toRaw((uint32_t)duration * frequency / 500);
+    TCCR1A = hardwareToggle ? _BV(COM1A0) : 0;
+    softToggle = !hardwareToggle;
+  } else {
+    top = REST_TICK_TOP;
+    ticksLeft = Timebase::toRaw(duration);
+    TCCR1A = 0;
+    softToggle = false;
+    *pinPort &= ~pinMask;
+  }
+  if (ticksLeft == 0) {
+    ticksLeft = 1;
+  }
+
+  OCR1A = top;
+  TCNT1 = 0;
+  TCCR1B = _BV(WGM12) | _BV(CS11); // Start with prescaler 8
+  TIMSK1 = _BV(OCIE1A);
+#else
+  if (frequency > 0) {
+    tone(pin, frequency);
+  } else {
+    noTone(pin);
+  }
+  noteEndTime += duration; // Chained from the previous note, no drift
+#endif
+}
+
+void Buzzer::nextNote() {
+  if (melody == nullptr) {
+    halt();
+    return;
+  }
+
+  Note note;
+  memcpy_P(&note, &melody[noteIndex], sizeof(Note));
+  if (note.duration == 0 && looping && noteIndex > 0) {
+    noteIndex = 0;
+    memcpy_P(&note, &melody[0], sizeof(Note));
+  }
+
+  if (note.duration == 0) {
+    halt();
+    return;
+  }
+
+  noteIndex++;
+  startNote(note.frequency, note.duration);
+}
+
+void Buzzer::tick() {
+#ifdef __AVR__
+  if (softToggle) {
+    *pinPort ^= pinMask;
+  }
+#endif
+  if (--ticksLeft == 0) {
+    nextNote();
   }
 }
 
-void Buzzer::playAlarm() {
+void Buzzer::halt() {
+#ifdef __AVR__
+  TIMSK1 = 0;
+  TCCR1B = _BV(WGM12); // Stop the clock
+  TCCR1A = 0;
+  softToggle = false;
+  *pinPort &= ~pinMask;
+#else
+  noTone(pin);
+  digitalWrite(pin, LOW);
+#endif
+  isPlaying = false;
+  isAlarm = false;
+}
+
+void Buzzer::play(const Note *melody, bool loop) {
+  stopTone();
+  this->melody = melody;
+  looping = loop;
+  noteIndex = 0;
   isPlaying = true;
-  alarmStartTime = millis();
+#ifndef __AVR__
+  noteEndTime = Timebase::millis();
+#endif
+  nextNote();
+}
+
+void Buzzer::playMelody(uint8_t index, bool loop) {
+  if (index < MELODY_COUNT) {
+    play((const Note *)pgm_read_ptr(&MELODIES[index]), loop);
+  }
+}
+
+void Buzzer::playAlarm(uint8_t level) {
+  playMelody(level < MELODY_URGENT ? level : MELODY_URGENT, true);
+  isAlarm = true;
 }
 
 void Buzzer::stopAlarm() {
-  isPlaying = false;
   stopTone();
 }
 
 bool Buzzer::isAlarmPlaying() const {
+  return isPlaying && isAlarm;
+}
+
+bool Buzzer::isBusy() const {
   return isPlaying;
 }
 
+const __FlashStringHelper *Buzzer::getMelodyName(uint8_t index) {
+  if (index >= MELODY_COUNT) {
+    return nullptr;
+  }
+  return (const __FlashStringHelper *)pgm_read_ptr(&MELODY_NAMES[index]);
+}
+
 void Buzzer::playTone(int frequency, unsigned long duration) {
   if (frequency > 0) {
-    tone(pin, frequency, duration);
+    stopTone();
+    melody = nullptr;
+    isPlaying = true;
+#ifndef __AVR__
+    noteEndTime = Timebase::millis();
+#endif
+    startNote(frequency, duration > 0xFFFF ? 0xFFFF : duration);
   }
 }
 
 void Buzzer::stopTone() {
-  noTone(pin);
-  digitalWrite(pin, LOW);
-} 
\ No newline at end of file
+#ifdef __AVR__
+  TIMSK1 = 0; // Keep the interrupt out while the state is reset
+#endif
+  halt();
+}
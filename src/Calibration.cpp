@@ -0,0 +1,124 @@
+#include "Calibration.h"
+#include "Timebase.h"
+
+// Longest run of missed ticks still counted, e.g. behind a slow command
+static const uint8_t MAX_GAP = 4; // s
+
+Calibration::Calibration() : lastSecond(0), lastMicros(0), windowSeconds(0), windowError(0),
+                             estimate(0), saved(0), windows(0), valid(false), changed(false)
+{
+}
+
+void Calibration::update(EpochTime second, uint32_t edgeMicros)
+{
+  uint32_t seconds = second - lastSecond;
+  int32_t error = (int32_t)(edgeMicros - lastMicros - seconds * 1000000UL);
+  if (lastSecond == 0 || seconds == 0 || seconds > MAX_GAP ||
+      error > (int32_t)seconds * Timebase::MAX_PPM || error < -(int32_t)seconds * Timebase::MAX_PPM)
+  {
+    // Start a window at this edge
+    lastSecond = second;
+    lastMicros = edgeMicros;
+    windowSeconds = 0;
+    windowError = 0;
+    return;
+  }
+
+  lastSecond = second;
+  lastMicros = edgeMicros;
+  windowSeconds += seconds;
+  windowError += error;
+  if (windowSeconds < CALIBRATION_WINDOW)
+  {
+    return;
+  }
+
+  // us per s is ppm; rounded to the nearest
+  int32_t half = windowError < 0 ? -(int32_t)(windowSeconds / 2) : windowSeconds / 2;
+  int16_t measured = (windowError + half) / (int32_t)windowSeconds;
+  setEstimate(valid ? estimate + (measured - estimate) / 4 : measured);
+  if (windows < 255)
+  {
+    windows++;
+  }
+  windowSeconds = 0;
+  windowError = 0;
+}
+
+void Calibration::restart()
+{
+  lastSecond = 0;
+  windowSeconds = 0;
+  windowError = 0;
+}
+
+void Calibration::setEstimate(int16_t ppm)
+{
+  estimate = ppm;
+  valid = true;
+  Timebase::setCorrection(ppm);
+
+  // Persisted only on a real change: the resonator drifts a few ppm with
+  // temperature all day, and 20 ppm is under 2 s a day
+  int16_t step = estimate - saved;
+  if (step >= CALIBRATION_SAVE_STEP || step <= -CALIBRATION_SAVE_STEP)
+  {
+    saved = estimate;
+    changed = true;
+  }
+}
+
+void Calibration::restore(int16_t ppm)
+{
+  if (ppm > Timebase::MAX_PPM || ppm < -Timebase::MAX_PPM)
+  {
+    return;
+  }
+  estimate = ppm;
+  saved = ppm;
+  valid = true;
+  Timebase::setCorrection(ppm);
+}
+
+void Calibration::reset()
+{
+  restart();
+  estimate = 0;
+  saved = 0;
+  windows = 0;
+  valid = false;
+  changed = true;
+  Timebase::setCorrection(0);
+}
+
+bool Calibration::takeEstimateChanged()
+{
+  bool result = changed;
+  changed = false;
+  return result;
+}
+
+bool Calibration::hasEstimate() const
+{
+  return valid;
+}
+
+int16_t Calibration::getEstimate() const
+{
+  return estimate;
+}
+
+int16_t Calibration::getSaved() const
+{
+  return saved;
+}
+
+uint16_t Calibration::getWindowSeconds() const
+{
+  return windowSeconds;
+}
+
+uint8_t Calibration::getWindowCount() const
+{
+  return windows;
+}
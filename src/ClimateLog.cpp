@@ -0,0 +1,393 @@
+#include "ClimateLog.h"
+#include "EEPROMStorage.h"
+
+// Payload codes, one nibble each
+static const uint8_t CODE_UNCHANGED = 4;  // 0..8: (dT + 1) * 3 + (dH + 1)
+static const uint8_t CODE_RUN_FIRST = 9;  // 9..13: 2..6 samples unchanged
+static const uint8_t CODE_RUN_LAST = 13;
+static const uint8_t CODE_ESCAPE = 14;    // Then zig-zag varints of dT and dH
+static const uint8_t CODE_END = 15;       // Erased
+static const uint8_t MAX_RUN = CODE_RUN_LAST - CODE_RUN_FIRST + 2;
+static const uint8_t VARINT_MORE = 0x08;
+static const uint8_t PAYLOAD_NIBBLES = CLIMATE_PAYLOAD_BYTES * 2;
+
+ClimateLog::ClimateLog() : interval(CLIMATE_DEFAULT_INTERVAL), block(NO_BLOCK), sequence(0), open(false),
+                           nibble(0), runNibble(NO_BLOCK), run(0), lastTime(0), temperature(0),
+                           humidity(0), latest{0, 0, 0}, fresh(false)
+{
+}
+
+void ClimateLog::begin()
+{
+  EEPROMStorage eeprom;
+  uint8_t minutes;
+  interval = eeprom.loadClimateInterval(minutes) ? minutes : CLIMATE_DEFAULT_INTERVAL;
+  scan();
+}
+
+bool ClimateLog::isValid(const ClimateHeader &header)
+{
+  // Erased cells read 0xFF, cleared ones 0
+  return header.sequence >= 1 && header.sequence <= CLIMATE_SEQUENCE_MAX &&
+         header.interval >= 1 && header.interval <= CLIMATE_MAX_INTERVAL;
+}
+
+void ClimateLog::scan()
+{
+  // The newest block is the valid one its successor does not follow on
+  EEPROMStorage eeprom;
+  ClimateHeader header;
+  ClimateHeader following;
+  block = NO_BLOCK;
+  sequence = 0;
+  open = false;
+  for (uint8_t i = 0; i < CLIMATE_BLOCKS; i++)
+  {
+    eeprom.readClimateHeader(i, header);
+    if (!isValid(header))
+    {
+      continue;
+    }
+    eeprom.readClimateHeader((i + 1) % CLIMATE_BLOCKS, following);
+    uint8_t after = header.sequence >= CLIMATE_SEQUENCE_MAX ? 1 : header.sequence + 1;
+    if (!isValid(following) || following.sequence != after)
+    {
+      block = i;
+      sequence = header.sequence;
+      break;
+    }
+  }
+  if (block == NO_BLOCK)
+  {
+    return;
+  }
+
+  // Go on after its last sample, if it was taken at the same interval
+  ClimateSample last;
+  uint16_t samples;
+  nibble = measure(block, last, samples);
+  runNibble = NO_BLOCK;
+  lastTime = last.time;
+  temperature = last.temperature;
+  humidity = last.humidity;
+  open = header.interval == interval;
+}
+
+uint8_t ClimateLog::measure(uint8_t block, ClimateSample &last, uint16_t &samples) const
+{
+  // Where the codes end is where the cursor was before the call that found
+  // no more
+  ClimateCursor cursor = {block, 1, NO_BLOCK, 0, 0, {0, 0, 0}};
+  uint8_t end = NO_BLOCK;
+  samples = 0;
+  while (true)
+  {
+    end = cursor.nibble;
+    if (!next(cursor, last))
+    {
+      break;
+    }
+    samples++;
+  }
+  return samples > 0 ? end : NO_BLOCK;
+}
+
+void ClimateLog::onSample(const SensorSample &sample)
+{
+  latest.temperature = sample.temperature;
+  latest.humidity = sample.humidity;
+  fresh = true;
+}
+
+void ClimateLog::onMinute(const MinuteTick &tick)
+{
+  if (interval == 0 || !fresh)
+  {
+    return; // Off, or no reading since the last sample: a gap
+  }
+  store(tick.unixTime);
+}
+
+void ClimateLog::store(EpochTime now)
+{
+  uint32_t step = interval * Epoch::SECONDS_PER_MINUTE;
+  if (open)
+  {
+    EpochTime due = lastTime + step;
+    if (now >= lastTime && now < due)
+    {
+      return;
+    }
+    // Late by less than an interval, e.g. a minute tick missed behind a
+    // slow command: still this slot
+    if (now >= due && now - due < step && append(latest.temperature, latest.humidity))
+    {
+      lastTime = due;
+      fresh = false;
+      return;
+    }
+    // Full, a gap, or the clock was set back
+    open = false;
+  }
+
+  // New blocks start on whole intervals, so the sample times line up
+  if ((now / Epoch::SECONDS_PER_MINUTE) % interval == 0)
+  {
+    openBlock(now);
+    fresh = false;
+  }
+}
+
+bool ClimateLog::append(int8_t temperature, int8_t humidity)
+{
+  int16_t dt = temperature - this->temperature;
+  int16_t dh = humidity - this->humidity;
+
+  if (dt == 0 && dh == 0 && runNibble != NO_BLOCK && run < MAX_RUN)
+  {
+    // One more in the run: the code is rewritten in place
+    run++;
+    writeNibble(runNibble, CODE_RUN_FIRST + run - 2);
+    return true;
+  }
+
+  if (dt >= -1 && dt <= 1 && dh >= -1 && dh <= 1)
+  {
+    if (nibble >= PAYLOAD_NIBBLES)
+    {
+      return false;
+    }
+    uint8_t code = (dt + 1) * 3 + (dh + 1);
+    runNibble = code == CODE_UNCHANGED ? nibble : NO_BLOCK;
+    run = 1;
+    writeNibble(nibble++, code);
+  }
+  else
+  {
+    uint16_t zt = zigzag(dt);
+    uint16_t zh = zigzag(dh);
+    if (nibble + 1 + varintNibbles(zt) + varintNibbles(zh) > PAYLOAD_NIBBLES)
+    {
+      return false;
+    }
+    runNibble = NO_BLOCK;
+    writeNibble(nibble++, CODE_ESCAPE);
+    writeVarint(zt);
+    writeVarint(zh);
+  }
+  this->temperature = temperature;
+  this->humidity = humidity;
+  return true;
+}
+
+void ClimateLog::openBlock(EpochTime now)
+{
+  block = block == NO_BLOCK ? 0 : (block + 1) % CLIMATE_BLOCKS;
+  sequence = sequence >= CLIMATE_SEQUENCE_MAX ? 1 : sequence + 1;
+
+  EEPROMStorage eeprom;
+  eeprom.eraseClimateBlock(block);
+  eeprom.writeClimateHeader(block, {now, latest.temperature, latest.humidity, interval, sequence});
+  open = true;
+  nibble = 0;
+  runNibble = NO_BLOCK;
+  lastTime = now;
+  temperature = latest.temperature;
+  humidity = latest.humidity;
+}
+
+void ClimateLog::writeNibble(uint8_t index, uint8_t code)
+{
+  // Low nibble first; the other half of the byte is kept
+  EEPROMStorage eeprom;
+  uint8_t value = eeprom.readClimateByte(block, index / 2);
+  if (index & 1)
+  {
+    value = (value & 0x0F) | code << 4;
+  }
+  else
+  {
+    value = (value & 0xF0) | code;
+  }
+  eeprom.writeClimateByte(block, index / 2, value);
+}
+
+uint8_t ClimateLog::readNibble(uint8_t block, uint8_t index)
+{
+  EEPROMStorage eeprom;
+  uint8_t value = eeprom.readClimateByte(block, index / 2);
+  return index & 1 ? value >> 4 : value & 0x0F;
+}
+
+void ClimateLog::writeVarint(uint16_t value)
+{
+  // 3 bits to the nibble, low bits first, bit 3 set while more follow
+  do
+  {
+    uint8_t bits = value & 0x07;
+    value >>= 3;
+    writeNibble(nibble++, value ? bits | VARINT_MORE : bits);
+  } while (value);
+}
+
+uint8_t ClimateLog::varintNibbles(uint16_t value)
+{
+  uint8_t count = 1;
+  while (value >>= 3)
+  {
+    count++;
+  }
+  return count;
+}
+
+uint16_t ClimateLog::zigzag(int16_t value)
+{
+  return value < 0 ? ((uint16_t)~value << 1) | 1 : (uint16_t)value << 1;
+}
+
+int16_t ClimateLog::unzigzag(uint16_t value)
+{
+  return value & 1 ? ~(int16_t)(value >> 1) : (int16_t)(value >> 1);
+}
+
+void ClimateLog::setInterval(uint8_t minutes)
+{
+  interval = minutes;
+  open = false;
+  EEPROMStorage eeprom;
+  eeprom.saveClimateInterval(minutes);
+}
+
+uint8_t ClimateLog::getInterval() const
+{
+  return interval;
+}
+
+void ClimateLog::rewind(ClimateCursor &cursor) const
+{
+  // Oldest first: the block after the newest, then round the ring
+  cursor.block = block == NO_BLOCK ? 0 : (block + 1) % CLIMATE_BLOCKS;
+  cursor.left = block == NO_BLOCK ? 0 : CLIMATE_BLOCKS;
+  cursor.nibble = NO_BLOCK;
+  cursor.run = 0;
+}
+
+bool ClimateLog::next(ClimateCursor &cursor, ClimateSample &sample) const
+{
+  EEPROMStorage eeprom;
+  while (true)
+  {
+    if (cursor.run > 0)
+    {
+      cursor.run--;
+      cursor.sample.time += cursor.interval * Epoch::SECONDS_PER_MINUTE;
+      sample = cursor.sample;
+      return true;
+    }
+
+    if (cursor.nibble == NO_BLOCK)
+    {
+      // A block starts with its first sample in full
+      if (cursor.left == 0)
+      {
+        return false;
+      }
+      cursor.left--;
+      ClimateHeader header;
+      eeprom.readClimateHeader(cursor.block, header);
+      if (!isValid(header))
+      {
+        cursor.block = (cursor.block + 1) % CLIMATE_BLOCKS;
+        continue;
+      }
+      cursor.nibble = 0;
+      cursor.interval = header.interval;
+      cursor.sample = {header.time, header.temperature, header.humidity};
+      sample = cursor.sample;
+      return true;
+    }
+
+    uint8_t code = cursor.nibble < PAYLOAD_NIBBLES ? readNibble(cursor.block, cursor.nibble) : CODE_END;
+    if (code == CODE_END)
+    {
+      cursor.block = (cursor.block + 1) % CLIMATE_BLOCKS;
+      cursor.nibble = NO_BLOCK;
+      continue;
+    }
+    cursor.nibble++;
+
+    int16_t dt = 0;
+    int16_t dh = 0;
+    if (code < CODE_RUN_FIRST)
+    {
+      dt = code / 3 - 1;
+      dh = code % 3 - 1;
+    }
+    else if (code <= CODE_RUN_LAST)
+    {
+      cursor.run = code - CODE_RUN_FIRST + 1; // Returned after this one
+    }
+    else
+    {
+      // Escape: two varints, cut short by the end of the block if torn
+      for (uint8_t i = 0; i < 2; i++)
+      {
+        uint16_t value = 0;
+        uint8_t shift = 0;
+        uint8_t bits = VARINT_MORE;
+        while ((bits & VARINT_MORE) && cursor.nibble < PAYLOAD_NIBBLES && shift < 16)
+        {
+          bits = readNibble(cursor.block, cursor.nibble++);
+          value |= (uint16_t)(bits & 0x07) << shift;
+          shift += 3;
+        }
+        (i == 0 ? dt : dh) = unzigzag(value);
+      }
+    }
+    cursor.sample.time += cursor.interval * Epoch::SECONDS_PER_MINUTE;
+    cursor.sample.temperature += dt;
+    cursor.sample.humidity += dh;
+    sample = cursor.sample;
+    return true;
+  }
+}
+
+ClimateStats ClimateLog::getStats() const
+{
+  ClimateStats stats = {0, 0, 0, 0};
+  if (block == NO_BLOCK)
+  {
+    return stats;
+  }
+  EEPROMStorage eeprom;
+  uint8_t index = (block + 1) % CLIMATE_BLOCKS;
+  for (uint8_t i = 0; i < CLIMATE_BLOCKS; i++)
+  {
+    ClimateSample last;
+    uint16_t samples;
+    uint8_t end = measure(index, last, samples);
+    if (end != NO_BLOCK)
+    {
+      if (stats.samples == 0)
+      {
+        ClimateHeader header;
+        eeprom.readClimateHeader(index, header);
+        stats.first = header.time;
+      }
+      stats.samples += samples;
+      stats.bytes += sizeof(ClimateHeader) + (end + 1) / 2;
+      stats.last = last.time;
+    }
+    index = (index + 1) % CLIMATE_BLOCKS;
+  }
+  return stats;
+}
+
+void ClimateLog::clear()
+{
+  EEPROMStorage eeprom;
+  eeprom.eraseClimate();
+  block = NO_BLOCK;
+  sequence = 0;
+  open = false;
+}
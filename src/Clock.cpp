@@ -3,43 +3,96 @@
 #include "HTSensor.h"
 #include "Buzzer.h"
 #include "EEPROMStorage.h"
+#include "Format.h"
 
 // PROGMEM constants to save RAM
 const char PROGMEM DEGREE_SYMBOL = '*';
 const char PROGMEM TEMP_UNIT = 'C';
 const char PROGMEM HUMIDITY_UNIT = 'H';
 
-Clock::Clock() : rtc(nullptr), dht11(nullptr), buzzer(nullptr)
+static_assert(MAX_ALARMS <= 4, "DRAFT_ALARM bits must fit in SettingsDraft::changed");
+
+Clock::Clock() : rtc(nullptr), dht11(nullptr), buzzer(nullptr), draft()
 {
 }
 
-void Clock::begin(RTClock *rtc, HTSensor *dht11, Buzzer *buzzer)
+void Clock::begin(RTClock *rtc, HTSensor *dht11, Buzzer *buzzer, Scheduler *scheduler)
 {
   this->rtc = rtc;
   this->dht11 = dht11;
   this->buzzer = buzzer;
-  timer.begin();
+  timer.begin(scheduler);
   alarm.begin(buzzer);
 }
 
 void Clock::update()
 {
-  // Update timer
-  timer.update();
+  // Pick up a new second from the RTC; SecondTick does the rest
+  rtc->update();
+
+  if (buzzer)
+  {
+    buzzer->update();
+  }
+}
+
+void Clock::onSecondTick(const SecondTick &tick)
+{
+  // Alarms only move when the time does. They are set in local time, so
+  // a DST change moves them with the wall clock.
+  alarm.update(zone.toLocal(tick.unixTime));
 
-  // Update alarm
-  Time currentTime = rtc->getTime();
-  alarm.update(currentTime);
+  // Polled seconds are up to RTC_POLL_INTERVAL late, too rough to measure
+  if (rtc->hasSquareWave())
+  {
+    calibration.update(tick.unixTime, rtc->getSecondMicros());
+    if (calibration.takeEstimateChanged())
+    {
+      saveCalibration();
+    }
+  }
+
+  // Persist fire records as soon as they change so a power cycle can
+  // neither repeat nor lose an alarm
+  if (alarm.takeRecordsChanged())
+  {
+    saveAlarmRecords();
+  }
 }
 
 Time Clock::getTime() const
 {
-  return rtc->getTime();
+  return Epoch::toTime(getLocalTime());
 }
 
 Date Clock::getDate() const
 {
-  return rtc->getDate();
+  return Epoch::toDate(getLocalTime());
+}
+
+EpochTime Clock::getUnixTime() const
+{
+  return rtc->getUnixTime();
+}
+
+uint32_t Clock::getSecondMicros() const
+{
+  return rtc->getSecondMicros();
+}
+
+uint16_t Clock::getBusRecoveries() const
+{
+  return rtc->getBusRecoveries();
+}
+
+bool Clock::isTimeLost() const
+{
+  return rtc->isTimeLost();
+}
+
+EpochTime Clock::getLocalTime() const
+{
+  return zone.toLocal(rtc->getUnixTime());
 }
 
 TimerData Clock::getTimerTime()
@@ -57,210 +110,385 @@ int8_t Clock::getHumidity() const
   return dht11->getHumidity();
 }
 
-char *Clock::getTimeString() const
+char *Clock::getTimeString(char *text) const
 {
-  static char timeString[6];
-  Time currentTime = rtc->getTime();
+  Time currentTime = getTime();
+  Format::display(text, currentTime.hour, currentTime.minute, currentTime.second);
+  return text;
+}
 
-  timeString[0] = '0' + currentTime.hour / 10;
-  timeString[1] = '0' + currentTime.hour % 10;
-  timeString[2] = '0' + currentTime.minute / 10;
-  timeString[3] = '0' + currentTime.minute % 10;
-  timeString[4] = '0' + currentTime.second / 10;
-  timeString[5] = '0' + currentTime.second % 10;
-  return timeString;
+char *Clock::getDateString(char *text) const
+{
+  Date currentDate = getDate();
+  Format::display(text, currentDate.day, currentDate.month, currentDate.year % 100);
+  return text;
 }
 
-char *Clock::getDateString() const
+char *Clock::getAlarmTimeString(char *text) const
 {
-  static char dateString[6];
-  static unsigned long lastDateUpdate = 0;
-  static Date cachedDate = {1, 1, 2024};
+  // Show the next alarm due, or the first one when none is scheduled
+  int8_t next = alarm.getNextAlarm();
+  return getAlarmTimeString(text, next >= 0 ? next : 0);
+}
 
-  // Cache date for 1 second to avoid multiple RTC calls
-  unsigned long currentMillis = millis();
-  if (currentMillis - lastDateUpdate >= 1000)
-  {
-    cachedDate = rtc->getDate();
-    lastDateUpdate = currentMillis;
-  }
+char *Clock::getAlarmTimeString(char *text, uint8_t index) const
+{
+  formatAlarm(text, index, alarm.getTime(index));
+  return text;
+}
 
-  dateString[0] = '0' + cachedDate.day / 10;
-  dateString[1] = '0' + cachedDate.day % 10;
-  dateString[2] = '0' + cachedDate.month / 10;
-  dateString[3] = '0' + cachedDate.month % 10;
-  dateString[4] = '0' + (cachedDate.year % 100) / 10;
-  dateString[5] = '0' + (cachedDate.year % 100) % 10;
-  return dateString;
+char *Clock::getTimerString(char *text) const
+{
+  TimerData timerData = timer.getTime();
+  Format::display(text, timerData.hour, timerData.minute, timerData.second);
+  return text;
 }
 
-char *Clock::getAlarmTimeString() const
+void Clock::formatAlarm(char *text, uint8_t index, const AlarmData &alarmData)
 {
-  static char alarmString[6];
-  AlarmData alarmData = alarm.getTime();
-  alarmString[0] = '0' + alarmData.hour / 10;
-  alarmString[1] = '0' + alarmData.hour % 10;
-  alarmString[2] = '0' + alarmData.minute / 10;
-  alarmString[3] = '0' + alarmData.minute % 10;
-  alarmString[4] = '0';
-  alarmString[5] = '0';
-  return alarmString;
+  Format::display(text, alarmData.hour, alarmData.minute, 0);
+  text[4] = '1' + index;
+
+  // Day preset: A = every day, d = weekdays, E = weekend, C = custom
+  if (!alarmData.enabled)
+    text[5] = ' ';
+  else if (alarmData.days == ALARM_EVERY_DAY)
+    text[5] = 'A';
+  else if (alarmData.days == ALARM_WEEKDAYS)
+    text[5] = 'd';
+  else if (alarmData.days == ALARM_WEEKEND)
+    text[5] = 'E';
+  else
+    text[5] = 'C';
 }
 
-char *Clock::getTimerString() const
+// Two digits right-aligned, a minus before them if below zero, then the unit
+void Clock::formatClimate(char *text, int8_t value, char unit)
 {
-  static char timerString[6];
-  TimerData timerData = timer.getTime();
-  timerString[0] = '0' + timerData.hour / 10;
-  timerString[1] = '0' + timerData.hour % 10;
-  timerString[2] = '0' + timerData.minute / 10;
-  timerString[3] = '0' + timerData.minute % 10;
-  timerString[4] = '0' + timerData.second / 10;
-  timerString[5] = '0' + timerData.second % 10;
-  return timerString;
+  text[0] = ' ';
+  text[1] = value < 0 ? '-' : ' ';
+  Format::twoDigits(text + 2, value < 0 ? -value : value);
+  text[4] = DEGREE_SYMBOL;
+  text[5] = unit;
 }
 
-char *Clock::getTemperatureString() const
+char *Clock::getTemperatureString(char *text) const
 {
-  static char temperatureString[6];
-  temperatureString[0] = ' ';
-  temperatureString[1] = ' ';
-  temperatureString[2] = '0' + getTemperature() / 10;
-  temperatureString[3] = '0' + getTemperature() % 10;
-  temperatureString[4] = DEGREE_SYMBOL;
-  temperatureString[5] = TEMP_UNIT;
-  return temperatureString;
+  formatClimate(text, getTemperature(), TEMP_UNIT);
+  return text;
 }
 
-char *Clock::getHumidityString() const
+char *Clock::getHumidityString(char *text) const
 {
-  static char humidityString[6];
-  humidityString[0] = ' ';
-  humidityString[1] = ' ';
-  humidityString[2] = '0' + getHumidity() / 10;
-  humidityString[3] = '0' + getHumidity() % 10;
-  humidityString[4] = DEGREE_SYMBOL;
-  humidityString[5] = HUMIDITY_UNIT;
-  return humidityString;
+  formatClimate(text, getHumidity(), HUMIDITY_UNIT);
+  return text;
 }
 
-AlarmData Clock::getAlarmTime()
+AlarmData Clock::getAlarmTime(uint8_t index)
 {
-  return alarm.getTime();
+  return alarm.getTime(index);
 }
 
-void Clock::adjustSetting(int setting, int part)
+void Clock::beginSettings()
 {
-  switch (setting)
+  // A time or date the RTC failed to take is still pending: start from it
+  draft.changed &= DRAFT_TIME | DRAFT_DATE;
+  if (draft.changed == 0)
   {
-  case 0: // Time
+    draft.offset = 0;
+  }
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
   {
-    Time currentTime = rtc->getTime();
-    switch (part)
-    {
-    case 0: // Hour
-      currentTime.hour = (currentTime.hour + 1) % 24;
-      if (rtc)
-        rtc->setTime(currentTime);
-      break;
-    case 1: // Minute
-      currentTime.minute = (currentTime.minute + 1) % 60;
-      if (rtc)
-        rtc->setTime(currentTime);
-      break;
-    case 2: // Second
-      currentTime.second = (currentTime.second + 1) % 60;
-      if (rtc)
-        rtc->setTime(currentTime);
-      break;
-    }
+    draft.alarms[i] = alarm.getTime(i);
   }
-  break;
+  draft.timer = {timer.getHour(), timer.getMinute(), timer.getSecond()};
+}
 
-  case 1: // Date
+// Off -> every day -> weekdays -> weekend -> off
+static void cycleDays(AlarmData &alarmData)
+{
+  if (!alarmData.enabled)
   {
-    Date currentDate = rtc->getDate();
-    switch (part)
+    alarmData.enabled = true;
+    alarmData.days = ALARM_EVERY_DAY;
+  }
+  else if (alarmData.days == ALARM_EVERY_DAY)
+  {
+    alarmData.days = ALARM_WEEKDAYS;
+  }
+  else if (alarmData.days == ALARM_WEEKDAYS)
+  {
+    alarmData.days = ALARM_WEEKEND;
+  }
+  else
+  {
+    alarmData.enabled = false;
+  }
+}
+
+void Clock::adjustSetting(uint8_t setting, uint8_t part)
+{
+  // Part 0, 1, 2 steps the first, second or third field of the page by one,
+  // wrapping within the field
+  switch (setting)
+  {
+  case SETTING_TIME:
+  case SETTING_DATE:
+  {
+    EpochTime shown = getDraftTime();
+    Date date = Epoch::toDate(shown);
+    Time time = Epoch::toTime(shown);
+    if (setting == SETTING_TIME)
     {
-    case 0: // Day
-      currentDate.day = (currentDate.day % 31) + 1;
-      if (rtc)
-        rtc->setDate(currentDate);
-      break;
-    case 1: // Month
-      currentDate.month = (currentDate.month % 12) + 1;
-      if (rtc)
-        rtc->setDate(currentDate);
-      break;
-    case 2: // Year
-      currentDate.year = (currentDate.year % 100) + 2024;
-      if (rtc)
-        rtc->setDate(currentDate);
-      break;
+      switch (part)
+      {
+      case 0: // Hour
+        time.hour = (time.hour + 1) % 24;
+        break;
+      case 1: // Minute
+        time.minute = (time.minute + 1) % 60;
+        break;
+      default: // Second
+        time.second = (time.second + 1) % 60;
+        break;
+      }
     }
+    else
+    {
+      switch (part)
+      {
+      case 0: // Day, within the month
+        date.day = date.day < Epoch::daysInMonth(date.year, date.month) ? date.day + 1 : 1;
+        break;
+      case 1: // Month
+        date.month = date.month % 12 + 1;
+        break;
+      default: // Year, within the DS1307's range
+        date.year = date.year < 2099 ? date.year + 1 : 2000;
+        break;
+      }
+      // 31 March to April is 30 April, 29 February to 2025 is the 28th
+      uint8_t lastDay = Epoch::daysInMonth(date.year, date.month);
+      if (date.day > lastDay)
+      {
+        date.day = lastDay;
+      }
+    }
+    draft.offset = (int32_t)(Epoch::fromFields(date, time) - getLocalTime());
+    draft.changed |= setting == SETTING_TIME ? DRAFT_TIME : DRAFT_DATE;
   }
   break;
 
-  case 2: // Alarm
+  case SETTING_TIMER:
     switch (part)
     {
     case 0: // Hour
-      alarm.adjustHour();
+      draft.timer.hour = (draft.timer.hour + 1) % 24;
       break;
     case 1: // Minute
-      alarm.adjustMinute();
+      draft.timer.minute = (draft.timer.minute + 1) % 60;
       break;
-    case 2: // Enable/Disable
-      if (alarm.isEnabled())
-        alarm.disable();
-      else
-        alarm.enable();
+    default: // Second
+      draft.timer.second = (draft.timer.second + 1) % 60;
       break;
     }
+    draft.changed |= DRAFT_TIMER;
     break;
-  case 3: // Timer
-    switch (part)
+
+  default: // Alarm pages
+    if (setting >= SETTING_ALARM && setting < SETTING_TIMER)
     {
-    case 0: // Hour
-      timer.adjustHour();
-      break;
-    case 1: // Minute
-      timer.adjustMinute();
-      break;
-    case 2: // Second
-      timer.adjustSecond();
-      break;
+      uint8_t index = setting - SETTING_ALARM;
+      AlarmData &alarmData = draft.alarms[index];
+      switch (part)
+      {
+      case 0: // Hour
+        alarmData.hour = (alarmData.hour + 1) % 24;
+        break;
+      case 1: // Minute
+        alarmData.minute = (alarmData.minute + 1) % 60;
+        break;
+      default: // Off / every day / weekdays / weekend
+        cycleDays(alarmData);
+        break;
+      }
+      draft.changed |= DRAFT_ALARM << index;
     }
     break;
   }
 }
 
+char *Clock::getSettingString(char *text, uint8_t setting) const
+{
+  switch (setting)
+  {
+  case SETTING_TIME:
+  {
+    Time shown = Epoch::toTime(getDraftTime());
+    Format::display(text, shown.hour, shown.minute, shown.second);
+  }
+  break;
+  case SETTING_DATE:
+  {
+    Date shown = Epoch::toDate(getDraftTime());
+    Format::display(text, shown.day, shown.month, shown.year % 100);
+  }
+  break;
+  case SETTING_TIMER:
+    Format::display(text, draft.timer.hour, draft.timer.minute, draft.timer.second);
+    break;
+  default: // Alarm pages
+    formatAlarm(text, setting - SETTING_ALARM, draft.alarms[setting - SETTING_ALARM]);
+    break;
+  }
+  return text;
+}
+
+EpochTime Clock::getDraftTime() const
+{
+  return getLocalTime() + draft.offset;
+}
+
+bool Clock::setLocalTime(EpochTime local)
+{
+  return setUnixTime(zone.toUtc(local));
+}
+
+bool Clock::setUnixTime(EpochTime time)
+{
+  if (!rtc->setUnixTime(time))
+  {
+    return false;
+  }
+  alarm.clockAdjusted();
+  calibration.restart();
+  publish(SettingsChanged{SETTINGS_CLOCK});
+  return true;
+}
+
+bool Clock::commitSettings()
+{
+  if (draft.changed == 0)
+  {
+    return true;
+  }
+
+  // Time and date in one RTC write. If it fails they stay in the draft for
+  // the next settings session; the rest is applied either way.
+  uint8_t pending = 0;
+  if (draft.changed & (DRAFT_TIME | DRAFT_DATE))
+  {
+    if (!setLocalTime(getDraftTime()))
+    {
+      pending = draft.changed & (DRAFT_TIME | DRAFT_DATE);
+    }
+  }
+
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    if (draft.changed & (DRAFT_ALARM << i))
+    {
+      alarm.setData(i, draft.alarms[i]);
+      if (!draft.alarms[i].enabled)
+      {
+        alarm.disable(i); // Also silences it
+      }
+    }
+  }
+
+  if (draft.changed & DRAFT_TIMER)
+  {
+    timer.setTime(draft.timer.hour, draft.timer.minute, draft.timer.second);
+  }
+
+  // The time was announced with its RTC write
+  uint8_t items = (draft.changed & DRAFT_TIMER ? SETTINGS_TIMER : 0) |
+                  (draft.changed >= DRAFT_ALARM ? SETTINGS_ALARMS : 0);
+  if (items)
+  {
+    publish(SettingsChanged{items});
+  }
+
+  draft.changed = pending;
+  saveSettings();
+  return pending == 0;
+}
+
+void Clock::cancelSettings()
+{
+  draft.changed = 0;
+}
+
 void Clock::loadSettings()
 {
   EEPROMStorage eeprom;
+  uint8_t zoneIndex;
+  if (eeprom.loadTimeZone(zoneIndex))
+  {
+    zone.select(zoneIndex);
+  }
+  int16_t ppm;
+  if (eeprom.loadCalibration(ppm))
+  {
+    calibration.restore(ppm);
+  }
+
   if (eeprom.hasValidSettings())
   {
-    Time currentTime = rtc->getTime();
-    Date currentDate = rtc->getDate();
-    AlarmData alarmData;
-    eeprom.loadSettings(currentTime, currentDate, alarmData);
-    alarm.setTime(alarmData.hour, alarmData.minute);
-    if (alarmData.enabled)
+    Time currentTime;
+    Date currentDate;
+    AlarmData alarms[MAX_ALARMS];
+    SnoozeConfig snooze;
+    if (eeprom.loadSettings(currentTime, currentDate, alarms, snooze))
     {
-      alarm.enable();
-    }
-    else
-    {
-      alarm.disable();
+      for (uint8_t i = 0; i < MAX_ALARMS; i++)
+      {
+        alarm.setData(i, alarms[i]);
+      }
+      alarm.setSnooze(snooze);
     }
   }
+
+  uint32_t records[MAX_ALARMS];
+  if (eeprom.loadAlarmRecords(records))
+  {
+    alarm.restoreFiredFor(records);
+  }
 }
 
 void Clock::saveSettings()
 {
   EEPROMStorage eeprom;
-  AlarmData alarmData = alarm.getTime();
-  eeprom.saveSettings(rtc->getTime(), rtc->getDate(), alarmData);
+  AlarmData alarms[MAX_ALARMS];
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    alarms[i] = alarm.getTime(i);
+  }
+  eeprom.saveSettings(getTime(), getDate(), alarms, alarm.getSnooze());
+}
+
+void Clock::saveCalibration()
+{
+  EEPROMStorage eeprom;
+  if (calibration.hasEstimate())
+  {
+    eeprom.saveCalibration(calibration.getSaved());
+  }
+  else
+  {
+    eeprom.clearCalibration();
+  }
+}
+
+void Clock::saveAlarmRecords()
+{
+  EEPROMStorage eeprom;
+  uint32_t records[MAX_ALARMS];
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    records[i] = alarm.getFiredFor(i);
+  }
+  eeprom.saveAlarmRecords(records);
 }
 
 bool Clock::isAlarmTriggered() const
@@ -268,9 +496,54 @@ bool Clock::isAlarmTriggered() const
   return alarm.isTriggered();
 }
 
-void Clock::stopAlarm()
+AlarmState Clock::getAlarmState() const
+{
+  return alarm.getState();
+}
+
+uint8_t Clock::getAlarmSnoozeCount() const
+{
+  return alarm.getSnoozeCount();
+}
+
+void Clock::snoozeAlarm()
 {
-  alarm.stop();
+  alarm.snooze();
+}
+
+void Clock::dismissAlarm()
+{
+  alarm.dismiss();
+}
+
+void Clock::setAlarmSnooze(const SnoozeConfig &config)
+{
+  alarm.setSnooze(config);
+  alarmsChanged();
+}
+
+SnoozeConfig Clock::getAlarmSnooze() const
+{
+  return alarm.getSnooze();
+}
+
+bool Clock::previewMelody(uint8_t index)
+{
+  // A ringing alarm owns the buzzer
+  if (!buzzer || alarm.getState() == ALARM_RINGING || index >= MELODY_COUNT)
+  {
+    return false;
+  }
+  buzzer->playMelody(index);
+  return true;
+}
+
+void Clock::stopMelody()
+{
+  if (buzzer && alarm.getState() != ALARM_RINGING)
+  {
+    buzzer->stopTone();
+  }
 }
 
 void Clock::startTimer()
@@ -288,45 +561,102 @@ void Clock::resetTimer()
   timer.reset();
 }
 
-void Clock::setAlarmTime(uint8_t hour, uint8_t minute)
+void Clock::setAlarmTime(uint8_t index, uint8_t hour, uint8_t minute)
 {
-  alarm.setTime(hour, minute);
+  alarm.setTime(index, hour, minute);
+  alarmsChanged();
 }
 
-void Clock::enableAlarm()
+void Clock::setAlarmDays(uint8_t index, uint8_t days)
 {
-  alarm.enable();
+  alarm.setDays(index, days);
+  alarmsChanged();
 }
 
-void Clock::disableAlarm()
+void Clock::enableAlarm(uint8_t index)
 {
-  alarm.disable();
+  alarm.enable(index);
+  alarmsChanged();
 }
 
-void Clock::setAlarmData(const AlarmData &alarmData)
+void Clock::disableAlarm(uint8_t index)
 {
-  alarm.setTime(alarmData.hour, alarmData.minute);
-  if (alarmData.enabled)
-  {
-    alarm.enable();
-  }
-  else
-  {
-    alarm.disable();
-  }
+  alarm.disable(index);
+  alarmsChanged();
+}
+
+void Clock::setAlarmData(uint8_t index, const AlarmData &alarmData)
+{
+  alarm.setData(index, alarmData);
+  alarmsChanged();
+}
+
+void Clock::alarmsChanged()
+{
+  // Saved at once: an edit from the serial port has no settings mode exit
+  // to save it
+  saveSettings();
+  publish(SettingsChanged{SETTINGS_ALARMS});
+}
+
+int8_t Clock::getNextAlarm() const
+{
+  return alarm.getNextAlarm();
+}
+
+uint32_t Clock::getNextAlarmTime() const
+{
+  return alarm.getNextFireTime();
 }
 
 void Clock::setTimerTime(uint8_t hour, uint8_t minute, uint8_t second)
 {
   timer.setTime(hour, minute, second);
+  publish(SettingsChanged{SETTINGS_TIMER});
+}
+
+bool Clock::isTimerRunning() const
+{
+  return timer.isRunning();
+}
+
+bool Clock::setTime(const Time &time)
+{
+  return setLocalTime(Epoch::fromFields(getDate(), time));
+}
+
+bool Clock::setDate(const Date &date)
+{
+  return setLocalTime(Epoch::fromFields(date, getTime()));
+}
+
+bool Clock::setTimeZone(uint8_t index)
+{
+  if (!zone.select(index))
+  {
+    return false;
+  }
+  // The RTC stays on UTC; the wall clock jumps like a manual adjustment
+  alarm.clockAdjusted();
+  EEPROMStorage eeprom;
+  eeprom.saveTimeZone(index);
+  publish(SettingsChanged{SETTINGS_ZONE});
+  return true;
+}
+
+const TimeZone &Clock::getTimeZone() const
+{
+  return zone;
 }
 
-void Clock::setTime(const Time &time)
+const Calibration &Clock::getCalibration() const
 {
-  rtc->setTime(time);
+  return calibration;
 }
 
-void Clock::setDate(const Date &date)
+void Clock::resetCalibration()
 {
-  rtc->setDate(date);
+  calibration.reset();
+  calibration.takeEstimateChanged();
+  saveCalibration();
 }
\ No newline at end of file
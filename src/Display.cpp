@@ -52,9 +52,22 @@ const uint8_t Display::letterPatterns[26] = {
     0b11011010  // Z
 };
 
+#ifdef __AVR__
+// Timer2 at F_CPU / 256; one digit every 2 ms gives the old 12 ms frame
+static const uint8_t DIGIT_TICK_TOP = F_CPU / 256 / 500 - 1;
+
+static Display *activeDisplay = nullptr;
+
+ISR(TIMER2_COMPA_vect)
+{
+  activeDisplay->refreshNextDigit();
+}
+#endif
+
 Display::Display() : bcd1Pin(0), bcd2Pin(0), bcd3Pin(0), bcd4Pin(0),
-                     shiftPin(0), clockPin(0), digit1(0), digit2(0),
-                     digit3(0), digit4(0), digit5(0), digit6(0), dotState(false)
+                     shiftPin(0), clockPin(0), scanDigit(0), enabled(false),
+                     digit1(0), digit2(0), digit3(0), digit4(0), digit5(0),
+                     digit6(0), dotState(false)
 {
 }
 
@@ -82,6 +95,15 @@ void Display::begin(int bcd1Pin, int bcd2Pin, int bcd3Pin, int bcd4Pin, int shif
   digitalWrite(clockPin, LOW);
 
   clear();
+
+#ifdef __AVR__
+  // Timer2 in CTC mode, interrupt enabled by setEnabled()
+  activeDisplay = this;
+  TCCR2A = _BV(WGM21);
+  TCCR2B = _BV(CS22) | _BV(CS21);
+  OCR2A = DIGIT_TICK_TOP;
+#endif
+  setEnabled(true);
 }
 
 void Display::displayDigit(uint8_t pattern)
@@ -90,58 +112,48 @@ void Display::displayDigit(uint8_t pattern)
   shiftOut(shiftPin, clockPin, MSBFIRST, pattern);
 }
 
-void Display::multiplexDisplay()
+void Display::selectDigit(uint8_t code)
 {
-  // Multiplex through all 6 digits (matching old Arduino program exactly)
-  // Order: DIGIT_6, DIGIT_5, DIGIT_4, DIGIT_3, DIGIT_2, DIGIT_1
-
-  // DIGIT_6 (rightmost)
-  digitalWrite(bcd1Pin, HIGH);
-  digitalWrite(bcd2Pin, LOW);
-  digitalWrite(bcd3Pin, LOW);
-  digitalWrite(bcd4Pin, LOW);
-  displayDigit(getPatternForChar(digit6));
-  delay(2);
-
-  // DIGIT_5
-  digitalWrite(bcd1Pin, LOW);
-  digitalWrite(bcd2Pin, HIGH);
-  digitalWrite(bcd3Pin, LOW);
-  digitalWrite(bcd4Pin, LOW);
-  displayDigit(getPatternForChar(digit5));
-  delay(2);
-
-  // DIGIT_4 (with dot)
-  digitalWrite(bcd1Pin, HIGH);
-  digitalWrite(bcd2Pin, HIGH);
-  digitalWrite(bcd3Pin, LOW);
+  // Selector code 0 lights nothing; 1..6 select DIGIT_6..DIGIT_1
+  digitalWrite(bcd1Pin, code & 0x01 ? HIGH : LOW);
+  digitalWrite(bcd2Pin, code & 0x02 ? HIGH : LOW);
+  digitalWrite(bcd3Pin, code & 0x04 ? HIGH : LOW);
   digitalWrite(bcd4Pin, LOW);
-  displayDigit(getPatternForChar(digit4) + (dotState ? 0b10000000 : 0));
-  delay(2);
+}
 
-  // DIGIT_3
-  digitalWrite(bcd1Pin, LOW);
-  digitalWrite(bcd2Pin, LOW);
-  digitalWrite(bcd3Pin, HIGH);
-  digitalWrite(bcd4Pin, LOW);
-  displayDigit(getPatternForChar(digit3));
-  delay(2);
+void Display::refreshNextDigit()
+{
+  // Same order as before: DIGIT_6 (rightmost) down to DIGIT_1
+  uint8_t code = scanDigit + 1;
+  uint8_t pattern;
+  switch (code)
+  {
+  case 1:
+    pattern = getPatternForChar(digit6);
+    break;
+  case 2:
+    pattern = getPatternForChar(digit5);
+    break;
+  case 3: // DIGIT_4 (with dot)
+    pattern = getPatternForChar(digit4) + (dotState ? 0b10000000 : 0);
+    break;
+  case 4:
+    pattern = getPatternForChar(digit3);
+    break;
+  case 5: // DIGIT_2 (with dot)
+    pattern = getPatternForChar(digit2) + (dotState ? 0b10000000 : 0);
+    break;
+  default:
+    pattern = getPatternForChar(digit1);
+    break;
+  }
 
-  // DIGIT_2 (with dot)
-  digitalWrite(bcd1Pin, HIGH);
-  digitalWrite(bcd2Pin, LOW);
-  digitalWrite(bcd3Pin, HIGH);
-  digitalWrite(bcd4Pin, LOW);
-  displayDigit(getPatternForChar(digit2) + (dotState ? 0b10000000 : 0));
-  delay(2);
+  // Blank while shifting so the previous digit does not ghost
+  selectDigit(0);
+  displayDigit(pattern);
+  selectDigit(code);
 
-  // DIGIT_1 (leftmost)
-  digitalWrite(bcd1Pin, LOW);
-  digitalWrite(bcd2Pin, HIGH);
-  digitalWrite(bcd3Pin, HIGH);
-  digitalWrite(bcd4Pin, LOW);
-  displayDigit(getPatternForChar(digit1));
-  delay(2);
+  scanDigit = code < 6 ? code : 0;
 }
 
 uint8_t Display::getPatternForChar(char c)
@@ -170,6 +182,12 @@ uint8_t Display::getPatternForChar(char c)
     return digitTable[12]; // blank
   }
 
+  // Minus: the middle segment
+  if (c == '-')
+  {
+    return 0b01000000;
+  }
+
   // Handle letters A-Z
   if (c >= 'A' && c <= 'Z')
   {
@@ -213,7 +231,38 @@ void Display::setDotState(bool dotState)
 
 void Display::update()
 {
-  multiplexDisplay();
+#ifndef __AVR__
+  // No refresh interrupt off-target; step the scan from the loop instead
+  if (enabled)
+  {
+    refreshNextDigit();
+  }
+#endif
+}
+
+void Display::setEnabled(bool enabled)
+{
+  if (this->enabled == enabled)
+  {
+    return;
+  }
+  this->enabled = enabled;
+
+#ifdef __AVR__
+  TIMSK2 = enabled ? _BV(OCIE2A) : 0;
+#endif
+
+  // Leave the segments dark while the refresh is stopped
+  if (!enabled)
+  {
+    selectDigit(0);
+    displayDigit(0);
+  }
+}
+
+bool Display::isEnabled() const
+{
+  return enabled;
 }
 
 void Display::print(const char *str)
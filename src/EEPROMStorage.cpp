@@ -1,25 +1,34 @@
 #include "EEPROMStorage.h"
 #include <EEPROM.h>
 
+// put() takes its value by reference, so these need storage
+const uint16_t EEPROMStorage::MAGIC_NUMBER;
+const uint16_t EEPROMStorage::RECORDS_MAGIC_NUMBER;
+
 EEPROMStorage::EEPROMStorage()
 {
 }
 
-void EEPROMStorage::saveSettings(const Time &time, const Date &date, const AlarmData &alarm)
+void EEPROMStorage::saveSettings(const Time &time, const Date &date, const AlarmData alarms[MAX_ALARMS],
+                                 const SnoozeConfig &snooze)
 {
   Settings settings;
   settings.time = time;
   settings.date = date;
-  settings.alarm = alarm;
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    settings.alarms[i] = alarms[i];
+  }
+  settings.snooze = snooze;
 
   // Write magic number
-  EEPROM.put(MAGIC_ADDRESS, MAGIC_NUMBER);
+  put(MAGIC_ADDRESS, MAGIC_NUMBER);
 
   // Write settings
   writeSettings(settings);
 }
 
-bool EEPROMStorage::loadSettings(Time &time, Date &date, AlarmData &alarm)
+bool EEPROMStorage::loadSettings(Time &time, Date &date, AlarmData alarms[MAX_ALARMS], SnoozeConfig &snooze)
 {
   if (!hasValidSettings())
   {
@@ -31,16 +40,153 @@ bool EEPROMStorage::loadSettings(Time &time, Date &date, AlarmData &alarm)
   {
     time = settings.time;
     date = settings.date;
-    alarm = settings.alarm;
+    for (uint8_t i = 0; i < MAX_ALARMS; i++)
+    {
+      alarms[i] = settings.alarms[i];
+    }
+    snooze = settings.snooze;
     return true;
   }
 
   return false;
 }
 
+void EEPROMStorage::saveAlarmRecords(const uint32_t records[MAX_ALARMS])
+{
+  put(RECORDS_MAGIC_ADDRESS, RECORDS_MAGIC_NUMBER);
+
+  // put() only rewrites bytes that changed, so a fire costs a few cells
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    put(RECORDS_ADDRESS + i * sizeof(uint32_t), records[i]);
+  }
+}
+
+bool EEPROMStorage::loadAlarmRecords(uint32_t records[MAX_ALARMS])
+{
+  uint16_t magic;
+  EEPROM.get(RECORDS_MAGIC_ADDRESS, magic);
+  if (magic != RECORDS_MAGIC_NUMBER)
+  {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    EEPROM.get(RECORDS_ADDRESS + i * sizeof(uint32_t), records[i]);
+  }
+  return true;
+}
+
+void EEPROMStorage::saveTimeZone(uint8_t zone)
+{
+  put(TIME_ZONE_ADDRESS, zone);
+}
+
+bool EEPROMStorage::loadTimeZone(uint8_t &zone)
+{
+  // Erased cells read 0xFF; TimeZone::select() rejects other bad values
+  zone = EEPROM.read(TIME_ZONE_ADDRESS);
+  return zone != 0xFF;
+}
+
+void EEPROMStorage::saveCalibration(int16_t ppm)
+{
+  CalibrationRecord record = {ppm, (int16_t)~ppm};
+  put(CALIBRATION_ADDRESS, record);
+}
+
+bool EEPROMStorage::loadCalibration(int16_t &ppm)
+{
+  CalibrationRecord record;
+  EEPROM.get(CALIBRATION_ADDRESS, record);
+  ppm = record.ppm;
+  return record.check == (int16_t)~record.ppm;
+}
+
+void EEPROMStorage::clearCalibration()
+{
+  CalibrationRecord record = {0, 0};
+  put(CALIBRATION_ADDRESS, record);
+}
+
+void EEPROMStorage::readLogRecord(uint8_t index, LogRecord &record)
+{
+  EEPROM.get(LOG_ADDRESS + index * sizeof(LogRecord), record);
+}
+
+void EEPROMStorage::writeLogRecord(uint8_t index, const LogRecord &record)
+{
+  // put() goes through the bytes in order, so the type byte is last
+  put(LOG_ADDRESS + index * sizeof(LogRecord), record);
+}
+
+void EEPROMStorage::eraseLog()
+{
+  // Only the type bytes: an empty type marks a free slot
+  for (uint8_t i = 0; i < LOG_RECORDS; i++)
+  {
+    put(LOG_ADDRESS + i * sizeof(LogRecord) + offsetof(LogRecord, type), (uint8_t)LOG_EMPTY);
+  }
+}
+
+void EEPROMStorage::saveClimateInterval(uint8_t minutes)
+{
+  IntervalRecord record = {minutes, (uint8_t)~minutes};
+  put(CLIMATE_INTERVAL_ADDRESS, record);
+}
+
+bool EEPROMStorage::loadClimateInterval(uint8_t &minutes)
+{
+  IntervalRecord record;
+  EEPROM.get(CLIMATE_INTERVAL_ADDRESS, record);
+  minutes = record.minutes;
+  return record.check == (uint8_t)~record.minutes && minutes <= CLIMATE_MAX_INTERVAL;
+}
+
+void EEPROMStorage::readClimateHeader(uint8_t block, ClimateHeader &header)
+{
+  EEPROM.get(CLIMATE_ADDRESS + block * CLIMATE_BLOCK_BYTES, header);
+}
+
+void EEPROMStorage::writeClimateHeader(uint8_t block, const ClimateHeader &header)
+{
+  // The sequence byte is last, so the block is valid only when complete
+  put(CLIMATE_ADDRESS + block * CLIMATE_BLOCK_BYTES, header);
+}
+
+uint8_t EEPROMStorage::readClimateByte(uint8_t block, uint8_t offset)
+{
+  return EEPROM.read(CLIMATE_ADDRESS + block * CLIMATE_BLOCK_BYTES + sizeof(ClimateHeader) + offset);
+}
+
+void EEPROMStorage::writeClimateByte(uint8_t block, uint8_t offset, uint8_t value)
+{
+  put(CLIMATE_ADDRESS + block * CLIMATE_BLOCK_BYTES + sizeof(ClimateHeader) + offset, value);
+}
+
+void EEPROMStorage::eraseClimateBlock(uint8_t block)
+{
+  // Invalid first, so a power loss cannot leave the old header on new codes
+  int address = CLIMATE_ADDRESS + block * CLIMATE_BLOCK_BYTES;
+  put(address + offsetof(ClimateHeader, sequence), (uint8_t)0);
+  for (uint8_t i = 0; i < CLIMATE_PAYLOAD_BYTES; i++)
+  {
+    put(address + sizeof(ClimateHeader) + i, (uint8_t)0xFF);
+  }
+}
+
+void EEPROMStorage::eraseClimate()
+{
+  for (uint8_t i = 0; i < CLIMATE_BLOCKS; i++)
+  {
+    put(CLIMATE_ADDRESS + i * CLIMATE_BLOCK_BYTES + offsetof(ClimateHeader, sequence), (uint8_t)0);
+  }
+}
+
 bool EEPROMStorage::hasValidSettings()
 {
-  int magic;
+  uint16_t magic;
   EEPROM.get(MAGIC_ADDRESS, magic);
   return magic == MAGIC_NUMBER;
 }
@@ -51,16 +197,33 @@ void EEPROMStorage::clearSettings()
   {
     EEPROM.write(i, 0);
   }
+  PROFILE_COUNT(COUNTER_EEPROM_WRITE, EEPROM.length());
 }
 
 void EEPROMStorage::writeSettings(const Settings &settings)
 {
-  EEPROM.put(SETTINGS_ADDRESS, settings);
+  put(SETTINGS_ADDRESS, settings.time);
+  put(SETTINGS_DATE, settings.date.day);
+  put(SETTINGS_DATE + 1, settings.date.month);
+  put(SETTINGS_DATE + 2, settings.date.year);
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    put(SETTINGS_ALARMS + i * sizeof(AlarmData), settings.alarms[i]);
+  }
+  put(SETTINGS_SNOOZE, settings.snooze);
 }
 
 bool EEPROMStorage::readSettings(Settings &settings)
 {
-  EEPROM.get(SETTINGS_ADDRESS, settings);
+  EEPROM.get(SETTINGS_ADDRESS, settings.time);
+  EEPROM.get(SETTINGS_DATE, settings.date.day);
+  EEPROM.get(SETTINGS_DATE + 1, settings.date.month);
+  EEPROM.get(SETTINGS_DATE + 2, settings.date.year);
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    EEPROM.get(SETTINGS_ALARMS + i * sizeof(AlarmData), settings.alarms[i]);
+  }
+  EEPROM.get(SETTINGS_SNOOZE, settings.snooze);
 
   // Validate settings
   if (settings.time.hour > 23 || settings.time.minute > 59 || settings.time.second > 59)
@@ -73,7 +236,16 @@ bool EEPROMStorage::readSettings(Settings &settings)
     return false;
   }
 
-  if (settings.alarm.hour > 23 || settings.alarm.minute > 59)
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    const AlarmData &alarm = settings.alarms[i];
+    if (alarm.hour > 23 || alarm.minute > 59 || alarm.days > ALARM_EVERY_DAY)
+    {
+      return false;
+    }
+  }
+
+  if (settings.snooze.minutes < 1 || settings.snooze.minutes > 60 || settings.snooze.limit > 9)
   {
     return false;
   }
@@ -0,0 +1,103 @@
+#include "Epoch.h"
+
+// Days before each month in a common year
+static const uint16_t DAYS_BEFORE_MONTH[12] PROGMEM = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+// Every fourth year is a leap year from 1901 to 2099, so the calendar is a
+// repeating 4-year cycle. Cycles are counted from 1968, the leap year
+// before the epoch.
+static const uint16_t DAYS_PER_CYCLE = 4 * 365 + 1;
+static const uint16_t DAYS_1968_TO_EPOCH = 2 * 365 + 1;
+
+bool Epoch::isLeapYear(uint16_t year)
+{
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+uint8_t Epoch::daysInMonth(uint16_t year, uint8_t month)
+{
+  if (month == 2)
+  {
+    return isLeapYear(year) ? 29 : 28;
+  }
+  // 31 days, except April, June, September and November
+  return (month == 4 || month == 6 || month == 9 || month == 11) ? 30 : 31;
+}
+
+uint8_t Epoch::dayOfWeek(EpochTime time)
+{
+  // 1970-01-01 was a Thursday
+  return (time / SECONDS_PER_DAY + 4) % 7;
+}
+
+uint16_t Epoch::toDays(const Date &date)
+{
+  uint16_t years = date.year - 1968;
+  uint16_t days = years * 365 + (years + 3) / 4; // Leap days of the years before
+  days += pgm_read_word(&DAYS_BEFORE_MONTH[date.month - 1]);
+  if (date.month > 2 && isLeapYear(date.year))
+  {
+    days++;
+  }
+  return days + date.day - 1 - DAYS_1968_TO_EPOCH;
+}
+
+EpochTime Epoch::fromFields(const Date &date, const Time &time)
+{
+  return toDays(date) * SECONDS_PER_DAY + toSeconds(time);
+}
+
+Date Epoch::toDate(EpochTime time)
+{
+  uint16_t days = time / SECONDS_PER_DAY + DAYS_1968_TO_EPOCH;
+  uint8_t cycles = days / DAYS_PER_CYCLE;
+  uint16_t dayOfCycle = days % DAYS_PER_CYCLE;
+
+  // The leap year leads each cycle
+  uint8_t yearOfCycle = 0;
+  if (dayOfCycle >= 366)
+  {
+    yearOfCycle = (dayOfCycle - 1) / 365;
+    dayOfCycle = (dayOfCycle - 1) % 365;
+  }
+  Date date;
+  date.year = 1968 + cycles * 4 + yearOfCycle;
+
+  // Month from the table: the last month starting on or before the day
+  bool leap = yearOfCycle == 0;
+  uint8_t month = 12;
+  uint16_t monthStart;
+  while (true)
+  {
+    monthStart = pgm_read_word(&DAYS_BEFORE_MONTH[month - 1]);
+    if (leap && month > 2)
+    {
+      monthStart++;
+    }
+    if (monthStart <= dayOfCycle)
+    {
+      break;
+    }
+    month--;
+  }
+  date.month = month;
+  date.day = dayOfCycle - monthStart + 1;
+  return date;
+}
+
+Time Epoch::toTime(EpochTime time)
+{
+  uint32_t seconds = time % SECONDS_PER_DAY;
+  uint16_t minutes = seconds / SECONDS_PER_MINUTE;
+  return {(uint8_t)(minutes / 60), (uint8_t)(minutes % 60), (uint8_t)(seconds % SECONDS_PER_MINUTE)};
+}
+
+EpochTime Epoch::startOfDay(EpochTime time)
+{
+  return time - time % SECONDS_PER_DAY;
+}
+
+uint32_t Epoch::toSeconds(const Time &time)
+{
+  return time.hour * SECONDS_PER_HOUR + time.minute * SECONDS_PER_MINUTE + time.second;
+}
@@ -0,0 +1,17 @@
+#include "EventBus.h"
+
+// No subscribers unless the program declares them with EVENT_SUBSCRIBERS
+#define EVENT_NO_SUBSCRIBERS(Type) \
+  template <>                      \
+  const EventTable<Type> EventBus<Type>::subscribers __attribute__((weak)) PROGMEM = {nullptr, 0}
+
+EVENT_NO_SUBSCRIBERS(SecondTick);
+EVENT_NO_SUBSCRIBERS(MinuteTick);
+EVENT_NO_SUBSCRIBERS(AlarmFired);
+EVENT_NO_SUBSCRIBERS(TimerCompleted);
+EVENT_NO_SUBSCRIBERS(ButtonEvent);
+EVENT_NO_SUBSCRIBERS(SensorSample);
+EVENT_NO_SUBSCRIBERS(AlarmDismissed);
+EVENT_NO_SUBSCRIBERS(SettingsChanged);
+EVENT_NO_SUBSCRIBERS(SensorFault);
+EVENT_NO_SUBSCRIBERS(MemoryLow);
@@ -0,0 +1,73 @@
+#include "Format.h"
+
+uint8_t Format::divideBy10(uint8_t value)
+{
+  // 205 / 2048 is 1/10 to within 0.1 %, exact up to 1028
+  return (uint16_t)value * 205 >> 11;
+}
+
+uint8_t Format::divideBy100(uint16_t value)
+{
+  // 5243 / 2^19, exact up to 43698
+  return (uint32_t)value * 5243 >> 19;
+}
+
+void Format::twoDigits(char *buffer, uint8_t value)
+{
+  uint8_t tens = divideBy10(value);
+  buffer[0] = '0' + tens;
+  buffer[1] = '0' + value - tens * 10;
+}
+
+void Format::display(char *buffer, uint8_t first, uint8_t second, uint8_t third)
+{
+  twoDigits(buffer, first);
+  twoDigits(buffer + 2, second);
+  twoDigits(buffer + 4, third);
+}
+
+void Format::printTime(Print &out, uint8_t hour, uint8_t minute, uint8_t second)
+{
+  char text[8];
+  twoDigits(text, hour);
+  text[2] = ':';
+  twoDigits(text + 3, minute);
+  text[5] = ':';
+  twoDigits(text + 6, second);
+  out.write((const uint8_t *)text, sizeof(text));
+}
+
+void Format::printTime(Print &out, uint8_t hour, uint8_t minute)
+{
+  char text[5];
+  twoDigits(text, hour);
+  text[2] = ':';
+  twoDigits(text + 3, minute);
+  out.write((const uint8_t *)text, sizeof(text));
+}
+
+void Format::printDate(Print &out, uint8_t day, uint8_t month, uint16_t year)
+{
+  char text[10];
+  uint8_t century = divideBy100(year);
+  twoDigits(text, day);
+  text[2] = '.';
+  twoDigits(text + 3, month);
+  text[5] = '.';
+  twoDigits(text + 6, century);
+  twoDigits(text + 8, year - century * 100);
+  out.write((const uint8_t *)text, sizeof(text));
+}
+
+void Format::printDays(Print &out, uint8_t days)
+{
+  // Monday first, '-' for days the alarm is off; bit 0 is Sunday
+  static const char NAMES[] PROGMEM = "MTWTFSS";
+  char text[7];
+  for (uint8_t i = 0; i < 7; i++)
+  {
+    uint8_t bit = i < 6 ? i + 1 : 0;
+    text[i] = days & (1 << bit) ? pgm_read_byte(&NAMES[i]) : '-';
+  }
+  out.write((const uint8_t *)text, sizeof(text));
+}
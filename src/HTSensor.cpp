@@ -1,40 +1,66 @@
 #include "HTSensor.h"
+#include "EventBus.h"
 
 HTSensor::HTSensor(int pin) : dht(pin, DHTTYPE), pin(pin)
 {
 }
 
-void HTSensor::begin()
+void HTSensor::begin(Scheduler *scheduler)
 {
   dht.begin();
+  scheduler->every(F("sensor"), UPDATE_INTERVAL, readTask, this);
 }
 
-int8_t HTSensor::getTemperature()
+void HTSensor::readTask(void *sensor)
+{
+  static_cast<HTSensor *>(sensor)->read();
+}
+
+void HTSensor::read()
 {
-  unsigned long currentMillis = millis();
-  if (currentMillis - lastTemperatureUpdate >= UPDATE_INTERVAL)
+  float newTemp = dht.readTemperature();
+  if (!isnan(newTemp) && newTemp >= -50 && newTemp <= 100)
+  {
+    temperature = newTemp;
+  }
+
+  // Uses the reading cached by the DHT library, no second transfer
+  float newHum = dht.readHumidity();
+  if (!isnan(newHum) && newHum >= 0 && newHum <= 100)
+  {
+    humidity = newHum;
+  }
+
+  uint8_t fault = 0;
+  if (isnan(newTemp) || isnan(newHum))
+  {
+    fault = SENSOR_NO_REPLY;
+  }
+  else if (newTemp < -50 || newTemp > 100 || newHum < 0 || newHum > 100)
   {
-    int newTemp = dht.readTemperature();
-    if (!isnan(newTemp) && newTemp >= -50 && newTemp <= 100)
-    {
-      temperature = newTemp;
-    }
-    lastTemperatureUpdate = currentMillis;
+    fault = SENSOR_OUT_OF_RANGE;
   }
+
+  // Only a good reading is a sample; the cached values may be stale or unset
+  if (fault == 0)
+  {
+    publish(SensorSample{temperature, humidity});
+  }
+
+  // Report a failing sensor once, not every read
+  if (fault && !faulty)
+  {
+    publish(SensorFault{fault});
+  }
+  faulty = fault != 0;
+}
+
+int8_t HTSensor::getTemperature()
+{
   return temperature;
 }
 
 int8_t HTSensor::getHumidity()
 {
-  unsigned long currentMillis = millis();
-  if (currentMillis - lastHumidityUpdate >= UPDATE_INTERVAL)
-  {
-    int newHum = dht.readHumidity();
-    if (!isnan(newHum) && newHum >= 0 && newHum <= 100)
-    {
-      humidity = newHum;
-    }
-    lastHumidityUpdate = currentMillis;
-  }
   return humidity;
 }
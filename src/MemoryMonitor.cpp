@@ -0,0 +1,150 @@
+#include "MemoryMonitor.h"
+#include "EventBus.h"
+
+// Paint bytes in a row that count as the gap; a stale heap block that
+// happens to hold one is not mistaken for it
+static const uint8_t MIN_RUN = 4;
+
+uint16_t MemoryMonitor::lowHeadroom = 0;
+bool MemoryMonitor::low = false;
+
+#ifdef __AVR__
+// Linker and avr-libc allocator symbols
+extern uint8_t __data_start;
+extern uint8_t __heap_start;
+extern uint8_t _end;
+extern uint8_t __stack;
+
+struct __freelist
+{
+  size_t sz; // Bytes after the size field
+  struct __freelist *nx;
+};
+
+extern "C"
+{
+  extern char *__brkval; // Heap top, 0 before the first malloc()
+  extern struct __freelist *__flp;
+  extern size_t __malloc_margin;
+}
+
+// Runs from .init3, after the stack pointer and zero register are set up but
+// before .data and .bss are: no frame, no globals, nothing pushed yet.
+//
+// In assembly, not C: at -Os GCC turns a fill loop into a call to memset(),
+// whose return address would sit at the top of the very stack being painted
+// over. Only basic asm is safe in a naked function, so no operands either.
+#define MEMORY_STRING(x) #x
+#define MEMORY_ASM_BYTE(x) MEMORY_STRING(x)
+
+extern "C" void paintMemory() __attribute__((naked, used, section(".init3")));
+
+void paintMemory()
+{
+  __asm__ __volatile__(
+      "ldi r26, lo8(_end)\n\t"
+      "ldi r27, hi8(_end)\n\t"
+      "ldi r24, " MEMORY_ASM_BYTE(MEMORY_PAINT) "\n\t"
+      "1:\n\t"
+      "st X+, r24\n\t" // _end up to and including __stack
+      "cpi r26, lo8(__stack + 1)\n\t"
+      "ldi r25, hi8(__stack + 1)\n\t" // ldi leaves the flags alone
+      "cpc r27, r25\n\t"
+      "brne 1b\n\t");
+}
+#endif
+
+void MemoryMonitor::begin(Scheduler *scheduler, uint16_t lowHeadroom)
+{
+  MemoryMonitor::lowHeadroom = lowHeadroom;
+  low = false;
+  if (lowHeadroom && isMeasured())
+  {
+    scheduler->every(F("memory"), MEMORY_CHECK_INTERVAL, checkTask);
+  }
+}
+
+void MemoryMonitor::checkTask(void *)
+{
+  check(read().headroom);
+}
+
+void MemoryMonitor::check(uint16_t headroom)
+{
+  bool below = lowHeadroom && headroom < lowHeadroom;
+  if (below && !low)
+  {
+    publish(MemoryLow{headroom});
+  }
+  low = below;
+}
+
+const uint8_t *MemoryMonitor::findStackPeak(const uint8_t *start, const uint8_t *end, uint16_t &unused)
+{
+  const uint8_t *run = start;
+  for (const uint8_t *p = start; p < end; p++)
+  {
+    if (*p == MEMORY_PAINT)
+    {
+      continue;
+    }
+    if (p - run >= MIN_RUN)
+    {
+      unused = p - run;
+      return p;
+    }
+    run = p + 1;
+  }
+  if (end - run >= MIN_RUN)
+  {
+    unused = end - run; // The stack has not been below end
+    return end;
+  }
+  unused = 0; // They have met
+  return start;
+}
+
+bool MemoryMonitor::isMeasured()
+{
+#ifdef __AVR__
+  return true;
+#else
+  return false;
+#endif
+}
+
+MemoryStats MemoryMonitor::read()
+{
+  MemoryStats stats = {0, 0, 0, 0, 0, 0, 0, 0};
+#ifdef __AVR__
+  uint8_t *heapStart = &__heap_start;
+  uint8_t *heapTop = __brkval ? (uint8_t *)__brkval : heapStart;
+  uint8_t *sp = (uint8_t *)SP;
+
+  stats.staticSize = heapStart - &__data_start;
+  stats.heapUsed = heapTop - heapStart;
+  for (struct __freelist *block = __flp; block; block = block->nx)
+  {
+    stats.heapFree += block->sz;
+    stats.fragments++;
+    if (block->sz > stats.largestFree)
+    {
+      stats.largestFree = block->sz;
+    }
+  }
+
+  // malloc() also grows the heap up to __malloc_margin below the stack,
+  // less the size field of the new block
+  uint8_t *limit = sp - __malloc_margin;
+  if (limit > heapTop + sizeof(size_t) && (uint16_t)(limit - heapTop - sizeof(size_t)) > stats.largestFree)
+  {
+    stats.largestFree = limit - heapTop - sizeof(size_t);
+  }
+
+  // SP points at the next free byte
+  const uint8_t *peak = findStackPeak(heapTop, sp + 1, stats.headroom);
+  stats.stackNow = &__stack - sp;
+  stats.stackPeak = &__stack + 1 - peak;
+#endif
+  return stats;
+}
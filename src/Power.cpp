@@ -0,0 +1,321 @@
+#include "Power.h"
+
+#ifdef __AVR__
+#include <avr/sleep.h>
+#endif
+
+// Estimated board current per state in 0.1 mA, display lit while awake.
+// ATmega328P at 16 MHz/5 V (~10 mA active, ~3.5 mA idle) plus ~15 mA of
+// multiplexed segments; power-down is the DS1307 and DHT11 standby draw.
+// The Nano's USB bridge and power LED are not included.
+const uint16_t STATE_CURRENT[POWER_STATE_COUNT] PROGMEM = {250, 185, 3};
+
+#ifdef __AVR__
+// Pin change groups that fired since the wake pins were armed
+static volatile uint8_t pinChangeGroups = 0;
+
+ISR(PCINT0_vect)
+{
+  pinChangeGroups |= _BV(0);
+}
+
+ISR(PCINT1_vect)
+{
+  pinChangeGroups |= _BV(1);
+}
+
+ISR(PCINT2_vect)
+{
+  pinChangeGroups |= _BV(2);
+}
+
+// RX (D0) wakes from power-down; the byte itself is lost with the clock
+static const uint8_t RX_PIN = 0;
+#endif
+
+Power::Power() : rtc(nullptr), wakePinCount(0), nightMode(NIGHT_OFF),
+                 nightStart(0), nightEnd(0), lastActivity(0), lastMark(0)
+{
+  resetStats();
+}
+
+void Power::begin(RTClock *rtc, const uint8_t *buttonPins, uint8_t count)
+{
+  this->rtc = rtc;
+  wakePinCount = count < MAX_WAKE_PINS ? count : MAX_WAKE_PINS;
+  for (uint8_t i = 0; i < wakePinCount; i++)
+  {
+    wakePins[i] = buttonPins[i];
+  }
+  lastActivity = millis();
+  lastMark = micros();
+}
+
+void Power::armPinWake(bool armed)
+{
+#ifdef __AVR__
+  uint8_t groups = 0;
+  for (uint8_t i = 0; i <= wakePinCount; i++)
+  {
+    uint8_t pin = i < wakePinCount ? wakePins[i] : RX_PIN;
+    if (armed)
+    {
+      *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+    }
+    else
+    {
+      *digitalPinToPCMSK(pin) &= ~_BV(digitalPinToPCMSKbit(pin));
+    }
+    groups |= _BV(digitalPinToPCICRbit(pin));
+  }
+
+  if (armed)
+  {
+    pinChangeGroups = 0;
+    PCIFR = groups; // Drop edges from before the sleep
+    PCICR |= groups;
+  }
+  else
+  {
+    PCICR &= ~groups;
+  }
+#else
+  (void)armed;
+#endif
+}
+
+WakeSource Power::sleepOnce(bool powerDown)
+{
+#ifdef __AVR__
+  uint16_t ticks = rtc ? rtc->getTickCount() : 0;
+  int pending = Serial.available();
+  uint8_t adc = ADCSRA;
+
+  if (powerDown)
+  {
+    Serial.flush(); // The UART clock stops with the rest
+    armPinWake(true);
+    ADCSRA = adc & ~_BV(ADEN);
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  }
+  else
+  {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+  }
+
+  // sei() takes effect after the next instruction, so no wake-up
+  // interrupt can slip in between enabling sleep and sleeping
+  noInterrupts();
+  sleep_enable();
+#if defined(BODS) && defined(BODSE)
+  if (powerDown)
+  {
+    sleep_bod_disable();
+  }
+#endif
+  interrupts();
+  sleep_cpu();
+  sleep_disable();
+
+  uint8_t groups = pinChangeGroups;
+  if (powerDown)
+  {
+    armPinWake(false);
+    ADCSRA = adc;
+  }
+
+  if (rtc && rtc->getTickCount() != ticks)
+  {
+    return WAKE_RTC;
+  }
+  if (groups & _BV(digitalPinToPCICRbit(RX_PIN)))
+  {
+    return WAKE_UART;
+  }
+  if (groups)
+  {
+    return WAKE_BUTTON;
+  }
+  if (Serial.available() > pending)
+  {
+    return WAKE_UART;
+  }
+#else
+  (void)powerDown;
+#endif
+  return WAKE_TIMER;
+}
+
+void Power::sleep(bool powerDown)
+{
+  unsigned long start = micros();
+  uint32_t awake = start - lastMark;
+  account(POWER_ACTIVE, awake);
+
+  WakeSource source = sleepOnce(powerDown);
+  wakeCount[source]++;
+
+#ifdef __AVR__
+  // Timers stop in power-down: only the watchdog wakes it without a
+  // source of its own, after the edge every second failed to
+  if (powerDown && source == WAKE_TIMER && rtc)
+  {
+    rtc->missedEdge();
+  }
+#endif
+
+  lastMark = micros();
+  if (!powerDown)
+  {
+    account(POWER_IDLE, lastMark - start);
+    return;
+  }
+
+  // micros() stood still; a square wave wake ends a one second period,
+  // anything else is counted as half of one
+  if (source == WAKE_RTC)
+  {
+    account(POWER_DOWN, awake < 1000000UL ? 1000000UL - awake : 0);
+  }
+  else
+  {
+    account(POWER_DOWN, 500000UL);
+    notifyActivity(); // Keep the UART and display up for the user
+  }
+}
+
+void Power::account(PowerState state, uint32_t micros)
+{
+  stateMicros[state] += micros;
+  while (stateMicros[state] >= 1000000UL)
+  {
+    stateMicros[state] -= 1000000UL;
+    stateSeconds[state]++;
+  }
+}
+
+void Power::setNightMode(NightMode mode)
+{
+  nightMode = mode;
+  notifyActivity();
+}
+
+void Power::setNightWindow(uint16_t startMinute, uint16_t endMinute)
+{
+  nightStart = startMinute;
+  nightEnd = endMinute;
+  setNightMode(NIGHT_AUTO);
+}
+
+NightMode Power::getNightMode() const
+{
+  return nightMode;
+}
+
+uint16_t Power::getNightStart() const
+{
+  return nightStart;
+}
+
+uint16_t Power::getNightEnd() const
+{
+  return nightEnd;
+}
+
+bool Power::isNight(const Time &now) const
+{
+  switch (nightMode)
+  {
+  case NIGHT_ON:
+    return true;
+  case NIGHT_AUTO:
+  {
+    uint16_t minute = now.hour * 60 + now.minute;
+    if (nightStart <= nightEnd)
+    {
+      return minute >= nightStart && minute < nightEnd;
+    }
+    return minute >= nightStart || minute < nightEnd; // Across midnight
+  }
+  default:
+    return false;
+  }
+}
+
+void Power::notifyActivity()
+{
+  lastActivity = millis();
+}
+
+bool Power::isAwake() const
+{
+  return millis() - lastActivity < NIGHT_AWAKE_WINDOW;
+}
+
+uint32_t Power::getStateSeconds(PowerState state) const
+{
+  return stateSeconds[state];
+}
+
+uint16_t Power::getWakeCount(WakeSource source) const
+{
+  return wakeCount[source];
+}
+
+uint16_t Power::getAverageCurrent() const
+{
+  uint32_t total = 0;
+  uint32_t weighted = 0;
+  for (uint8_t i = 0; i < POWER_STATE_COUNT; i++)
+  {
+    total += stateSeconds[i];
+    weighted += stateSeconds[i] * getStateCurrent((PowerState)i);
+  }
+  return total ? weighted / total : getStateCurrent(POWER_ACTIVE);
+}
+
+void Power::resetStats()
+{
+  for (uint8_t i = 0; i < POWER_STATE_COUNT; i++)
+  {
+    stateSeconds[i] = 0;
+    stateMicros[i] = 0;
+  }
+  for (uint8_t i = 0; i < WAKE_SOURCE_COUNT; i++)
+  {
+    wakeCount[i] = 0;
+  }
+}
+
+uint16_t Power::getStateCurrent(PowerState state)
+{
+  return pgm_read_word(&STATE_CURRENT[state]);
+}
+
+const __FlashStringHelper *Power::getStateName(PowerState state)
+{
+  switch (state)
+  {
+  case POWER_ACTIVE:
+    return F("active");
+  case POWER_IDLE:
+    return F("idle");
+  default:
+    return F("power-down");
+  }
+}
+
+const __FlashStringHelper *Power::getWakeSourceName(WakeSource source)
+{
+  switch (source)
+  {
+  case WAKE_TIMER:
+    return F("timer");
+  case WAKE_RTC:
+    return F("rtc");
+  case WAKE_BUTTON:
+    return F("button");
+  default:
+    return F("uart");
+  }
+}
@@ -0,0 +1,107 @@
+#include "Profiler.h"
+
+#ifdef CLOCK_PROFILE
+
+StageProfile Profiler::stages[STAGE_COUNT];
+uint32_t Profiler::counters[COUNTER_COUNT];
+uint32_t Profiler::loopStart = 0;
+uint32_t Profiler::stageStart = 0;
+
+void Profiler::beginLoop()
+{
+  loopStart = micros();
+  stageStart = loopStart;
+}
+
+void Profiler::mark(LoopStage stage)
+{
+  uint32_t now = micros();
+  record(stage, now - stageStart);
+  stageStart = now;
+}
+
+void Profiler::endLoop()
+{
+  record(STAGE_LOOP, micros() - loopStart);
+}
+
+void Profiler::record(LoopStage stage, uint32_t micros)
+{
+  StageProfile &profile = stages[stage];
+
+  // Shift instead of divide: each bucket is 4x the previous one
+  uint8_t bucket = 0;
+  uint32_t limit = PROFILE_FIRST_BUCKET;
+  while (bucket < PROFILE_BUCKETS - 1 && micros >= limit)
+  {
+    bucket++;
+    limit <<= 2;
+  }
+
+  if (profile.histogram[bucket] < 0xFFFF)
+  {
+    profile.histogram[bucket]++;
+  }
+  if (micros > profile.maxMicros)
+  {
+    profile.maxMicros = micros;
+  }
+  profile.totalMicros += micros;
+  profile.samples++;
+}
+
+void Profiler::count(ProfileCounter counter, uint16_t amount)
+{
+  counters[counter] += amount;
+}
+
+const StageProfile &Profiler::getStage(LoopStage stage)
+{
+  return stages[stage];
+}
+
+uint32_t Profiler::getCounter(ProfileCounter counter)
+{
+  return counters[counter];
+}
+
+uint32_t Profiler::getBucketLimit(uint8_t bucket)
+{
+  return (uint32_t)PROFILE_FIRST_BUCKET << (2 * bucket);
+}
+
+void Profiler::reset()
+{
+  memset(stages, 0, sizeof(stages));
+  memset(counters, 0, sizeof(counters));
+}
+
+const __FlashStringHelper *Profiler::getStageName(LoopStage stage)
+{
+  switch (stage)
+  {
+  case STAGE_SERIAL:
+    return F("serial");
+  case STAGE_TASKS:
+    return F("tasks");
+  case STAGE_BUTTONS:
+    return F("buttons");
+  case STAGE_CLOCK:
+    return F("clock");
+  default:
+    return F("loop");
+  }
+}
+
+const __FlashStringHelper *Profiler::getCounterName(ProfileCounter counter)
+{
+  switch (counter)
+  {
+  case COUNTER_I2C:
+    return F("i2c transactions");
+  default:
+    return F("eeprom writes");
+  }
+}
+
+#endif // CLOCK_PROFILE
@@ -1,15 +1,34 @@
 #include "RTClock.h"
+#include "Profiler.h"
+#include "Recorder.h"
+#include "EventBus.h"
 
-RTClock::RTClock() : sdaPin(0), sclPin(0)
+volatile bool RTClock::secondTick = false;
+volatile uint16_t RTClock::tickCount = 0;
+volatile uint32_t RTClock::edgeMicros = 0;
+
+RTClock::RTClock() : sdaPin(0), sclPin(0), sqwPin(-1), squareWave(false), timeLost(false), lastPoll(0), secondMicros(0), busRecoveries(0)
+{
+}
+
+void RTClock::onSquareWave()
 {
+  // The DS1307 advances its seconds register on the falling edge
+  secondTick = true;
+  tickCount++;
+  edgeMicros = micros();
 }
 
-void RTClock::begin(uint8_t sdaPin, uint8_t sclPin)
+void RTClock::begin(uint8_t sdaPin, uint8_t sclPin, int8_t sqwPin)
 {
   this->sdaPin = sdaPin;
   this->sclPin = sclPin;
+  this->sqwPin = sqwPin;
 
+  // A reset in the middle of a read can leave the DS1307 holding SDA
+  recoverBus();
   Wire.begin();
+  Wire.setWireTimeout(RTC_I2C_TIMEOUT, true);
 
   if (!rtcModule.begin())
   {
@@ -19,38 +38,187 @@ void RTClock::begin(uint8_t sdaPin, uint8_t sclPin)
   {
     if (!rtcModule.isrunning())
     {
-      // Set the RTC to the date & time this sketch was compiled
-      rtcModule.adjust(DateTime(F(__DATE__), F(__TIME__)));
+      // Not from __DATE__/__TIME__: that is the build machine's wall clock,
+      // and the RTC keeps UTC. Start it counting and leave the setting to
+      // the user.
+      rtcModule.adjust(DateTime(RTC_UNSET_TIME));
+      timeLost = true;
     }
   }
+
+  // 1 Hz square wave paces the reads and wakes the MCU from power-down
+  if (sqwPin >= 0)
+  {
+    rtcModule.writeSqwPinMode(DS1307_SquareWave1HZ);
+    pinMode(sqwPin, INPUT_PULLUP); // open-drain output
+    attachInterrupt(digitalPinToInterrupt(sqwPin), onSquareWave, FALLING);
+    squareWave = true; // Until an edge is overdue
+  }
+
+  refresh();
 }
 
-Time RTClock::getTime()
+bool RTClock::refresh()
 {
-  DateTime now = rtcModule.now();
-  return {now.hour(), now.minute(), now.second()};
+  DateTime reading = rtcModule.now();
+  lastPoll = millis();
+  PROFILE_COUNT(COUNTER_I2C, 1);
+  if (!checkBus())
+  {
+    return false; // Keep the last good reading
+  }
+  current = reading;
+  return true;
 }
 
-Date RTClock::getDate()
+bool RTClock::checkBus()
 {
-  DateTime now = rtcModule.now();
-  return {now.day(), now.month(), now.year()};
+  if (!Wire.getWireTimeoutFlag())
+  {
+    return true;
+  }
+  // Wire has reset the TWI; the bus may still be held
+  Wire.clearWireTimeoutFlag();
+  Wire.end();
+  recoverBus();
+  Wire.begin();
+  Wire.setWireTimeout(RTC_I2C_TIMEOUT, true);
+  busRecoveries++;
+  return false;
 }
 
-void RTClock::setTime(const Time &time)
+void RTClock::recoverBus()
 {
-  DateTime now = rtcModule.now();
-  DateTime newDateTime(now.year(), now.month(), now.day(),
-                       time.hour, time.minute, time.second);
-  rtcModule.adjust(newDateTime);
+  // A slave cut off mid-byte holds SDA low until it has shifted the rest
+  // out: clock SCL by hand until it lets go, at most a byte and its ACK.
+  // Lines are only ever pulled low or released, as on the bus.
+  pinMode(sdaPin, INPUT_PULLUP);
+  pinMode(sclPin, INPUT_PULLUP);
+  for (uint8_t i = 0; i < 9 && digitalRead(sdaPin) == LOW; i++)
+  {
+    digitalWrite(sclPin, LOW);
+    pinMode(sclPin, OUTPUT);
+    delayMicroseconds(5);
+    pinMode(sclPin, INPUT_PULLUP);
+    delayMicroseconds(5);
+  }
+
+  // STOP: SDA rises while SCL is high
+  digitalWrite(sdaPin, LOW);
+  pinMode(sdaPin, OUTPUT);
+  delayMicroseconds(5);
+  pinMode(sdaPin, INPUT_PULLUP);
+  delayMicroseconds(5);
 }
 
-void RTClock::setDate(const Date &date)
+bool RTClock::update()
 {
-  DateTime now = rtcModule.now();
-  DateTime newDateTime(date.year, date.month, date.day,
-                       now.hour(), now.minute(), now.second());
+  if (secondTick)
+  {
+    squareWave = true;
+    secondTick = false;
+    noInterrupts();
+    secondMicros = edgeMicros;
+    interrupts();
+    if (!refresh())
+    {
+      return false; // The next edge reads again
+    }
+    RECORD_TICK();
+    publishTick();
+    return true;
+  }
+
+  if (squareWave)
+  {
+    // No wire on the SQW pin, or the DS1307 lost its output setting
+    if (millis() - lastPoll < RTC_SQW_TIMEOUT)
+    {
+      return false;
+    }
+    squareWave = false;
+  }
+
+  // No square wave: poll a few times a second and report second changes
+  if (millis() - lastPoll < RTC_POLL_INTERVAL)
+  {
+    return false;
+  }
+  uint8_t lastSecond = current.second();
+  if (!refresh() || current.second() == lastSecond)
+  {
+    return false;
+  }
+  secondMicros = micros();
+  RECORD_TICK();
+  publishTick();
+  return true;
+}
+
+void RTClock::publishTick()
+{
+  SecondTick tick = {current.unixtime(), current.hour(), current.minute(), current.second()};
+  publish(tick);
+  if (tick.second == 0)
+  {
+    publish(MinuteTick{tick.unixTime, tick.hour, tick.minute});
+  }
+}
+
+bool RTClock::hasSquareWave() const
+{
+  return squareWave;
+}
+
+void RTClock::missedEdge()
+{
+  squareWave = false;
+}
+
+uint32_t RTClock::getSecondMicros() const
+{
+  return secondMicros;
+}
+
+uint16_t RTClock::getTickCount() const
+{
+  noInterrupts();
+  uint16_t count = tickCount;
+  interrupts();
+  return count;
+}
+
+EpochTime RTClock::getUnixTime()
+{
+  return current.unixtime();
+}
+
+bool RTClock::setUnixTime(EpochTime time)
+{
+  DateTime newDateTime(time);
   rtcModule.adjust(newDateTime);
+  PROFILE_COUNT(COUNTER_I2C, 1);
+  if (!checkBus())
+  {
+    return false; // The write may not have landed; keep what was read
+  }
+  current = newDateTime;
+  timeLost = false;
+  lastPoll = millis();
+
+  // Writing the seconds register restarts the DS1307's divider
+  secondMicros = micros();
+  return true;
+}
+
+bool RTClock::isTimeLost() const
+{
+  return timeLost;
+}
+
+uint16_t RTClock::getBusRecoveries() const
+{
+  return busRecoveries;
 }
 
 RTC_DS1307 *RTClock::getModule()
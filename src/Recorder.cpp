@@ -0,0 +1,116 @@
+#include "Recorder.h"
+
+#ifdef CLOCK_RECORD
+
+RecordEvent Recorder::events[RECORD_CAPACITY];
+uint8_t Recorder::first = 0;
+uint8_t Recorder::count = 0;
+uint16_t Recorder::dropped = 0;
+uint32_t Recorder::baseTime = 0;
+uint32_t Recorder::lastMillis = 0;
+bool Recorder::recording = false;
+
+void Recorder::start(uint32_t unixTime)
+{
+  first = 0;
+  count = 0;
+  dropped = 0;
+  baseTime = unixTime;
+  lastMillis = millis();
+  recording = true;
+}
+
+void Recorder::stop()
+{
+  recording = false;
+}
+
+bool Recorder::isRecording()
+{
+  return recording;
+}
+
+void Recorder::push(RecordType type, uint16_t delta, uint8_t data)
+{
+  uint8_t slot;
+  if (count < RECORD_CAPACITY)
+  {
+    slot = (first + count) % RECORD_CAPACITY;
+    count++;
+  }
+  else
+  {
+    // Full: the oldest event goes, and with it a second of RTC time if it was a tick
+    slot = first;
+    first = (first + 1) % RECORD_CAPACITY;
+    if ((events[slot].header >> 14) == RECORD_TICK)
+    {
+      baseTime++;
+    }
+    if (dropped < 0xFFFF)
+    {
+      dropped++;
+    }
+  }
+
+  events[slot].header = ((uint16_t)type << 14) | delta;
+  events[slot].data = data;
+}
+
+void Recorder::add(RecordType type, uint8_t data)
+{
+  if (!recording)
+  {
+    return;
+  }
+
+  uint32_t now = millis();
+  uint32_t delta = now - lastMillis;
+  lastMillis = now;
+  while (delta > RECORD_MAX_DELTA)
+  {
+    push(RECORD_GAP, RECORD_MAX_DELTA, 0);
+    delta -= RECORD_MAX_DELTA;
+  }
+  push(type, delta, data);
+}
+
+void Recorder::tick()
+{
+  add(RECORD_TICK, 0);
+}
+
+void Recorder::button(uint8_t pin, bool level)
+{
+  add(RECORD_BUTTON, (pin & 0x7F) | (level ? 0x80 : 0));
+}
+
+void Recorder::serial(uint8_t c)
+{
+  add(RECORD_SERIAL, c);
+}
+
+uint8_t Recorder::getCount()
+{
+  return count;
+}
+
+RecordType Recorder::getEvent(uint8_t index, uint16_t &delta, uint8_t &data)
+{
+  const RecordEvent &event = events[(first + index) % RECORD_CAPACITY];
+  delta = event.header & RECORD_MAX_DELTA;
+  data = event.data;
+  return (RecordType)(event.header >> 14);
+}
+
+uint16_t Recorder::getDropped()
+{
+  return dropped;
+}
+
+uint32_t Recorder::getBaseTime()
+{
+  return baseTime;
+}
+
+#endif // CLOCK_RECORD
@@ -0,0 +1,176 @@
+#include "Scheduler.h"
+#include "Timebase.h"
+
+Scheduler::Scheduler() : nextWake(0), activeCount(0), runCount(0)
+{
+  for (uint8_t i = 0; i < MAX_TASKS; i++)
+  {
+    tasks[i].active = false;
+  }
+}
+
+TaskId Scheduler::every(const __FlashStringHelper *name, uint32_t period, TaskCallback callback, void *context)
+{
+  return add(name, callback, context, period, period);
+}
+
+TaskId Scheduler::after(const __FlashStringHelper *name, uint32_t delay, TaskCallback callback, void *context)
+{
+  return add(name, callback, context, delay, 0);
+}
+
+TaskId Scheduler::add(const __FlashStringHelper *name, TaskCallback callback, void *context,
+                      uint32_t delay, uint32_t period)
+{
+  for (uint8_t i = 0; i < MAX_TASKS; i++)
+  {
+    if (!tasks[i].active)
+    {
+      Task &task = tasks[i];
+      task.name = name;
+      task.callback = callback;
+      task.context = context;
+      task.nextRun = Timebase::millis() + delay;
+      task.period = period;
+      task.lateCount = 0;
+      task.maxLateness = 0;
+      task.active = true;
+
+      if (activeCount == 0 || (int32_t)(task.nextRun - nextWake) < 0)
+      {
+        nextWake = task.nextRun;
+      }
+      activeCount++;
+      return i;
+    }
+  }
+  return -1;
+}
+
+void Scheduler::cancel(TaskId id)
+{
+  if (id >= 0 && id < MAX_TASKS && tasks[id].active)
+  {
+    tasks[id].active = false;
+    activeCount--;
+    updateNextWake();
+  }
+}
+
+void Scheduler::restart(TaskId id)
+{
+  if (id >= 0 && id < MAX_TASKS && tasks[id].active)
+  {
+    Task &task = tasks[id];
+    task.nextRun = Timebase::millis() + task.period;
+    updateNextWake();
+  }
+}
+
+void Scheduler::run()
+{
+  uint32_t now = Timebase::millis();
+  if (activeCount == 0 || (int32_t)(now - nextWake) < 0)
+  {
+    return;
+  }
+
+  for (uint8_t i = 0; i < MAX_TASKS; i++)
+  {
+    Task &task = tasks[i];
+    if (!task.active || (int32_t)(now - task.nextRun) < 0)
+    {
+      continue;
+    }
+
+    uint32_t lateness = now - task.nextRun;
+    if (lateness > task.maxLateness)
+    {
+      task.maxLateness = lateness > 0xFFFF ? 0xFFFF : lateness;
+    }
+    if (lateness > LATE_THRESHOLD && task.lateCount < 0xFFFF)
+    {
+      task.lateCount++;
+    }
+
+    if (task.period > 0)
+    {
+      // Keep the phase; if whole periods were missed, resume from now
+      task.nextRun += task.period;
+      if ((int32_t)(now - task.nextRun) >= 0)
+      {
+        task.nextRun = now + task.period;
+      }
+    }
+    else
+    {
+      // One-shot tasks free their slot first so the callback can re-arm
+      task.active = false;
+      activeCount--;
+    }
+
+    runCount++;
+    task.callback(task.context);
+  }
+
+  updateNextWake();
+}
+
+void Scheduler::updateNextWake()
+{
+  bool found = false;
+  for (uint8_t i = 0; i < MAX_TASKS; i++)
+  {
+    if (tasks[i].active && (!found || (int32_t)(tasks[i].nextRun - nextWake) < 0))
+    {
+      nextWake = tasks[i].nextRun;
+      found = true;
+    }
+  }
+}
+
+bool Scheduler::hasTasks() const
+{
+  return activeCount > 0;
+}
+
+uint32_t Scheduler::getNextWakeTime() const
+{
+  return nextWake;
+}
+
+uint32_t Scheduler::getTimeUntilNextTask() const
+{
+  if (activeCount == 0)
+  {
+    return 0xFFFFFFFFUL;
+  }
+
+  int32_t remaining = (int32_t)(nextWake - (uint32_t)Timebase::millis());
+  return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+uint8_t Scheduler::getTaskCount() const
+{
+  return MAX_TASKS;
+}
+
+const Task *Scheduler::getTask(uint8_t index) const
+{
+  return (index < MAX_TASKS && tasks[index].active) ? &tasks[index] : nullptr;
+}
+
+uint32_t Scheduler::getRunCount() const
+{
+  return runCount;
+}
+
+void Scheduler::resetStats()
+{
+  for (uint8_t i = 0; i < MAX_TASKS; i++)
+  {
+    tasks[i].lateCount = 0;
+    tasks[i].maxLateness = 0;
+  }
+  runCount = 0;
+}
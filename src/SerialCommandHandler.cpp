@@ -1,14 +1,38 @@
 #include "SerialCommandHandler.h"
 #include "Clock.h"
+#include "Buzzer.h"
+#include "Timebase.h"
+#include "Format.h"
+#include "MemoryMonitor.h"
+#include "Watchdog.h"
+#include <EEPROM.h>
 
 SerialCommandHandler::SerialCommandHandler()
-    : clock(nullptr), waitingForTimeInput(false), waitingForDateInput(false)
+    : clock(nullptr), scheduler(nullptr), power(nullptr), timeSync(nullptr), activityLog(nullptr),
+      climateLog(nullptr),
+      waitingForTimeInput(false),
+      waitingForDateInput(false), lineMicros(0)
 {
 }
 
-void SerialCommandHandler::begin(Clock *clock)
+void SerialCommandHandler::begin(Clock *clock, Scheduler *scheduler, Power *power, TimeSync *timeSync,
+                                 ActivityLog *activityLog, ClimateLog *climateLog)
 {
   this->clock = clock;
+  this->scheduler = scheduler;
+  this->power = power;
+  this->timeSync = timeSync;
+  this->activityLog = activityLog;
+  this->climateLog = climateLog;
+  if (Watchdog::getResetFlags() & RESET_WATCHDOG)
+  {
+    Serial.print(F("Restarted by the watchdog, stuck in "));
+    Serial.println(Watchdog::getStageName(Watchdog::getStalledStage()));
+  }
+  if (clock->isTimeLost())
+  {
+    Serial.println(F("RTC had stopped and is not set: use 'time' and 'date', or 'sync'"));
+  }
   Serial.println(F("Type 'help' for available commands"));
 }
 
@@ -22,24 +46,34 @@ void SerialCommandHandler::handleSerialInput()
   if (Serial.available())
   {
     String input = Serial.readStringUntil('\n');
+#ifdef CLOCK_RECORD
+    recordInput(input);
+#endif
     input.trim();
+    execute(input);
+  }
+}
 
-    if (waitingForTimeInput)
-    {
-      parseTimeInput(input);
-      waitingForTimeInput = false;
-      return;
-    }
+void SerialCommandHandler::execute(const String &line)
+{
+  // Receive instant for 'sync'; the line has just been read in full
+  lineMicros = micros();
 
-    if (waitingForDateInput)
-    {
-      parseDateInput(input);
-      waitingForDateInput = false;
-      return;
-    }
+  if (waitingForTimeInput)
+  {
+    parseTimeInput(line);
+    waitingForTimeInput = false;
+    return;
+  }
 
-    processCommand(input);
+  if (waitingForDateInput)
+  {
+    parseDateInput(line);
+    waitingForDateInput = false;
+    return;
   }
+
+  processCommand(line);
 }
 
 void SerialCommandHandler::processCommand(const String &command)
@@ -77,6 +111,53 @@ void SerialCommandHandler::processCommand(const String &command)
   {
     handleDateCommand(cmd.substring(5));
   }
+  // Host time sync
+  else if (cmd == "sync")
+  {
+    showSync();
+  }
+  else if (cmd.startsWith("sync "))
+  {
+    handleSyncCommand(cmd.substring(5));
+  }
+  // Time zone
+  else if (cmd == "tz")
+  {
+    showTimeZone();
+  }
+  else if (cmd.startsWith("tz "))
+  {
+    handleTimeZoneCommand(cmd.substring(3));
+  }
+  // Resonator calibration
+  else if (cmd == "cal")
+  {
+    showCalibration();
+  }
+  else if (cmd == "cal reset")
+  {
+    clock->resetCalibration();
+    Serial.println(F("Calibration reset"));
+  }
+  // Activity log
+  else if (cmd == "log")
+  {
+    showLog();
+  }
+  else if (cmd == "log clear" && activityLog)
+  {
+    activityLog->clear();
+    Serial.println(F("Log cleared"));
+  }
+  // Temperature and humidity history
+  else if (cmd == "climate")
+  {
+    showClimate();
+  }
+  else if (cmd.startsWith("climate "))
+  {
+    handleClimateCommand(cmd.substring(8));
+  }
   // Alarm commands
   else if (cmd == "alarm" || cmd == "a")
   {
@@ -95,6 +176,86 @@ void SerialCommandHandler::processCommand(const String &command)
   {
     handleTimerCommand(cmd.substring(6));
   }
+  // Buzzer commands
+  else if (cmd == "buzzer" || cmd == "b")
+  {
+    showBuzzerHelp();
+  }
+  else if (cmd.startsWith("buzzer "))
+  {
+    handleBuzzerCommand(cmd.substring(7));
+  }
+  // Scheduler statistics
+  else if (cmd == "tasks")
+  {
+    showTasks();
+  }
+  else if (cmd == "tasks reset" && scheduler)
+  {
+    scheduler->resetStats();
+    Serial.println(F("Task statistics reset"));
+  }
+  // Stack and heap
+  else if (cmd == "mem")
+  {
+    showMemory();
+  }
+  // Watchdog and I2C recovery
+  else if (cmd == "wdt")
+  {
+    showWatchdog();
+  }
+  // Power management
+  else if (cmd == "power")
+  {
+    showPower();
+  }
+  else if (cmd == "power reset" && power)
+  {
+    power->resetStats();
+    Serial.println(F("Power statistics reset"));
+  }
+  else if (cmd == "night")
+  {
+    showNight();
+  }
+  else if (cmd.startsWith("night "))
+  {
+    handleNightCommand(cmd.substring(6));
+  }
+#ifdef CLOCK_PROFILE
+  // Loop profiler
+  else if (cmd == "perf")
+  {
+    showProfile();
+  }
+  else if (cmd == "perf reset")
+  {
+    Profiler::reset();
+    Serial.println(F("Profile reset"));
+  }
+#endif
+#ifdef CLOCK_RECORD
+  // Input recorder
+  else if (cmd == "rec")
+  {
+    showRecorder();
+  }
+  else if (cmd == "rec on")
+  {
+    Recorder::start(clock->getUnixTime());
+    Serial.println(F("Recording restarted"));
+  }
+  else if (cmd == "rec off")
+  {
+    Recorder::stop();
+    Serial.println(F("Recording stopped"));
+  }
+  else if (cmd == "rec dump")
+  {
+    dumpRecorder();
+  }
+#endif
   else
   {
     Serial.print(F("Unknown command: '"));
@@ -114,9 +275,14 @@ void SerialCommandHandler::handleTimeCommand(const String &timeStr)
   Time time = parseTimeString(timeStr);
   if (isValidTime(time))
   {
-    clock->setTime(time);
+    if (!clock->setTime(time))
+    {
+      Serial.println(F("RTC write failed, I2C bus timed out"));
+      return;
+    }
     Serial.print(F("Time set to: "));
-    Serial.println(formatTime(time.hour, time.minute, time.second));
+    Format::printTime(Serial, time.hour, time.minute, time.second);
+    Serial.println();
   }
   else
   {
@@ -135,31 +301,205 @@ void SerialCommandHandler::handleDateCommand(const String &dateStr)
   Date date = parseDateString(dateStr);
   if (isValidDate(date))
   {
-    clock->setDate(date);
+    if (!clock->setDate(date))
+    {
+      Serial.println(F("RTC write failed, I2C bus timed out"));
+      return;
+    }
     Serial.print(F("Date set to: "));
-    Serial.println(formatDate(date.day, date.month, date.year));
+    Format::printDate(Serial, date.day, date.month, date.year);
+    Serial.println();
   }
   else
   {
-    Serial.println(F("Invalid date values. Day: 1-31, Month: 1-12, Year: 2000-2099"));
+    Serial.println(F("Invalid date values. Day: 1 to the last of the month, Month: 1-12, Year: 2000-2099"));
+  }
+}
+
+// The DS1307 counts from 2000
+static const EpochTime SYNC_EARLIEST_TIME = 946684800UL;
+
+void SerialCommandHandler::handleSyncCommand(const String &syncCmd)
+{
+  if (!timeSync)
+  {
+    Serial.println(F("No time sync"));
+    return;
+  }
+
+  if (syncCmd.startsWith("set "))
+  {
+    // sync set <micros> <unix>: write the time at that instant
+    int space = syncCmd.indexOf(' ', 4);
+    uint32_t at = strtoul(syncCmd.substring(4, space).c_str(), nullptr, 10);
+    EpochTime time = strtoul(syncCmd.substring(space + 1).c_str(), nullptr, 10);
+    if (space < 0 || time < SYNC_EARLIEST_TIME || !timeSync->schedule(at, time))
+    {
+      Serial.println(F("Invalid sync instant. Use 'sync set <micros> <unix>' within 10 s"));
+      return;
+    }
+    Serial.print(F("SYNC SET "));
+    Serial.print(at);
+    Serial.print(' ');
+    Serial.println(time);
+    return;
+  }
+
+  // sync <token>: echo the host's token with the receive and transmit
+  // instants and the start of the current RTC second
+  uint32_t transmit = micros();
+  Serial.print(F("SYNC "));
+  Serial.print(syncCmd);
+  Serial.print(' ');
+  Serial.print(lineMicros);
+  Serial.print(' ');
+  Serial.print(transmit);
+  Serial.print(' ');
+  Serial.print(clock->getUnixTime());
+  Serial.print(' ');
+  Serial.println(clock->getSecondMicros());
+}
+
+void SerialCommandHandler::showSync()
+{
+  if (!timeSync)
+  {
+    Serial.println(F("No time sync"));
+    return;
+  }
+  Serial.print(F("Sync: "));
+  if (timeSync->isPending())
+  {
+    Serial.println(F("write pending"));
+  }
+  else if (timeSync->hasWriteFailed())
+  {
+    Serial.println(F("last write failed, I2C bus timed out"));
+  }
+  else
+  {
+    Serial.print(F("last write "));
+    Serial.print(timeSync->getLastLateness());
+    Serial.println(F(" us late"));
+  }
+}
+
+void SerialCommandHandler::handleTimeZoneCommand(const String &zoneStr)
+{
+  int index = zoneStr.toInt() - 1;
+  if (index < 0 || !clock->setTimeZone(index))
+  {
+    Serial.println(F("Invalid time zone. Use 'tz' for the list."));
+    return;
+  }
+  showTimeZone();
+}
+
+void SerialCommandHandler::showTimeZone()
+{
+  const TimeZone &zone = clock->getTimeZone();
+  EpochTime now = clock->getUnixTime();
+  int32_t offset = zone.getOffset(now);
+  uint16_t minutes = (offset < 0 ? -offset : offset) / 60;
+
+  Serial.print(F("Time zone: "));
+  Serial.print(TimeZone::getName(zone.getSelected()));
+  Serial.print(offset < 0 ? F(" (UTC-") : F(" (UTC+"));
+  Format::printTime(Serial, minutes / 60, minutes % 60);
+  Serial.println(zone.isDst(now) ? F(", DST)") : F(")"));
+
+  EpochTime change = zone.getNextChange(now);
+  if (change != 0)
+  {
+    // Shown in the local time it changes to
+    EpochTime local = zone.toLocal(change);
+    Date date = Epoch::toDate(local);
+    Time time = Epoch::toTime(local);
+    Serial.print(F("Next change: "));
+    Format::printDate(Serial, date.day, date.month, date.year);
+    Serial.print(' ');
+    Format::printTime(Serial, time.hour, time.minute, time.second);
+    Serial.println();
+  }
+
+  for (uint8_t i = 0; i < TimeZone::COUNT; i++)
+  {
+    Serial.print(i == zone.getSelected() ? F("* ") : F("  "));
+    Serial.print(i + 1);
+    Serial.print(F(": "));
+    Serial.println(TimeZone::getName(i));
   }
 }
 
 void SerialCommandHandler::handleAlarmCommand(const String &alarmCmd)
+{
+  if (alarmCmd == "list")
+  {
+    showAlarmList();
+  }
+  else if (alarmCmd == "snooze")
+  {
+    if (clock->getAlarmState() == ALARM_RINGING)
+    {
+      clock->snoozeAlarm();
+      Serial.println(F("Alarm snoozed"));
+    }
+    else
+    {
+      Serial.println(F("Alarm is not ringing"));
+    }
+  }
+  else if (alarmCmd.startsWith("snooze "))
+  {
+    handleAlarmSnoozeCommand(alarmCmd.substring(7));
+  }
+  else if (alarmCmd == "dismiss")
+  {
+    clock->dismissAlarm();
+    Serial.println(F("Alarm dismissed"));
+  }
+  else if (alarmCmd.length() >= 2 && isDigit(alarmCmd[0]) && alarmCmd[1] == ' ')
+  {
+    // alarm N <command>
+    int index = alarmCmd[0] - '1';
+    if (index < 0 || index >= MAX_ALARMS)
+    {
+      Serial.print(F("Invalid alarm number. Use 1-"));
+      Serial.println(MAX_ALARMS);
+      return;
+    }
+    handleAlarmEntryCommand(index, alarmCmd.substring(2));
+  }
+  else
+  {
+    // Without a number the command applies to alarm 1
+    handleAlarmEntryCommand(0, alarmCmd);
+  }
+}
+
+void SerialCommandHandler::handleAlarmEntryCommand(uint8_t index, const String &alarmCmd)
 {
   if (alarmCmd == "on")
   {
-    clock->enableAlarm();
-    Serial.println(F("Alarm enabled"));
+    clock->enableAlarm(index);
+    Serial.print(F("Alarm "));
+    Serial.print(index + 1);
+    Serial.println(F(" enabled"));
   }
   else if (alarmCmd == "off")
   {
-    clock->disableAlarm();
-    Serial.println(F("Alarm disabled"));
+    clock->disableAlarm(index);
+    Serial.print(F("Alarm "));
+    Serial.print(index + 1);
+    Serial.println(F(" disabled"));
   }
   else if (alarmCmd.startsWith("set "))
   {
-    handleAlarmSetCommand(alarmCmd.substring(4));
+    handleAlarmSetCommand(index, alarmCmd.substring(4));
+  }
+  else if (alarmCmd.startsWith("days "))
+  {
+    handleAlarmDaysCommand(index, alarmCmd.substring(5));
   }
   else
   {
@@ -167,7 +507,7 @@ void SerialCommandHandler::handleAlarmCommand(const String &alarmCmd)
   }
 }
 
-void SerialCommandHandler::handleAlarmSetCommand(const String &timeStr)
+void SerialCommandHandler::handleAlarmSetCommand(uint8_t index, const String &timeStr)
 {
   if (timeStr.length() != 4)
   {
@@ -180,9 +520,12 @@ void SerialCommandHandler::handleAlarmSetCommand(const String &timeStr)
 
   if (isValidTimeValues(hour, minute, 0))
   {
-    clock->setAlarmTime(hour, minute);
-    Serial.print(F("Alarm set to: "));
-    Serial.println(formatTime(hour, minute, 0));
+    clock->setAlarmTime(index, hour, minute);
+    Serial.print(F("Alarm "));
+    Serial.print(index + 1);
+    Serial.print(F(" set to: "));
+    Format::printTime(Serial, hour, minute, 0);
+    Serial.println();
   }
   else
   {
@@ -190,6 +533,62 @@ void SerialCommandHandler::handleAlarmSetCommand(const String &timeStr)
   }
 }
 
+void SerialCommandHandler::handleAlarmDaysCommand(uint8_t index, const String &daysStr)
+{
+  // Seven 0/1 flags, Monday first (e.g. 1111100 = weekdays)
+  if (daysStr.length() != 7)
+  {
+    Serial.println(F("Invalid days format. Use 7 digits Mon-Sun, e.g. 1111100"));
+    return;
+  }
+
+  uint8_t days = 0;
+  for (uint8_t i = 0; i < 7; i++)
+  {
+    if (daysStr[i] == '1')
+    {
+      days |= 1 << ((i + 1) % 7);
+    }
+    else if (daysStr[i] != '0')
+    {
+      Serial.println(F("Invalid days format. Use 7 digits Mon-Sun, e.g. 1111100"));
+      return;
+    }
+  }
+
+  clock->setAlarmDays(index, days);
+  Serial.print(F("Alarm "));
+  Serial.print(index + 1);
+  Serial.print(F(" days: "));
+  Format::printDays(Serial, days);
+  Serial.println();
+}
+
+void SerialCommandHandler::handleAlarmSnoozeCommand(const String &snoozeStr)
+{
+  // MM N: snooze interval in minutes and number of snoozes
+  if (snoozeStr.length() != 4 || snoozeStr[2] != ' ' || !isDigit(snoozeStr[3]))
+  {
+    Serial.println(F("Invalid snooze format. Use MM N"));
+    return;
+  }
+
+  int minutes = snoozeStr.substring(0, 2).toInt();
+  int limit = snoozeStr[3] - '0';
+  if (minutes < 1 || minutes > 60)
+  {
+    Serial.println(F("Invalid snooze interval. Minutes: 1-60"));
+    return;
+  }
+
+  clock->setAlarmSnooze({static_cast<uint8_t>(minutes), static_cast<uint8_t>(limit)});
+  Serial.print(F("Snooze: "));
+  Serial.print(minutes);
+  Serial.print(F(" min, up to "));
+  Serial.print(limit);
+  Serial.println(F(" times"));
+}
+
 void SerialCommandHandler::handleTimerCommand(const String &timerCmd)
 {
   if (timerCmd == "start")
@@ -230,7 +629,8 @@ void SerialCommandHandler::handleTimerSetCommand(const String &timeStr)
   {
     clock->setTimerTime(time.hour, time.minute, time.second);
     Serial.print(F("Timer set to: "));
-    Serial.println(formatTime(time.hour, time.minute, time.second));
+    Format::printTime(Serial, time.hour, time.minute, time.second);
+    Serial.println();
   }
   else
   {
@@ -238,6 +638,33 @@ void SerialCommandHandler::handleTimerSetCommand(const String &timeStr)
   }
 }
 
+void SerialCommandHandler::handleBuzzerCommand(const String &buzzerCmd)
+{
+  if (buzzerCmd == "stop")
+  {
+    clock->stopMelody();
+    Serial.println(F("Buzzer stopped"));
+    return;
+  }
+
+  int index = buzzerCmd.toInt() - 1;
+  if (buzzerCmd.length() != 1 || index < 0 || index >= MELODY_COUNT)
+  {
+    Serial.println(F("Invalid buzzer command. Use 'buzzer' for help."));
+    return;
+  }
+
+  if (clock->previewMelody(index))
+  {
+    Serial.print(F("Playing melody: "));
+    Serial.println(Buzzer::getMelodyName(index));
+  }
+  else
+  {
+    Serial.println(F("Buzzer busy with a ringing alarm"));
+  }
+}
+
 Time SerialCommandHandler::parseTimeString(const String &timeStr)
 {
   if (timeStr.length() == 4)
@@ -275,9 +702,10 @@ bool SerialCommandHandler::isValidTimeValues(int hour, int minute, int second)
 
 bool SerialCommandHandler::isValidDate(const Date &date)
 {
-  return (date.day >= 1 && date.day <= 31 &&
-          date.month >= 1 && date.month <= 12 &&
-          date.year >= 2000 && date.year <= 2099);
+  // Epoch::fromFields() would roll 31.02. over into March
+  return (date.month >= 1 && date.month <= 12 &&
+          date.year >= 2000 && date.year <= 2099 &&
+          date.day >= 1 && date.day <= Epoch::daysInMonth(date.year, date.month));
 }
 
 void SerialCommandHandler::showHelp()
@@ -287,8 +715,29 @@ void SerialCommandHandler::showHelp()
   Serial.println(F("  status, s        - Show current time and sensor data"));
   Serial.println(F("  time, t          - Set RTC time"));
   Serial.println(F("  date, d          - Set RTC date"));
+  Serial.println(F("  tz [N]           - Show or select the time zone"));
+  Serial.println(F("  sync             - Host time sync state (see tools/timesync.py)"));
+  Serial.println(F("  cal [reset]      - Resonator error measured against the RTC"));
+  Serial.println(F("  log [clear]      - Activity log: alarms, settings, power-ups, faults"));
+  Serial.println(F("  climate [N|off]  - Climate log state, or sample every N min"));
+  Serial.println(F("  climate csv      - Print the climate log as CSV"));
+  Serial.println(F("  climate clear    - Erase the climate log"));
   Serial.println(F("  alarm, a         - Show alarm commands"));
   Serial.println(F("  timer, tr        - Show timer commands"));
+  Serial.println(F("  buzzer, b        - Show buzzer commands"));
+  Serial.println(F("  tasks [reset]    - Show scheduled tasks and lateness"));
+  Serial.println(F("  mem              - Show stack peak, heap blocks and headroom"));
+  Serial.println(F("  wdt              - Show the last reset cause and late loop passes"));
+  Serial.println(F("  power [reset]    - Show sleep time, wake sources, current"));
+  Serial.println(F("  night on|off     - Display off and power-down at night"));
+  Serial.println(F("  night HHMM HHMM  - Night mode between two times"));
+#ifdef CLOCK_PROFILE
+  Serial.println(F("  perf [reset]     - Show loop stage timings and counters"));
+#endif
+#ifdef CLOCK_RECORD
+  Serial.println(F("  rec [on|off]     - Input recorder status, restart or stop"));
+  Serial.println(F("  rec dump         - Print the recorded inputs for replay"));
+#endif
   Serial.println(F(""));
   Serial.println(F("Time format: HHMMSS (24-hour)"));
   Serial.println(F("Date format: DDMMYYYY"));
@@ -297,9 +746,40 @@ void SerialCommandHandler::showHelp()
 void SerialCommandHandler::showAlarmHelp()
 {
   Serial.println(F("Alarm commands:"));
-  Serial.println(F("  alarm on - Enable alarm"));
-  Serial.println(F("  alarm off - Disable alarm"));
-  Serial.println(F("  alarm set HHMM - Set alarm time"));
+  Serial.println(F("  alarm list - Show all alarms"));
+  Serial.println(F("  alarm [N] on - Enable alarm N (default 1)"));
+  Serial.println(F("  alarm [N] off - Disable alarm N"));
+  Serial.println(F("  alarm [N] set HHMM - Set alarm N time"));
+  Serial.println(F("  alarm [N] days MTWTFSS - Set alarm N days (0/1, Mon-Sun)"));
+  Serial.println(F("  alarm snooze - Snooze the ringing alarm"));
+  Serial.println(F("  alarm dismiss - Stop the ringing or snoozed alarm"));
+  Serial.println(F("  alarm snooze MM N - Snooze for MM minutes, up to N times"));
+}
+
+void SerialCommandHandler::showAlarmList()
+{
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    AlarmData alarmData = clock->getAlarmTime(i);
+    Serial.print(F("Alarm "));
+    Serial.print(i + 1);
+    Serial.print(F(": "));
+    Format::printTime(Serial, alarmData.hour, alarmData.minute, 0);
+    Serial.print(F(" "));
+    Format::printDays(Serial, alarmData.days);
+    Serial.println(alarmData.enabled ? F(" (Enabled)") : F(" (Disabled)"));
+  }
+
+  int8_t next = clock->getNextAlarm();
+  if (next >= 0)
+  {
+    uint32_t nextTime = clock->getNextAlarmTime();
+    Serial.print(F("Next: alarm "));
+    Serial.print(next + 1);
+    Serial.print(F(" at "));
+    Format::printTime(Serial, (nextTime / 3600) % 24, (nextTime / 60) % 60, 0);
+    Serial.println();
+  }
 }
 
 void SerialCommandHandler::showTimerHelp()
@@ -311,6 +791,579 @@ void SerialCommandHandler::showTimerHelp()
   Serial.println(F("  timer set HHMMSS - Set timer duration"));
 }
 
+void SerialCommandHandler::showBuzzerHelp()
+{
+  Serial.println(F("Buzzer commands:"));
+  Serial.println(F("  buzzer N - Preview melody N once"));
+  Serial.println(F("  buzzer stop - Stop the preview"));
+  for (uint8_t i = 0; i < MELODY_COUNT; i++)
+  {
+    Serial.print(F("  "));
+    Serial.print(i + 1);
+    Serial.print(F(": "));
+    Serial.println(Buzzer::getMelodyName(i));
+  }
+}
+
+void SerialCommandHandler::showCalibration()
+{
+  const Calibration &calibration = clock->getCalibration();
+  Serial.print(F("Calibration: "));
+  if (calibration.hasEstimate())
+  {
+    int16_t ppm = calibration.getEstimate();
+    if (ppm >= 0)
+    {
+      Serial.print('+');
+    }
+    Serial.print(ppm);
+    Serial.print(F(" ppm (saved "));
+    Serial.print(calibration.getSaved());
+    Serial.println(F(")"));
+
+    // What millis() alone would gain or lose, in tenths of a second a day
+    int32_t tenths = (int32_t)ppm * 864 / 1000;
+    uint32_t magnitude = tenths < 0 ? -tenths : tenths;
+    Serial.print(F("Uncorrected: "));
+    Serial.print(tenths < 0 ? '-' : '+');
+    Serial.print(magnitude / 10);
+    Serial.print('.');
+    Serial.print(magnitude % 10);
+    Serial.println(F(" s a day"));
+  }
+  else
+  {
+    Serial.println(F("none yet"));
+  }
+  Serial.print(F("Window: "));
+  Serial.print(calibration.getWindowSeconds());
+  Serial.print(F(" of "));
+  Serial.print(CALIBRATION_WINDOW);
+  Serial.print(F(" s, "));
+  Serial.print(calibration.getWindowCount());
+  Serial.println(F(" done since power-on"));
+}
+
+void SerialCommandHandler::showLog()
+{
+  if (!activityLog)
+  {
+    Serial.println(F("No activity log"));
+    return;
+  }
+
+  Serial.print(F("=== Log: "));
+  Serial.print(activityLog->getCount());
+  Serial.print(F(" records, "));
+  Serial.print(activityLog->getDropped());
+  Serial.println(F(" dropped since power-on ==="));
+
+  // Straight from EEPROM, one entry at a time
+  LogCursor cursor;
+  LogEntry entry;
+  activityLog->rewind(cursor);
+  while (activityLog->next(cursor, entry))
+  {
+    printLogEntry(entry);
+  }
+}
+
+void SerialCommandHandler::printLogEntry(const LogEntry &entry)
+{
+  if (entry.time == 0)
+  {
+    Serial.print(F("--.--.---- --:--:--"));
+  }
+  else
+  {
+    EpochTime local = clock->getTimeZone().toLocal(entry.time);
+    Date date = Epoch::toDate(local);
+    Time time = Epoch::toTime(local);
+    Format::printDate(Serial, date.day, date.month, date.year);
+    Serial.print(' ');
+    Format::printTime(Serial, time.hour, time.minute, time.second);
+  }
+  Serial.print(' ');
+  Serial.print(ActivityLog::getTypeName(entry.type));
+
+  switch (entry.type)
+  {
+  case LOG_POWER_UP:
+    if (entry.data && !(entry.data & RESET_POWER_ON))
+    {
+      Serial.print(F(", "));
+      printResetCause(entry.data);
+    }
+    break;
+  case LOG_ALARM_FIRED:
+  case LOG_ALARM_DISMISSED:
+    Serial.print(' ');
+    Serial.print((entry.data & 0x0F) + 1);
+    Serial.print(F(", round "));
+    Serial.print(entry.data >> 4);
+    break;
+  case LOG_TIMER_DONE:
+    Serial.print(F(", "));
+    Serial.print(entry.data);
+    Serial.print(F(" min"));
+    break;
+  case LOG_SETTINGS:
+    Serial.print(':');
+    if (entry.data & SETTINGS_CLOCK)
+      Serial.print(F(" clock"));
+    if (entry.data & SETTINGS_ZONE)
+      Serial.print(F(" zone"));
+    if (entry.data & SETTINGS_ALARMS)
+      Serial.print(F(" alarms"));
+    if (entry.data & SETTINGS_TIMER)
+      Serial.print(F(" timer"));
+    break;
+  case LOG_SENSOR_FAULT:
+    Serial.print(entry.data == SENSOR_NO_REPLY ? F(", no reply") : F(", out of range"));
+    break;
+  case LOG_DROPPED:
+    Serial.print(' ');
+    Serial.print(entry.data);
+    break;
+  case LOG_MEMORY_LOW:
+    Serial.print(F(", "));
+    Serial.print(entry.data);
+    Serial.print(F(" bytes left"));
+    break;
+  }
+  Serial.println();
+}
+
+void SerialCommandHandler::handleClimateCommand(const String &climateCmd)
+{
+  if (!climateLog)
+  {
+    Serial.println(F("No climate log"));
+    return;
+  }
+
+  if (climateCmd == "csv")
+  {
+    exportClimate();
+    return;
+  }
+  if (climateCmd == "clear")
+  {
+    climateLog->clear();
+    Serial.println(F("Climate log cleared"));
+    return;
+  }
+  if (climateCmd == "off")
+  {
+    climateLog->setInterval(0);
+  }
+  else
+  {
+    int minutes = climateCmd.toInt();
+    if (minutes < 1 || minutes > CLIMATE_MAX_INTERVAL)
+    {
+      Serial.println(F("Invalid climate command. Use 'climate N' (1-240 min), 'off', 'csv' or 'clear'"));
+      return;
+    }
+    climateLog->setInterval(minutes);
+  }
+  showClimate();
+}
+
+void SerialCommandHandler::showClimate()
+{
+  if (!climateLog)
+  {
+    Serial.println(F("No climate log"));
+    return;
+  }
+
+  Serial.print(F("Climate log: "));
+  if (climateLog->getInterval() == 0)
+  {
+    Serial.println(F("off"));
+  }
+  else
+  {
+    Serial.print(F("every "));
+    Serial.print(climateLog->getInterval());
+    Serial.println(F(" min"));
+  }
+
+  // Hundredths of a sample per byte
+  ClimateStats stats = climateLog->getStats();
+  uint16_t perByte = stats.bytes > 0 ? (uint32_t)stats.samples * 100 / stats.bytes : 0;
+  Serial.print(F("Stored: "));
+  Serial.print(stats.samples);
+  Serial.print(F(" samples in "));
+  Serial.print(stats.bytes);
+  Serial.print(F(" of "));
+  Serial.print(CLIMATE_BLOCKS * CLIMATE_BLOCK_BYTES);
+  Serial.print(F(" bytes, "));
+  Serial.print(perByte / 100);
+  Serial.print('.');
+  Serial.print(perByte % 100 < 10 ? F("0") : F(""));
+  Serial.print(perByte % 100);
+  Serial.println(F(" samples/byte"));
+
+  // In tenths of an hour
+  uint32_t tenths = stats.samples > 0 ? (stats.last - stats.first) / 360 : 0;
+  Serial.print(F("Span: "));
+  Serial.print(tenths / 10);
+  Serial.print('.');
+  Serial.print(tenths % 10);
+  Serial.println(F(" h"));
+}
+
+void SerialCommandHandler::exportClimate()
+{
+  // Decoded one sample at a time, straight from EEPROM
+  Serial.println(F("time,temperature,humidity"));
+  ClimateCursor cursor;
+  ClimateSample sample;
+  climateLog->rewind(cursor);
+  while (climateLog->next(cursor, sample))
+  {
+    Serial.print(sample.time);
+    Serial.print(',');
+    Serial.print(sample.temperature);
+    Serial.print(',');
+    Serial.println(sample.humidity);
+    Watchdog::feed(); // Some thousand lines at 115200 baud
+  }
+}
+
+void SerialCommandHandler::showTasks()
+{
+  if (!scheduler)
+  {
+    Serial.println(F("No scheduler"));
+    return;
+  }
+
+  Serial.println(F("=== Tasks ==="));
+  for (uint8_t i = 0; i < scheduler->getTaskCount(); i++)
+  {
+    const Task *task = scheduler->getTask(i);
+    if (!task)
+    {
+      continue;
+    }
+
+    Serial.print(task->name);
+    Serial.print(task->period > 0 ? F(": every ") : F(": once in "));
+    Serial.print(task->period > 0 ? task->period : (uint32_t)(task->nextRun - Timebase::millis()));
+    Serial.print(F(" ms, late "));
+    Serial.print(task->lateCount);
+    Serial.print(F(" times, worst "));
+    Serial.print(task->maxLateness);
+    Serial.println(F(" ms"));
+  }
+
+  Serial.print(F("Runs: "));
+  Serial.println(scheduler->getRunCount());
+  Serial.print(F("Next wake in: "));
+  Serial.print(scheduler->getTimeUntilNextTask());
+  Serial.println(F(" ms"));
+}
+
+void SerialCommandHandler::showMemory()
+{
+  if (!MemoryMonitor::isMeasured())
+  {
+    Serial.println(F("Memory is not measured on this build"));
+    return;
+  }
+
+  MemoryStats stats = MemoryMonitor::read();
+  Serial.println(F("=== Memory ==="));
+  Serial.print(F("Static: "));
+  Serial.print(stats.staticSize);
+  Serial.println(F(" bytes"));
+  Serial.print(F("Heap: "));
+  Serial.print(stats.heapUsed);
+  Serial.print(F(" bytes, "));
+  Serial.print(stats.heapFree);
+  Serial.print(F(" free in "));
+  Serial.print(stats.fragments);
+  Serial.println(F(" blocks"));
+  Serial.print(F("Largest free block: "));
+  Serial.print(stats.largestFree);
+  Serial.println(F(" bytes"));
+  Serial.print(F("Stack: "));
+  Serial.print(stats.stackNow);
+  Serial.print(F(" bytes, peak "));
+  Serial.println(stats.stackPeak);
+  Serial.print(F("Headroom: "));
+  Serial.print(stats.headroom);
+  Serial.println(F(" bytes never used"));
+}
+
+void SerialCommandHandler::showWatchdog()
+{
+  Serial.println(F("=== Watchdog ==="));
+  Serial.print(F("Last reset: "));
+  printResetCause(Watchdog::getResetReport());
+  Serial.println();
+  Serial.print(F("Late passes: "));
+  Serial.print(Watchdog::getLateCount());
+  Serial.print(F(" over "));
+  Serial.print(WATCHDOG_TIMEOUT);
+  Serial.println(F(" ms"));
+  Serial.print(F("I2C bus recoveries: "));
+  Serial.println(clock->getBusRecoveries());
+}
+
+void SerialCommandHandler::printResetCause(uint8_t report)
+{
+  // One cause; a power-on can set the brown-out flag as well
+  if (report & RESET_WATCHDOG)
+  {
+    Serial.print(F("watchdog, stuck in "));
+    Serial.print(Watchdog::getStageName(report >> 4));
+  }
+  else if (report & RESET_POWER_ON)
+  {
+    Serial.print(F("power-on"));
+  }
+  else if (report & RESET_BROWN_OUT)
+  {
+    Serial.print(F("brown-out"));
+  }
+  else if (report & RESET_EXTERNAL)
+  {
+    Serial.print(F("reset pin"));
+  }
+  else
+  {
+    Serial.print(F("unknown"));
+  }
+}
+
+void SerialCommandHandler::showPower()
+{
+  if (!power)
+  {
+    Serial.println(F("No power control"));
+    return;
+  }
+
+  Serial.println(F("=== Power ==="));
+  for (uint8_t i = 0; i < POWER_STATE_COUNT; i++)
+  {
+    PowerState state = (PowerState)i;
+    uint16_t current = Power::getStateCurrent(state);
+    Serial.print(Power::getStateName(state));
+    Serial.print(F(": "));
+    Serial.print(power->getStateSeconds(state));
+    Serial.print(F(" s at ~"));
+    Serial.print(current / 10);
+    Serial.print('.');
+    Serial.print(current % 10);
+    Serial.println(F(" mA"));
+  }
+
+  Serial.print(F("Wakes:"));
+  for (uint8_t i = 0; i < WAKE_SOURCE_COUNT; i++)
+  {
+    Serial.print(' ');
+    Serial.print(Power::getWakeSourceName((WakeSource)i));
+    Serial.print('=');
+    Serial.print(power->getWakeCount((WakeSource)i));
+  }
+  Serial.println();
+
+  uint16_t average = power->getAverageCurrent();
+  Serial.print(F("Average: ~"));
+  Serial.print(average / 10);
+  Serial.print('.');
+  Serial.print(average % 10);
+  Serial.println(F(" mA (estimate)"));
+}
+
+void SerialCommandHandler::handleNightCommand(const String &nightCmd)
+{
+  if (!power)
+  {
+    Serial.println(F("No power control"));
+    return;
+  }
+
+  if (nightCmd == "on")
+  {
+    power->setNightMode(NIGHT_ON);
+  }
+  else if (nightCmd == "off")
+  {
+    power->setNightMode(NIGHT_OFF);
+  }
+  else if (nightCmd.length() == 9 && nightCmd.charAt(4) == ' ')
+  {
+    int startHour = nightCmd.substring(0, 2).toInt();
+    int startMinute = nightCmd.substring(2, 4).toInt();
+    int endHour = nightCmd.substring(5, 7).toInt();
+    int endMinute = nightCmd.substring(7, 9).toInt();
+    if (!isValidTimeValues(startHour, startMinute, 0) || !isValidTimeValues(endHour, endMinute, 0))
+    {
+      Serial.println(F("Invalid time values. Hour: 0-23, Minute: 0-59"));
+      return;
+    }
+    power->setNightWindow(startHour * 60 + startMinute, endHour * 60 + endMinute);
+  }
+  else
+  {
+    Serial.println(F("Invalid night command. Use 'night on', 'night off' or 'night HHMM HHMM'"));
+    return;
+  }
+  showNight();
+}
+
+void SerialCommandHandler::showNight()
+{
+  if (!power)
+  {
+    Serial.println(F("No power control"));
+    return;
+  }
+
+  Serial.print(F("Night mode: "));
+  switch (power->getNightMode())
+  {
+  case NIGHT_ON:
+    Serial.println(F("on"));
+    break;
+  case NIGHT_AUTO:
+    Format::printTime(Serial, power->getNightStart() / 60, power->getNightStart() % 60, 0);
+    Serial.print(F(" - "));
+    Format::printTime(Serial, power->getNightEnd() / 60, power->getNightEnd() % 60, 0);
+    Serial.println();
+    break;
+  default:
+    Serial.println(F("off"));
+    break;
+  }
+}
+
+#ifdef CLOCK_PROFILE
+void SerialCommandHandler::showProfile()
+{
+  Serial.println(F("=== Loop profile (us) ==="));
+  Serial.print(F("stage    max     mean   <"));
+  for (uint8_t b = 0; b < PROFILE_BUCKETS - 1; b++)
+  {
+    Serial.print(Profiler::getBucketLimit(b));
+    Serial.print(b < PROFILE_BUCKETS - 2 ? F(" <") : F(" more"));
+  }
+  Serial.println();
+
+  for (uint8_t i = 0; i < STAGE_COUNT; i++)
+  {
+    const StageProfile &stage = Profiler::getStage((LoopStage)i);
+    Serial.print(Profiler::getStageName((LoopStage)i));
+    Serial.print(F(": "));
+    Serial.print(stage.maxMicros);
+    Serial.print(' ');
+    Serial.print(stage.samples ? stage.totalMicros / stage.samples : 0);
+    for (uint8_t b = 0; b < PROFILE_BUCKETS; b++)
+    {
+      Serial.print(' ');
+      Serial.print(stage.histogram[b]);
+    }
+    Serial.println();
+  }
+
+  for (uint8_t i = 0; i < COUNTER_COUNT; i++)
+  {
+    Serial.print(Profiler::getCounterName((ProfileCounter)i));
+    Serial.print(F(": "));
+    Serial.println(Profiler::getCounter((ProfileCounter)i));
+  }
+}
+#endif
+
+#ifdef CLOCK_RECORD
+void SerialCommandHandler::recordInput(const String &line)
+{
+  // The recorder's own commands stay out of the trace
+  String command = line;
+  command.trim();
+  if (command.startsWith("rec"))
+  {
+    return;
+  }
+  for (unsigned int i = 0; i < line.length(); i++)
+  {
+    Recorder::serial(line.charAt(i));
+  }
+  Recorder::serial('\n');
+}
+
+void SerialCommandHandler::showRecorder()
+{
+  Serial.print(F("Recorder: "));
+  Serial.println(Recorder::isRecording() ? F("on") : F("off"));
+  Serial.print(F("Events: "));
+  Serial.print(Recorder::getCount());
+  Serial.print('/');
+  Serial.print(RECORD_CAPACITY);
+  Serial.print(F(", overwritten: "));
+  Serial.println(Recorder::getDropped());
+}
+
+void SerialCommandHandler::dumpRecorder()
+{
+  // One event per line, milliseconds from the oldest kept event:
+  //   <ms> T | <ms> B <pin> <level> | <ms> S <byte>
+  Serial.print(F("REC start "));
+  Serial.print(Recorder::getBaseTime());
+  Serial.print(F(" events "));
+  Serial.print(Recorder::getCount());
+  Serial.print(F(" dropped "));
+  Serial.println(Recorder::getDropped());
+
+  // Settings as they are now, so the replay starts with the same alarms
+  Serial.print(F("EEPROM "));
+  for (uint8_t i = 0; i < RECORD_EEPROM_BYTES; i++)
+  {
+    uint8_t value = EEPROM.read(i);
+    Serial.print(value >> 4, HEX);
+    Serial.print(value & 0x0F, HEX);
+  }
+  Serial.println();
+
+  uint32_t elapsed = 0;
+  for (uint8_t i = 0; i < Recorder::getCount(); i++)
+  {
+    uint16_t delta;
+    uint8_t data;
+    RecordType type = Recorder::getEvent(i, delta, data);
+    elapsed += i ? delta : 0;
+    if (type == RECORD_GAP)
+    {
+      continue;
+    }
+
+    Serial.print(elapsed);
+    switch (type)
+    {
+    case RECORD_TICK:
+      Serial.println(F(" T"));
+      break;
+    case RECORD_BUTTON:
+      Serial.print(F(" B "));
+      Serial.print(data & 0x7F);
+      Serial.println(data & 0x80 ? F(" 1") : F(" 0"));
+      break;
+    default:
+      Serial.print(F(" S "));
+      Serial.println(data);
+      break;
+    }
+  }
+  Serial.println(F("REC_END"));
+}
+#endif
+
 void SerialCommandHandler::showStatus()
 {
   Time currentTime = clock->getTime();
@@ -320,10 +1373,14 @@ void SerialCommandHandler::showStatus()
 
   Serial.println(F("=== Clock Status ==="));
   Serial.print(F("Time: "));
-  Serial.println(formatTime(currentTime.hour, currentTime.minute, currentTime.second));
+  Format::printTime(Serial, currentTime.hour, currentTime.minute, currentTime.second);
+  Serial.println();
 
   Serial.print(F("Date: "));
-  Serial.println(formatDate(currentDate.day, currentDate.month, currentDate.year));
+  Format::printDate(Serial, currentDate.day, currentDate.month, currentDate.year);
+  Serial.println(clock->isTimeLost() ? F(" (not set)") : F(""));
+  Serial.print(F("Time zone: "));
+  Serial.println(TimeZone::getName(clock->getTimeZone().getSelected()));
 
   Serial.print(F("Temperature: "));
   Serial.print(temperature);
@@ -333,23 +1390,39 @@ void SerialCommandHandler::showStatus()
   Serial.println(F("%"));
 
   // Show alarm status
-  AlarmData alarmData = clock->getAlarmTime();
+  int8_t nextAlarm = clock->getNextAlarm();
   Serial.print(F("Alarm: "));
-  if (alarmData.enabled)
+  if (nextAlarm >= 0)
   {
-    Serial.println(formatTime(alarmData.hour, alarmData.minute, 0));
+    AlarmData alarmData = clock->getAlarmTime(nextAlarm);
+    Format::printTime(Serial, alarmData.hour, alarmData.minute, 0);
+    Serial.print(F(" (Alarm "));
+    Serial.print(nextAlarm + 1);
+    Serial.println(F(")"));
   }
   else
   {
     Serial.println(F("Disabled"));
   }
 
+  AlarmState alarmState = clock->getAlarmState();
+  if (alarmState != ALARM_ARMED)
+  {
+    Serial.print(alarmState == ALARM_RINGING ? F("Alarm ringing") : F("Alarm snoozed"));
+    Serial.print(F(" (snooze "));
+    Serial.print(clock->getAlarmSnoozeCount());
+    Serial.print(F("/"));
+    Serial.print(clock->getAlarmSnooze().limit);
+    Serial.println(F(")"));
+  }
+
   // Show timer status
   TimerData timerData = clock->getTimerTime();
   Serial.print(F("Timer: "));
   if (timerData.running)
   {
-    Serial.println(formatTime(timerData.hour, timerData.minute, timerData.second));
+    Format::printTime(Serial, timerData.hour, timerData.minute, timerData.second);
+    Serial.println();
     Serial.println(F(" (Running)"));
   }
   else if (timerData.completed)
@@ -358,7 +1431,8 @@ void SerialCommandHandler::showStatus()
   }
   else
   {
-    Serial.println(formatTime(timerData.hour, timerData.minute, timerData.second));
+    Format::printTime(Serial, timerData.hour, timerData.minute, timerData.second);
+    Serial.println();
     Serial.println(F(" (Stopped)"));
   }
 }
@@ -380,9 +1454,14 @@ void SerialCommandHandler::parseTimeInput(const String &input)
   if (input.length() == 6 && isValidTimeFormat(input))
   {
     Time time = parseTimeString(input);
-    clock->setTime(time);
+    if (!clock->setTime(time))
+    {
+      Serial.println(F("RTC write failed, I2C bus timed out"));
+      return;
+    }
     Serial.print(F("Time set to: "));
-    Serial.println(formatTime(time.hour, time.minute, time.second));
+    Format::printTime(Serial, time.hour, time.minute, time.second);
+    Serial.println();
   }
   else
   {
@@ -395,9 +1474,14 @@ void SerialCommandHandler::parseDateInput(const String &input)
   if (input.length() == 8 && isValidDateFormat(input))
   {
     Date date = parseDateString(input);
-    clock->setDate(date);
+    if (!clock->setDate(date))
+    {
+      Serial.println(F("RTC write failed, I2C bus timed out"));
+      return;
+    }
     Serial.print(F("Date set to: "));
-    Serial.println(formatDate(date.day, date.month, date.year));
+    Format::printDate(Serial, date.day, date.month, date.year);
+    Serial.println();
   }
   else
   {
@@ -422,17 +1506,3 @@ bool SerialCommandHandler::isValidDateFormat(const String &dateStr)
   Date date = parseDateString(dateStr);
   return isValidDate(date);
 }
-
-String SerialCommandHandler::formatDate(int day, int month, int year)
-{
-  return String(day < 10 ? "0" : "") + String(day) + "." +
-         String(month < 10 ? "0" : "") + String(month) + "." +
-         String(year);
-}
-
-String SerialCommandHandler::formatTime(int hour, int minute, int second)
-{
-  return String(hour < 10 ? "0" : "") + String(hour) + ":" +
-         String(minute < 10 ? "0" : "") + String(minute) + ":" +
-         String(second < 10 ? "0" : "") + String(second);
-}
\ No newline at end of file
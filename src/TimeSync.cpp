@@ -0,0 +1,72 @@
+#include "TimeSync.h"
+#include "Timebase.h"
+
+TimeSync::TimeSync() : clock(nullptr), scheduler(nullptr), task(-1), applyAt(0), applyTime(0),
+                       lastLateness(0), writeFailed(false)
+{
+}
+
+void TimeSync::begin(Clock *clock, Scheduler *scheduler)
+{
+  this->clock = clock;
+  this->scheduler = scheduler;
+}
+
+bool TimeSync::schedule(uint32_t at, EpochTime time)
+{
+  uint32_t lead = at - micros();
+  if (lead == 0 || lead > MAX_LEAD)
+  {
+    return false;
+  }
+  cancel();
+  applyAt = at;
+  applyTime = time;
+  // The scheduler counts calibrated ms; the instant is in raw micros()
+  uint32_t delay = Timebase::fromRaw(lead / 1000);
+  task = scheduler->after(F("sync"), delay > WAKE_EARLY ? delay - WAKE_EARLY : 0, onApply, this);
+  return task >= 0;
+}
+
+void TimeSync::cancel()
+{
+  if (task >= 0)
+  {
+    scheduler->cancel(task);
+    task = -1;
+  }
+}
+
+bool TimeSync::isPending() const
+{
+  return task >= 0;
+}
+
+int32_t TimeSync::getLastLateness() const
+{
+  return lastLateness;
+}
+
+bool TimeSync::hasWriteFailed() const
+{
+  return writeFailed;
+}
+
+void TimeSync::onApply(void *context)
+{
+  static_cast<TimeSync *>(context)->apply();
+}
+
+void TimeSync::apply()
+{
+  task = -1;
+
+  // Wait out the last milliseconds; a late start is written at once
+  int32_t early = (int32_t)(applyAt - micros());
+  if (early > 0)
+  {
+    delayMicroseconds(early);
+  }
+  lastLateness = (int32_t)(micros() - applyAt);
+  writeFailed = !clock->setUnixTime(applyTime);
+}
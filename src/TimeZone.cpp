@@ -0,0 +1,151 @@
+#include "TimeZone.h"
+
+// Zones as {name, offset, save, start, end}. Changes are at the local time
+// before them: the EU changes at 01:00 UTC everywhere, the US at 02:00
+// local. Southern zones start DST late in the year and end it early.
+static const TimeZoneRule ZONES[] PROGMEM = {
+    {"UTC", 0, 0, {0, 0, 0, 0}, {0, 0, 0, 0}},
+    {"London", 0, 60, {3, 5, 0, 1}, {10, 5, 0, 2}},
+    {"Berlin", 60, 60, {3, 5, 0, 2}, {10, 5, 0, 3}},
+    {"Helsinki", 120, 60, {3, 5, 0, 3}, {10, 5, 0, 4}},
+    {"Moscow", 180, 0, {0, 0, 0, 0}, {0, 0, 0, 0}},
+    {"Kolkata", 330, 0, {0, 0, 0, 0}, {0, 0, 0, 0}},
+    {"Tokyo", 540, 0, {0, 0, 0, 0}, {0, 0, 0, 0}},
+    {"Sydney", 600, 60, {10, 1, 0, 2}, {4, 1, 0, 3}},
+    {"Auckland", 720, 60, {9, 5, 0, 2}, {4, 1, 0, 3}},
+    {"New York", -300, 60, {3, 2, 0, 2}, {11, 1, 0, 2}},
+    {"Chicago", -360, 60, {3, 2, 0, 2}, {11, 1, 0, 2}},
+    {"Denver", -420, 60, {3, 2, 0, 2}, {11, 1, 0, 2}},
+    {"Phoenix", -420, 0, {0, 0, 0, 0}, {0, 0, 0, 0}},
+    {"Los Angeles", -480, 60, {3, 2, 0, 2}, {11, 1, 0, 2}},
+};
+
+const uint8_t TimeZone::COUNT = sizeof(ZONES) / sizeof(ZONES[0]);
+
+TimeZone::TimeZone() : zone(0), periodStart(0), periodLength(0), offset(0)
+{
+}
+
+bool TimeZone::select(uint8_t zone)
+{
+  if (zone >= COUNT)
+  {
+    return false;
+  }
+  this->zone = zone;
+  periodLength = 0; // Found again on the next conversion
+  return true;
+}
+
+uint8_t TimeZone::getSelected() const
+{
+  return zone;
+}
+
+const __FlashStringHelper *TimeZone::getName(uint8_t zone)
+{
+  if (zone >= COUNT)
+  {
+    return nullptr;
+  }
+  return (const __FlashStringHelper *)ZONES[zone].name;
+}
+
+void TimeZone::getRule(TimeZoneRule &rule) const
+{
+  memcpy_P(&rule, &ZONES[zone], sizeof(TimeZoneRule));
+}
+
+EpochTime TimeZone::changeTime(const DstRule &change, uint16_t year, int32_t offsetBefore)
+{
+  // Count from the first of the month, or back from the last
+  Date date = {1, change.month, year};
+  if (change.week == 5)
+  {
+    date.day = Epoch::daysInMonth(year, change.month);
+  }
+  uint8_t weekday = Epoch::dayOfWeek(Epoch::fromFields(date, {0, 0, 0}));
+  if (change.week == 5)
+  {
+    date.day -= (weekday + 7 - change.dayOfWeek) % 7;
+  }
+  else
+  {
+    date.day += (change.dayOfWeek + 7 - weekday) % 7 + (change.week - 1) * 7;
+  }
+  return Epoch::fromFields(date, {change.hour, 0, 0}) - offsetBefore;
+}
+
+void TimeZone::findPeriod(EpochTime utc) const
+{
+  TimeZoneRule rule;
+  getRule(rule);
+  int32_t standard = rule.offset * 60L;
+  if (rule.start.month == 0)
+  {
+    // No DST: one period for all time
+    periodStart = 0;
+    periodLength = 0xFFFFFFFFUL;
+    offset = standard;
+    return;
+  }
+  int32_t daylight = standard + rule.save * 60L;
+
+  // The changes of the year before, this year and the next, in order. The
+  // last one up to utc starts the period and the one after it ends it.
+  uint16_t year = Epoch::toDate(utc).year;
+  EpochTime changes[6];
+  int32_t offsets[6]; // In force after each change
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    EpochTime start = changeTime(rule.start, year - 1 + i, standard);
+    EpochTime end = changeTime(rule.end, year - 1 + i, daylight);
+    bool startFirst = start < end;
+    changes[i * 2] = startFirst ? start : end;
+    offsets[i * 2] = startFirst ? daylight : standard;
+    changes[i * 2 + 1] = startFirst ? end : start;
+    offsets[i * 2 + 1] = startFirst ? standard : daylight;
+  }
+
+  uint8_t i = 0;
+  while (i < 4 && changes[i + 1] <= utc)
+  {
+    i++;
+  }
+  periodStart = changes[i];
+  periodLength = changes[i + 1] - changes[i];
+  offset = offsets[i];
+}
+
+EpochTime TimeZone::toUtc(EpochTime local) const
+{
+  int32_t standard = (int16_t)pgm_read_word(&ZONES[zone].offset) * 60L;
+  EpochTime utc = local - standard;
+  int32_t found = getOffset(utc);
+  if (found != standard)
+  {
+    // In DST, unless the local time is in the gap at its start
+    EpochTime daylight = local - found;
+    if (getOffset(daylight) == found)
+    {
+      return daylight;
+    }
+  }
+  return utc;
+}
+
+int32_t TimeZone::getOffset(EpochTime utc) const
+{
+  return (int32_t)(toLocal(utc) - utc);
+}
+
+bool TimeZone::isDst(EpochTime utc) const
+{
+  return getOffset(utc) != (int16_t)pgm_read_word(&ZONES[zone].offset) * 60L;
+}
+
+EpochTime TimeZone::getNextChange(EpochTime utc) const
+{
+  toLocal(utc);
+  return periodLength == 0xFFFFFFFFUL ? 0 : periodStart + periodLength;
+}
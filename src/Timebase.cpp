@@ -0,0 +1,72 @@
+#include "Timebase.h"
+
+int16_t Timebase::ppm = 0;
+int32_t Timebase::slowdown = 0;
+uint32_t Timebase::lastRaw = 0;
+uint32_t Timebase::behind = 0;
+int32_t Timebase::residue = 0;
+
+// ms * parts / 1000000 without 64-bit arithmetic; exact below 100000 s
+static int32_t partsOf(uint32_t ms, int32_t parts)
+{
+  return (int32_t)(ms / 1000) * parts / 1000 + (int32_t)(ms % 1000) * parts / 1000000L;
+}
+
+uint32_t Timebase::millis()
+{
+  uint32_t now = ::millis();
+  uint32_t elapsed = now - lastRaw;
+  lastRaw = now;
+  if (slowdown == 0)
+  {
+    return now - behind;
+  }
+
+  // Accumulate in millionths of a ms and take out whole ms. Chunks keep the
+  // product in range after a long sleep; it divides about once per whole ms.
+  while (elapsed > 0)
+  {
+    uint32_t chunk = elapsed < 50000UL ? elapsed : 50000UL;
+    residue += (int32_t)chunk * slowdown;
+    elapsed -= chunk;
+    if (residue >= 1000000L || residue <= -1000000L)
+    {
+      behind += residue / 1000000L;
+      residue %= 1000000L;
+    }
+  }
+  return now - behind;
+}
+
+uint32_t Timebase::toRaw(uint32_t ms)
+{
+  return ms + partsOf(ms, ppm);
+}
+
+uint32_t Timebase::fromRaw(uint32_t ms)
+{
+  return ms - partsOf(ms, slowdown);
+}
+
+void Timebase::setCorrection(int16_t ppm)
+{
+  if (ppm > MAX_PPM)
+  {
+    ppm = MAX_PPM;
+  }
+  else if (ppm < -MAX_PPM)
+  {
+    ppm = -MAX_PPM;
+  }
+
+  // Count up to now at the old rate first
+  millis();
+  Timebase::ppm = ppm;
+  // raw * 1e6 / (1e6 + ppm) == raw - raw * slowdown / 1e6
+  slowdown = ppm - (int32_t)ppm * ppm / (1000000L + ppm);
+}
+
+int16_t Timebase::getCorrection()
+{
+  return ppm;
+}
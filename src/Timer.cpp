@@ -1,136 +1,160 @@
 #include "Timer.h"
+#include "EventBus.h"
+#include "Timebase.h"
 
-Timer::Timer() : lastUpdate(0)
+Timer::Timer() : duration(0), elapsed(0), startTime(0), endTime(0),
+                 running(false), completed(false), scheduler(nullptr), deadlineTask(-1)
 {
+}
+
+void Timer::begin(Scheduler *scheduler)
+{
+  this->scheduler = scheduler;
   reset();
 }
 
-void Timer::begin()
+void Timer::scheduleDeadline()
 {
-  lastUpdate = millis();
+  cancelDeadline();
+  if (scheduler)
+  {
+    deadlineTask = scheduler->after(F("timer"), endTime - startTime, deadlineReached, this);
+  }
 }
 
-void Timer::start()
+void Timer::cancelDeadline()
 {
-  if (!data.completed && (data.hour > 0 || data.minute > 0 || data.second > 0))
+  if (scheduler && deadlineTask >= 0)
   {
-    data.running = true;
-    lastUpdate = millis();
+    scheduler->cancel(deadlineTask);
   }
+  deadlineTask = -1;
 }
 
-void Timer::stop()
+void Timer::deadlineReached(void *timer)
 {
-  data.running = false;
+  Timer *self = static_cast<Timer *>(timer);
+  self->deadlineTask = -1;
+  self->update();
 }
 
-void Timer::reset()
+void Timer::start()
 {
-  data.running = false;
-  data.completed = false;
-  data.hour = 0;
-  data.minute = 0;
-  data.second = 0;
-  lastUpdate = millis();
+  if (!running && !completed && elapsed < duration)
+  {
+    startTime = Timebase::millis();
+    endTime = startTime + (duration - elapsed);
+    running = true;
+    scheduleDeadline();
+  }
 }
 
-void Timer::update()
+void Timer::stop()
 {
-  if (data.running && !data.completed)
+  if (running)
   {
-    unsigned long currentMillis = millis();
-    
-    // Update every second
-    if (currentMillis - lastUpdate >= 1000)
+    cancelDeadline();
+    // Accumulate the time spent in this run segment
+    elapsed += (uint32_t)Timebase::millis() - startTime;
+    running = false;
+    if (elapsed >= duration)
     {
-      // Decrease timer
-      if (data.second > 0)
-      {
-        data.second--;
-      }
-      else if (data.minute > 0)
-      {
-        data.minute--;
-        data.second = 59;
-      }
-      else if (data.hour > 0)
-      {
-        data.hour--;
-        data.minute = 59;
-        data.second = 59;
-      }
-      else
-      {
-        data.completed = true;
-        data.running = false;
-      }
-      
-      lastUpdate = currentMillis;
+      elapsed = duration;
+      completed = true;
+      publish(TimerCompleted{duration});
     }
   }
 }
 
-void Timer::setTime(uint8_t hour, uint8_t minute, uint8_t second)
+void Timer::reset()
 {
-  data.hour = hour;
-  data.minute = minute;
-  data.second = second;
-  data.completed = false;
+  cancelDeadline();
+  running = false;
+  completed = false;
+  duration = 0;
+  elapsed = 0;
 }
 
-void Timer::adjustHour()
+void Timer::update()
 {
-  data.hour = (data.hour + 1) % 24;
+  if (running && getRemainingMillis() == 0)
+  {
+    cancelDeadline();
+    elapsed = duration;
+    running = false;
+    completed = true;
+    publish(TimerCompleted{duration});
+  }
 }
 
-void Timer::adjustMinute()
+void Timer::setDuration(uint32_t durationMs)
 {
-  data.minute = (data.minute + 1) % 60;
+  duration = durationMs;
+  elapsed = 0;
+  completed = false;
+
+  if (running)
+  {
+    // Restart the deadline from now with the new length
+    startTime = Timebase::millis();
+    endTime = startTime + duration;
+    scheduleDeadline();
+  }
 }
 
-void Timer::adjustSecond()
+void Timer::setTime(uint8_t hour, uint8_t minute, uint8_t second)
 {
-  data.second = (data.second + 1) % 60;
+  setDuration(Epoch::toSeconds({hour, minute, second}) * 1000UL);
 }
 
 bool Timer::isRunning() const
 {
-  return data.running;
+  return running;
 }
 
 bool Timer::isCompleted() const
 {
-  return data.completed;
+  return completed;
+}
+
+uint32_t Timer::getRemainingMillis() const
+{
+  if (!running)
+  {
+    return duration - elapsed;
+  }
+
+  // Signed difference handles millis() rollover between now and the deadline
+  int32_t remaining = (int32_t)(endTime - (uint32_t)Timebase::millis());
+  return remaining > 0 ? (uint32_t)remaining : 0;
 }
 
 uint8_t Timer::getHour() const
 {
-  return data.hour;
+  return getTime().hour;
 }
 
 uint8_t Timer::getMinute() const
 {
-  return data.minute;
+  return getTime().minute;
 }
 
 uint8_t Timer::getSecond() const
 {
-  return data.second;
+  return getTime().second;
 }
 
 TimerData Timer::getTime() const
 {
+  // Round up so the display reaches 00:00:00 exactly at the deadline
+  uint32_t seconds = (getRemainingMillis() + 999) / 1000;
+  Time fields = Epoch::toTime(seconds); // Durations stay under a day
+
+  TimerData data;
+  data.hour = fields.hour;
+  data.minute = fields.minute;
+  data.second = fields.second;
+  data.running = running;
+  data.completed = completed;
   return data;
 }
-
-char* Timer::getTimeString() const
-{
-  static char timerString[6];
-  timerString[0] = '0' + data.hour / 10;
-  timerString[1] = '0' + data.hour % 10;
-  timerString[2] = '0' + data.minute / 10;
-  timerString[3] = '0' + data.minute % 10;
-  timerString[4] = '0' + data.second / 10;
-  timerString[5] = '0' + data.second % 10;
-  return timerString;
-}
\ No newline at end of file
@@ -0,0 +1,434 @@
+#include "UserInterface.h"
+
+static_assert(UI_SET_TIMER - UI_SET_TIME == SETTING_TIMER, "one settings page per SETTING_*");
+static_assert(UI_PRESS_1 == BUTTON_DOWN * UI_BUTTONS && UI_CLICK_1 == BUTTON_SINGLE * UI_BUTTONS &&
+                  UI_LONG_1 == BUTTON_LONG * UI_BUTTONS && UI_RELEASE_1 == BUTTON_UP * UI_BUTTONS,
+              "button events follow ButtonAction");
+
+// Indexed by UiState: parent, entry, exit, render
+const UiStateInfo UserInterface::states[UI_STATE_COUNT] PROGMEM = {
+    {UI_NO_STATE, nullptr, nullptr, nullptr},                                          // DISPLAY
+    {UI_DISPLAY, nullptr, UserInterface::hideDot, UserInterface::renderTime},          // SHOW_TIME
+    {UI_DISPLAY, nullptr, nullptr, UserInterface::renderDate},                         // SHOW_DATE
+    {UI_DISPLAY, nullptr, nullptr, UserInterface::renderClimate},                      // SHOW_CLIMATE
+    {UI_DISPLAY, nullptr, nullptr, UserInterface::renderAlarm},                        // SHOW_ALARM
+    {UI_DISPLAY, nullptr, nullptr, UserInterface::renderTimer},                        // SHOW_TIMER
+    {UI_NO_STATE, UserInterface::openSettings, UserInterface::closeSettings, nullptr}, // SETTINGS
+    {UI_SETTINGS, UserInterface::restartBlink, nullptr, UserInterface::renderSetting}, // SET_TIME
+    {UI_SETTINGS, UserInterface::restartBlink, nullptr, UserInterface::renderSetting}, // SET_DATE
+    {UI_SETTINGS, UserInterface::restartBlink, nullptr, UserInterface::renderSetting}, // SET_ALARM_1
+    {UI_SETTINGS, UserInterface::restartBlink, nullptr, UserInterface::renderSetting}, // SET_ALARM_2
+    {UI_SETTINGS, UserInterface::restartBlink, nullptr, UserInterface::renderSetting}, // SET_ALARM_3
+    {UI_SETTINGS, UserInterface::restartBlink, nullptr, UserInterface::renderSetting}, // SET_ALARM_4
+    {UI_SETTINGS, UserInterface::restartBlink, nullptr, UserInterface::renderSetting}, // SET_TIMER
+};
+
+// Grouped by state; a child's row overrides its parent's for the same event
+const UiTransition UserInterface::transitions[] PROGMEM = {
+    // Holding a button shows its view until it is released
+    {UI_DISPLAY, UI_PRESS_1, UI_SHOW_DATE, nullptr},
+    {UI_DISPLAY, UI_PRESS_2, UI_SHOW_CLIMATE, nullptr},
+    {UI_DISPLAY, UI_PRESS_3, UI_SHOW_ALARM, nullptr},
+    {UI_DISPLAY, UI_PRESS_4, UI_SHOW_TIMER, nullptr},
+    {UI_DISPLAY, UI_LONG_1, UI_SET_TIME, nullptr},
+    {UI_DISPLAY, UI_SECOND, UI_NO_STATE, UserInterface::render},
+    {UI_DISPLAY, UI_DOT, UI_NO_STATE, UserInterface::render}, // Timer countdown
+    {UI_DISPLAY, UI_CLIMATE, UI_NO_STATE, UserInterface::toggleClimate},
+
+    {UI_SHOW_TIME, UI_DOT, UI_NO_STATE, UserInterface::toggleDot},
+
+    {UI_SHOW_DATE, UI_CLICK_1, UI_SHOW_TIME, nullptr},
+    {UI_SHOW_DATE, UI_RELEASE_1, UI_SHOW_TIME, nullptr},
+    {UI_SHOW_CLIMATE, UI_CLICK_2, UI_SHOW_TIME, nullptr},
+    {UI_SHOW_CLIMATE, UI_RELEASE_2, UI_SHOW_TIME, nullptr},
+    {UI_SHOW_ALARM, UI_CLICK_3, UI_SHOW_TIME, nullptr},
+    {UI_SHOW_ALARM, UI_RELEASE_3, UI_SHOW_TIME, nullptr},
+    {UI_SHOW_TIMER, UI_CLICK_4, UI_SHOW_TIME, nullptr},
+    {UI_SHOW_TIMER, UI_RELEASE_4, UI_SHOW_TIME, nullptr},
+
+    // Button 1 pages through the settings, the others adjust the fields.
+    // Edits are applied on the way out, or dropped when left alone.
+    {UI_SETTINGS, UI_LONG_1, UI_SHOW_TIME, UserInterface::commitSettings},
+    {UI_SETTINGS, UI_TIMEOUT, UI_SHOW_TIME, UserInterface::cancelSettings},
+    {UI_SETTINGS, UI_CLICK_2, UI_NO_STATE, UserInterface::adjustFirst},
+    {UI_SETTINGS, UI_CLICK_3, UI_NO_STATE, UserInterface::adjustSecond},
+    {UI_SETTINGS, UI_CLICK_4, UI_NO_STATE, UserInterface::adjustThird},
+    {UI_SETTINGS, UI_BLINK, UI_NO_STATE, UserInterface::toggleBlink},
+
+    // Back to the time page when the RTC did not take it; the draft is kept
+    {UI_DISPLAY, UI_WRITE_FAILED, UI_SET_TIME, nullptr},
+
+    {UI_SET_TIME, UI_CLICK_1, UI_SET_DATE, nullptr},
+    {UI_SET_DATE, UI_CLICK_1, UI_SET_ALARM_1, nullptr},
+    {UI_SET_ALARM_1, UI_CLICK_1, UI_SET_ALARM_2, nullptr},
+    {UI_SET_ALARM_2, UI_CLICK_1, UI_SET_ALARM_3, nullptr},
+    {UI_SET_ALARM_3, UI_CLICK_1, UI_SET_ALARM_4, nullptr},
+    {UI_SET_ALARM_4, UI_CLICK_1, UI_SET_TIMER, nullptr},
+    {UI_SET_TIMER, UI_CLICK_1, UI_SET_TIME, nullptr},
+};
+
+const uint8_t UserInterface::transitionCount = sizeof(transitions) / sizeof(transitions[0]);
+
+UserInterface::UserInterface()
+    : display(nullptr), clock(nullptr), scheduler(nullptr), buttonPins(nullptr),
+      state(UI_NO_STATE), dotOn(false), showTemperature(true), blinkOn(false), blinkTaskId(-1),
+      timeoutTaskId(-1), raised(UI_NO_EVENT)
+{
+}
+
+void UserInterface::begin(Display *display, Clock *clock, Scheduler *scheduler, const uint8_t *buttonPins)
+{
+  this->display = display;
+  this->clock = clock;
+  this->scheduler = scheduler;
+  this->buttonPins = buttonPins;
+
+  scheduler->every(F("dot"), DOT_INTERVAL, dotTask, this);
+  scheduler->every(F("temp/hum"), CLIMATE_INTERVAL, climateTask, this);
+
+  transition(UI_SHOW_TIME, nullptr);
+}
+
+void UserInterface::dispatch(uint8_t event)
+{
+  for (uint8_t handler = state; handler != UI_NO_STATE; handler = getParent(handler))
+  {
+    for (uint8_t i = 0; i < transitionCount; i++)
+    {
+      if (pgm_read_byte(&transitions[i].state) != handler ||
+          pgm_read_byte(&transitions[i].event) != event)
+      {
+        continue;
+      }
+
+      UiTransition row = getTransition(i);
+      if (row.target == UI_NO_STATE)
+      {
+        if (row.action)
+        {
+          row.action(this);
+        }
+      }
+      else
+      {
+        transition(row.target, row.action);
+      }
+
+      // An event the action raised goes to the state the transition ended in
+      if (raised != UI_NO_EVENT)
+      {
+        event = raised;
+        raised = UI_NO_EVENT;
+        dispatch(event);
+      }
+      return;
+    }
+  }
+}
+
+void UserInterface::handleButton(const ButtonEvent &event)
+{
+  int8_t index = buttonIndex(event.pin);
+  if (index < 0)
+  {
+    return;
+  }
+
+  if (isInSettings())
+  {
+    scheduler->restart(timeoutTaskId);
+  }
+
+  uint8_t action = event.action;
+  if (action == BUTTON_SINGLE && clock->getAlarmState() != ALARM_ARMED)
+  {
+    // Button 1 dismisses, any other button snoozes a ringing alarm
+    if (index == 0)
+    {
+      clock->dismissAlarm();
+      action = BUTTON_UP;
+    }
+    else if (clock->getAlarmState() == ALARM_RINGING)
+    {
+      clock->snoozeAlarm();
+      action = BUTTON_UP;
+    }
+  }
+
+  dispatch(action * UI_BUTTONS + index);
+}
+
+void UserInterface::transition(uint8_t target, UiAction action)
+{
+  // The nearest ancestor of the target that also holds the current state
+  // stays; a transition to the current state leaves and re-enters it
+  uint8_t common = getParent(target);
+  while (common != UI_NO_STATE && !contains(common, state))
+  {
+    common = getParent(common);
+  }
+
+  for (uint8_t leaving = state; leaving != common; leaving = getParent(leaving))
+  {
+    UiAction exit = readState(leaving).exit;
+    if (exit)
+    {
+      exit(this);
+    }
+  }
+
+  if (action)
+  {
+    action(this);
+  }
+
+  // Enter from the outside in
+  uint8_t path[UI_STATE_COUNT];
+  uint8_t depth = 0;
+  for (uint8_t entering = target; entering != common; entering = getParent(entering))
+  {
+    path[depth++] = entering;
+  }
+  while (depth > 0)
+  {
+    state = path[--depth];
+    UiAction entry = readState(state).entry;
+    if (entry)
+    {
+      entry(this);
+    }
+  }
+
+  render(this);
+}
+
+bool UserInterface::contains(uint8_t outer, uint8_t inner) const
+{
+  for (uint8_t s = inner; s != UI_NO_STATE; s = getParent(s))
+  {
+    if (s == outer)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+UiStateInfo UserInterface::readState(uint8_t state)
+{
+  UiStateInfo info;
+  memcpy_P(&info, &states[state], sizeof(info));
+  return info;
+}
+
+int8_t UserInterface::buttonIndex(uint8_t pin) const
+{
+  for (uint8_t i = 0; i < UI_BUTTONS; i++)
+  {
+    if (buttonPins[i] == pin)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+uint8_t UserInterface::getState() const
+{
+  return state;
+}
+
+bool UserInterface::isInSettings() const
+{
+  return contains(UI_SETTINGS, state);
+}
+
+uint8_t UserInterface::getParent(uint8_t state)
+{
+  return pgm_read_byte(&states[state].parent);
+}
+
+bool UserInterface::isLeaf(uint8_t state)
+{
+  for (uint8_t s = 0; s < UI_STATE_COUNT; s++)
+  {
+    if (getParent(s) == state)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint8_t UserInterface::getTransitionCount()
+{
+  return transitionCount;
+}
+
+UiTransition UserInterface::getTransition(uint8_t index)
+{
+  UiTransition row;
+  memcpy_P(&row, &transitions[index], sizeof(row));
+  return row;
+}
+
+// Scheduled events
+
+void UserInterface::dotTask(void *ui)
+{
+  static_cast<UserInterface *>(ui)->dispatch(UI_DOT);
+}
+
+void UserInterface::climateTask(void *ui)
+{
+  static_cast<UserInterface *>(ui)->dispatch(UI_CLIMATE);
+}
+
+void UserInterface::blinkTask(void *ui)
+{
+  static_cast<UserInterface *>(ui)->dispatch(UI_BLINK);
+}
+
+void UserInterface::timeoutTask(void *ui)
+{
+  static_cast<UserInterface *>(ui)->dispatch(UI_TIMEOUT);
+}
+
+// Table actions
+
+void UserInterface::render(UserInterface *ui)
+{
+  UiAction render = readState(ui->state).render;
+  if (render)
+  {
+    render(ui);
+  }
+}
+
+void UserInterface::renderTime(UserInterface *ui)
+{
+  char text[DISPLAY_CHARS];
+  ui->display->print(ui->clock->getTimeString(text));
+}
+
+void UserInterface::renderDate(UserInterface *ui)
+{
+  char text[DISPLAY_CHARS];
+  ui->display->print(ui->clock->getDateString(text));
+}
+
+void UserInterface::renderClimate(UserInterface *ui)
+{
+  char text[DISPLAY_CHARS];
+  if (ui->showTemperature)
+  {
+    ui->display->print(ui->clock->getTemperatureString(text));
+  }
+  else
+  {
+    ui->display->print(ui->clock->getHumidityString(text));
+  }
+}
+
+void UserInterface::renderAlarm(UserInterface *ui)
+{
+  char text[DISPLAY_CHARS];
+  ui->display->print(ui->clock->getAlarmTimeString(text));
+}
+
+void UserInterface::renderTimer(UserInterface *ui)
+{
+  char text[DISPLAY_CHARS];
+  ui->display->print(ui->clock->getTimerString(text));
+}
+
+void UserInterface::renderSetting(UserInterface *ui)
+{
+  if (!ui->blinkOn)
+  {
+    ui->display->clear();
+    return;
+  }
+
+  char text[DISPLAY_CHARS];
+  ui->display->print(ui->clock->getSettingString(text, ui->state - UI_SET_TIME));
+}
+
+void UserInterface::toggleDot(UserInterface *ui)
+{
+  ui->dotOn = !ui->dotOn;
+  ui->display->setDotState(ui->dotOn);
+}
+
+void UserInterface::hideDot(UserInterface *ui)
+{
+  ui->dotOn = false;
+  ui->display->setDotState(false);
+}
+
+void UserInterface::toggleClimate(UserInterface *ui)
+{
+  ui->showTemperature = !ui->showTemperature;
+  render(ui);
+}
+
+void UserInterface::openSettings(UserInterface *ui)
+{
+  ui->clock->beginSettings();
+
+  // Only run in settings, so the display modes don't wake up for them
+  ui->blinkTaskId = ui->scheduler->every(F("blink"), BLINK_INTERVAL, blinkTask, ui);
+  ui->timeoutTaskId = ui->scheduler->every(F("settings"), SETTINGS_MODE_TIMEOUT, timeoutTask, ui);
+}
+
+void UserInterface::closeSettings(UserInterface *ui)
+{
+  ui->scheduler->cancel(ui->blinkTaskId);
+  ui->scheduler->cancel(ui->timeoutTaskId);
+  ui->blinkTaskId = -1;
+  ui->timeoutTaskId = -1;
+}
+
+void UserInterface::commitSettings(UserInterface *ui)
+{
+  if (!ui->clock->commitSettings())
+  {
+    ui->raised = UI_WRITE_FAILED;
+  }
+}
+
+void UserInterface::cancelSettings(UserInterface *ui)
+{
+  ui->clock->cancelSettings();
+}
+
+void UserInterface::restartBlink(UserInterface *ui)
+{
+  // Each page starts blank for a full interval
+  ui->blinkOn = false;
+  ui->scheduler->restart(ui->blinkTaskId);
+}
+
+void UserInterface::toggleBlink(UserInterface *ui)
+{
+  ui->blinkOn = !ui->blinkOn;
+  render(ui);
+}
+
+void UserInterface::adjustFirst(UserInterface *ui)
+{
+  ui->clock->adjustSetting(ui->state - UI_SET_TIME, 0);
+  render(ui);
+}
+
+void UserInterface::adjustSecond(UserInterface *ui)
+{
+  ui->clock->adjustSetting(ui->state - UI_SET_TIME, 1);
+  render(ui);
+}
+
+void UserInterface::adjustThird(UserInterface *ui)
+{
+  ui->clock->adjustSetting(ui->state - UI_SET_TIME, 2);
+  render(ui);
+}
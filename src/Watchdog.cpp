@@ -0,0 +1,149 @@
+#include "Watchdog.h"
+
+#ifdef __AVR__
+#include <avr/wdt.h>
+#define NOINIT __attribute__((section(".noinit")))
+#else
+#define NOINIT
+#endif
+
+static const uint8_t STALL_MAGIC = 0xA5;
+
+// Left by the interrupt for the next boot. .noinit holds garbage after a
+// power-up, hence the magic and the complement.
+struct StallRecord
+{
+  uint8_t magic;
+  uint8_t stage;
+  uint8_t check; // ~stage
+};
+
+static StallRecord stall NOINIT;
+
+volatile uint8_t Watchdog::stage = WATCHDOG_SETUP;
+volatile bool Watchdog::fired = false;
+uint8_t Watchdog::resetFlags = 0;
+uint8_t Watchdog::stalledStage = WATCHDOG_UNKNOWN;
+uint16_t Watchdog::lateCount = 0;
+
+#ifdef __AVR__
+// Set before .bss is cleared, so it lives in .noinit too
+static uint8_t startupFlags NOINIT;
+
+// Runs from .init3, before anything else. After a watchdog reset the WDT
+// is still on at its shortest timeout, and would reset the board again
+// before setup(). Optiboot clears MCUSR itself and passes it on in r2; the
+// old bootloader leaves it alone.
+extern "C" void captureReset() __attribute__((naked, used, section(".init3")));
+
+void captureReset()
+{
+  uint8_t flags = 0;
+#ifndef CLOCK_NO_WATCHDOG
+  __asm__ __volatile__("mov %0, r2" : "=r"(flags));
+#endif
+  startupFlags = flags | MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+
+ISR(WDT_vect)
+{
+  Watchdog::onTimeout();
+}
+#endif
+
+uint8_t Watchdog::readResetFlags()
+{
+#ifdef __AVR__
+  return startupFlags & (RESET_POWER_ON | RESET_EXTERNAL | RESET_BROWN_OUT | RESET_WATCHDOG);
+#else
+  return RESET_POWER_ON;
+#endif
+}
+
+void Watchdog::begin(uint8_t resetFlags)
+{
+  Watchdog::resetFlags = resetFlags;
+  stalledStage = WATCHDOG_UNKNOWN;
+  if ((resetFlags & RESET_WATCHDOG) && stall.magic == STALL_MAGIC && stall.check == (uint8_t)~stall.stage)
+  {
+    stalledStage = stall.stage;
+  }
+  stall.magic = 0;
+  fired = false;
+  lateCount = 0;
+  stage = WATCHDOG_SETUP;
+
+#if defined(__AVR__) && !defined(CLOCK_NO_WATCHDOG)
+  // WDE and WDIE together: the first timeout interrupts, the next resets
+  wdt_enable(WDTO_2S);
+  WDTCSR |= _BV(WDIE);
+#endif
+}
+
+void Watchdog::feed()
+{
+#ifdef __AVR__
+  wdt_reset();
+#endif
+  if (fired)
+  {
+    // Late, but back in time: the hardware cleared WDIE for the reset
+    fired = false;
+    lateCount++;
+    stall.magic = 0;
+#if defined(__AVR__) && !defined(CLOCK_NO_WATCHDOG)
+    WDTCSR |= _BV(WDIE);
+#endif
+  }
+}
+
+void Watchdog::onTimeout()
+{
+  stall.stage = stage;
+  stall.check = ~stage;
+  stall.magic = STALL_MAGIC;
+  fired = true;
+}
+
+uint8_t Watchdog::getResetFlags()
+{
+  return resetFlags;
+}
+
+uint8_t Watchdog::getStalledStage()
+{
+  return stalledStage;
+}
+
+uint16_t Watchdog::getLateCount()
+{
+  return lateCount;
+}
+
+uint8_t Watchdog::getResetReport()
+{
+  return resetFlags & RESET_WATCHDOG ? resetFlags | stalledStage << 4 : resetFlags;
+}
+
+const __FlashStringHelper *Watchdog::getStageName(uint8_t stage)
+{
+  switch (stage)
+  {
+  case STAGE_SERIAL:
+    return F("serial");
+  case STAGE_TASKS:
+    return F("tasks");
+  case STAGE_BUTTONS:
+    return F("buttons");
+  case STAGE_CLOCK:
+    return F("clock");
+  case STAGE_LOOP:
+    return F("display and sleep");
+  case WATCHDOG_SETUP:
+    return F("setup");
+  default:
+    return F("unknown");
+  }
+}
@@ -9,6 +9,17 @@
 #include "Timer.h"
 #include "Alarm.h"
 #include "SerialCommandHandler.h"
+#include "Scheduler.h"
+#include "Power.h"
+#include "Profiler.h"
+#include "Recorder.h"
+#include "EventBus.h"
+#include "UserInterface.h"
+#include "TimeSync.h"
+#include "ActivityLog.h"
+#include "ClimateLog.h"
+#include "MemoryMonitor.h"
+#include "Watchdog.h"
 
 // DHT pin
 #define DHT_PIN A0
@@ -35,8 +46,10 @@
 // RTC pins
 #define RTC_SDA_PIN A4
 #define RTC_SCL_PIN A5
+#define RTC_SQW_PIN 2 // DS1307 SQW/OUT, 1 Hz wake-up (INT0)
 
 // Global objects
+Scheduler scheduler;
 Clock clock;
 Display display;
 RTClock rtc;
@@ -47,51 +60,91 @@ Button button4(BUTTON_4_PIN);
 Buzzer buzzer(BUZZER_PIN);
 HTSensor dht11(DHT_PIN);
 SerialCommandHandler serialHandler;
+Power power;
+UserInterface ui;
+TimeSync timeSync;
+ActivityLog activityLog;
+ClimateLog climateLog;
 
-// Mode variables
-bool isSettingsMode = false;
-unsigned long settingsModeStartTime = 0;
-uint16_t SETTINGS_MODE_TIMEOUT = 30000;
-
-// Display state variables
-unsigned long lastDisplayUpdate = 0;
-unsigned long lastTempHumidityToggle = 0;
-unsigned long lastDotToggle = 0;
-bool showTemperature = true;
-bool dotState = false;
-uint8_t currentDisplayMode = 0; // 0: time, 1: date, 2: temp/humidity, 3: alarm, 4: timer
-
-// Settings variables
-uint8_t currentSetting = 0;    // 0: time, 1: date, 2: alarm, 3: timer
-uint8_t settingBlinkState = 0; // 0: off, 1: on
-unsigned long lastBlinkTime = 0;
-uint8_t BLINK_INTERVAL = 50; // 50ms
-
-// Add this variable with the other global variables
-unsigned long lastSettingsExitTime = 0;
-uint16_t SETTINGS_EXIT_COOLDOWN = 2000; // 2 seconds
+// Button pins in UI order; they also wake the MCU from power-down
+const uint8_t BUTTON_PINS[UI_BUTTONS] = {BUTTON_1_PIN, BUTTON_2_PIN, BUTTON_3_PIN, BUTTON_4_PIN};
 
 // Function declarations
-void enterSettingsMode();
-void exitSettingsMode();
-void handleDisplayMode();
-void handleSettingsMode();
+void updatePower();
+
+// Event subscriptions
+static void checkAlarms(const SecondTick &tick)
+{
+  clock.onSecondTick(tick);
+}
+
+static void refreshDisplay(const SecondTick &)
+{
+  ui.dispatch(UI_SECOND);
+}
+
+static void chimeTimer(const TimerCompleted &)
+{
+  clock.previewMelody(MELODY_CHIME); // Not over a ringing alarm
+}
+
+static void pressButton(const ButtonEvent &event)
+{
+  ui.handleButton(event);
+}
+
+template <typename E>
+static void wakeUp(const E &)
+{
+  power.notifyActivity();
+}
+
+template <typename E>
+static void logEvent(const E &event)
+{
+  activityLog.record(event);
+}
+
+static void keepSample(const SensorSample &sample)
+{
+  climateLog.onSample(sample);
+}
+
+static void logClimate(const MinuteTick &tick)
+{
+  climateLog.onMinute(tick);
+}
+
+EVENT_SUBSCRIBERS(SecondTick, checkAlarms, refreshDisplay);
+EVENT_SUBSCRIBERS(MinuteTick, logClimate);
+EVENT_SUBSCRIBERS(SensorSample, keepSample);
+EVENT_SUBSCRIBERS(TimerCompleted, chimeTimer, logEvent<TimerCompleted>);
+EVENT_SUBSCRIBERS(AlarmFired, wakeUp<AlarmFired>, logEvent<AlarmFired>);
+EVENT_SUBSCRIBERS(AlarmDismissed, logEvent<AlarmDismissed>);
+EVENT_SUBSCRIBERS(SettingsChanged, logEvent<SettingsChanged>);
+EVENT_SUBSCRIBERS(SensorFault, logEvent<SensorFault>);
+EVENT_SUBSCRIBERS(MemoryLow, logEvent<MemoryLow>);
+EVENT_SUBSCRIBERS(ButtonEvent, wakeUp<ButtonEvent>, pressButton);
 
 void setup()
 {
   Serial.begin(115200);
 
+  // Reset the board if the loop stops; note where it stopped last time
+  Watchdog::begin(Watchdog::readResetFlags());
+
   // Initialize components with BCD multiplexed display
   display.begin(BCD_1_PIN, BCD_2_PIN, BCD_3_PIN, BCD_4_PIN, SHIFT_PIN, CLOCK_PIN);
 
   // Initialize RTC
-  rtc.begin(RTC_SDA_PIN, RTC_SCL_PIN);
+  rtc.begin(RTC_SDA_PIN, RTC_SCL_PIN, RTC_SQW_PIN);
+  RECORD_START(rtc.getUnixTime());
 
   // Initialize buzzer
   buzzer.begin();
 
   // Initialize DHT11
-  dht11.begin();
+  dht11.begin(&scheduler);
 
   // Initialize buttons
   button1.begin();
@@ -100,215 +153,84 @@ void setup()
   button4.begin();
 
   // Initialize clock
-  clock.begin(&rtc, &dht11, &buzzer);
+  clock.begin(&rtc, &dht11, &buzzer, &scheduler);
+
+  // Initialize serial command handler and host time sync
+  timeSync.begin(&clock, &scheduler);
+  serialHandler.begin(&clock, &scheduler, &power, &timeSync, &activityLog, &climateLog);
 
-  // Initialize serial command handler
-  serialHandler.begin(&clock);
+  // Initialize sleep control
+  power.begin(&rtc, BUTTON_PINS, sizeof(BUTTON_PINS));
 
   // Load settings from EEPROM
   clock.loadSettings();
+
+  // Find the end of the activity log and record the power-up and its cause
+  activityLog.begin(&clock, Watchdog::getResetReport());
+
+  // Go on with the climate log where it stopped
+  climateLog.begin();
+
+  // Warn when the stack comes close to the heap; the RAM was painted
+  // before setup()
+  MemoryMonitor::begin(&scheduler);
+
+  // Display and settings modes, driven by button and timing events
+  ui.begin(&display, &clock, &scheduler, BUTTON_PINS);
 }
 
 void loop()
 {
+  Watchdog::feed();
+  PROFILE_BEGIN_LOOP();
+
   // Handle serial commands
+  Watchdog::enter(STAGE_SERIAL);
   serialHandler.update();
+  PROFILE_MARK(STAGE_SERIAL);
+
+  // Run due tasks
+  Watchdog::enter(STAGE_TASKS);
+  scheduler.run();
+  PROFILE_MARK(STAGE_TASKS);
 
-  // Update button states
+  // Update button states; their events drive the UI
+  Watchdog::enter(STAGE_BUTTONS);
   button1.update();
   button2.update();
   button3.update();
   button4.update();
-
-  // Toggle settings mode on long press of button 1
-  if (button1.isLongPressed())
-  {
-    button1.reset();
-    if (isSettingsMode)
-    {
-      exitSettingsMode();
-    }
-    else
-    {
-      enterSettingsMode();
-    }
-  }
-
-  // Handle mode-specific logic
-  if (isSettingsMode)
-  {
-    handleSettingsMode();
-  }
-  else
-  {
-    handleDisplayMode();
-  }
+  PROFILE_MARK(STAGE_BUTTONS);
 
   // Update clock
+  Watchdog::enter(STAGE_CLOCK);
   clock.update();
+  PROFILE_MARK(STAGE_CLOCK);
 
-  // Handle dot blinking
-  if (millis() - lastDotToggle > 500)
-  {
-    lastDotToggle = millis();
-    dotState = !dotState;
-
-    // Set dot bit based on state and current mode
-    if (currentDisplayMode == 0 && dotState)
-    {
-      display.setDotState(true);
-    }
-    else
-    {
-      display.setDotState(false);
-    }
-  }
-
-  // Continuous display refresh for BCD multiplexed display
+  // Display refresh runs from its own interrupt
+  Watchdog::enter(STAGE_LOOP);
   display.update();
-}
-
-void enterSettingsMode()
-{
-  isSettingsMode = true;
-  settingsModeStartTime = millis();
-  currentSetting = 0;
-  settingBlinkState = 0;
-  lastBlinkTime = millis();
-}
+  PROFILE_END_LOOP();
 
-void exitSettingsMode()
-{
-  isSettingsMode = false;
-  lastSettingsExitTime = millis(); // Set the exit time
-  clock.saveSettings();
+  // Sleep until the next interrupt
+  updatePower();
 }
 
-void handleDisplayMode()
+void updatePower()
 {
-  if (button1.isPressed()) // Date
-  {
-    currentDisplayMode = 1;
-  }
-  else if (button2.isPressed()) // Temperature/Humidity
-  {
-    currentDisplayMode = 2;
-  }
-  else if (button3.isPressed()) // Alarm
-  {
-    currentDisplayMode = 3;
-  }
-  else if (button4.isPressed()) // Timer
-  {
-    currentDisplayMode = 4;
-  }
-  else
-  {
-    currentDisplayMode = 0;
-  }
+  // At night the display goes dark unless something needs attention
+  bool dark = power.isNight(clock.getTime()) && !power.isAwake() &&
+              !ui.isInSettings() && clock.getAlarmState() == ALARM_ARMED;
+  display.setEnabled(!dark);
 
-  switch (currentDisplayMode)
-  {
-  case 0: // Time
-  {
-    display.print(clock.getTimeString());
-  }
-  break;
-  case 1: // Date
-  {
-    display.print(clock.getDateString());
-  }
-  break;
-  case 2: // Temperature/Humidity
-    if (millis() - lastTempHumidityToggle > 3000)
-    {
-      showTemperature = !showTemperature;
-      lastTempHumidityToggle = millis();
-    }
-    if (showTemperature)
-    {
-      display.print(clock.getTemperatureString());
-    }
-    else
-    {
-      display.print(clock.getHumidityString());
-    }
-    break;
-  case 3: // Alarm
-  {
-    display.print(clock.getAlarmTimeString());
-  }
-  break;
-  case 4: // Timer
+  // Don't sleep past work that is already waiting
+  if (Serial.available() || scheduler.getTimeUntilNextTask() == 0)
   {
-    display.print(clock.getTimerString());
-  }
-  break;
+    return;
   }
 
-  lastDisplayUpdate = millis();
+  // Power-down stops millis(), so only when nothing is being timed, and
+  // only with the square wave to wake it every second
+  bool powerDown = dark && rtc.hasSquareWave() && !clock.isTimerRunning() && !buzzer.isBusy();
+  power.sleep(powerDown);
 }
-
-void handleSettingsMode()
-{
-  if (button1.wasSinglePressed())
-  {
-    currentSetting = (currentSetting + 1) % 4;
-    settingBlinkState = 0;
-    lastBlinkTime = millis();
-  }
-
-  if (button2.wasSinglePressed())
-  {
-    clock.adjustSetting(currentSetting, 0); // Adjust first part of setting
-  }
-
-  if (button3.wasSinglePressed())
-  {
-    clock.adjustSetting(currentSetting, 1); // Adjust second part of setting
-  }
-
-  if (button4.wasSinglePressed())
-  {
-    clock.adjustSetting(currentSetting, 2); // Adjust third part of setting
-  }
-
-  // Blink the current setting
-  if (millis() - lastBlinkTime > BLINK_INTERVAL)
-  {
-    settingBlinkState = !settingBlinkState;
-    lastBlinkTime = millis();
-  }
-
-  // Display current setting
-  if (settingBlinkState)
-  {
-    switch (currentSetting)
-    {
-    case 0: // Time
-    {
-      display.print(clock.getTimeString());
-    }
-    break;
-    case 1: // Date
-    {
-      display.print(clock.getDateString());
-    }
-    break;
-    case 2: // Alarm
-    {
-      display.print(clock.getAlarmTimeString());
-    }
-    break;
-    case 3: // Timer
-    {
-      display.print(clock.getTimerString());
-    }
-    break;
-    }
-  }
-  else
-  {
-    display.clear();
-  }
-}
\ No newline at end of file
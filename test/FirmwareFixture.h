@@ -0,0 +1,189 @@
+#ifndef FIRMWARE_FIXTURE_H
+#define FIRMWARE_FIXTURE_H
+
+// The firmware as main.cpp wires it, for the suites that drive it whole.
+// Include it from one file per suite: it defines the event subscriptions.
+
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "Clock.h"
+#include "Display.h"
+#include "Buzzer.h"
+#include "SerialCommandHandler.h"
+#include "TimeSync.h"
+#include "ActivityLog.h"
+#include "ClimateLog.h"
+#include "UserInterface.h"
+#include "Watchdog.h"
+#include "EventBus.h"
+
+// Same wiring as main.cpp
+#define BUZZER_PIN 9
+#define SQW_PIN 2
+#define SHIFT_PIN 8
+#define CLOCK_PIN 7
+static const uint8_t BUTTON_PINS[UI_BUTTONS] = {A1, A2, A3, 12};
+
+// Parts besides the clock and the serial port, for the suites that need them
+enum FirmwarePart
+{
+  PART_TIME_SYNC = 0x01,
+  PART_ACTIVITY_LOG = 0x02,
+  PART_CLIMATE_LOG = 0x04,
+  PART_UI = 0x08, // With the display
+};
+
+// Rebuilt for every test; a second one over the same EEPROM is a restart
+struct Firmware
+{
+  uint8_t parts;
+  Scheduler scheduler;
+  Display display;
+  RTClock rtc;
+  Buzzer buzzer;
+  HTSensor dht11;
+  Clock clock;
+  TimeSync timeSync;
+  SerialCommandHandler serial;
+  ActivityLog log;
+  ClimateLog climate;
+  UserInterface ui;
+  uint8_t timerCompletions;
+
+  explicit Firmware(uint8_t parts = 0);
+  ~Firmware();
+
+  bool has(uint8_t part) const
+  {
+    return parts & part;
+  }
+
+  // One loop() pass per step; 1 ms is how often an idle clock wakes
+  void run(uint32_t ms, uint32_t step = 1)
+  {
+    for (uint32_t i = 0; i < ms; i += step)
+    {
+      serial.update();
+      scheduler.run();
+      clock.update();
+      halAdvanceMillis(step);
+    }
+  }
+
+  // A line typed into the serial port; the output is the reply alone
+  void command(const char *line)
+  {
+    halSerialClear();
+    halSerialInput(line);
+    halSerialInput("\n");
+    run(1);
+  }
+};
+
+// Subscribers reach the parts through whichever Firmware is current. Parts
+// a test builds on their own, an RTClock say, publish with none.
+static Firmware *firmware = nullptr;
+
+static void checkAlarms(const SecondTick &tick)
+{
+  if (firmware)
+  {
+    firmware->clock.onSecondTick(tick);
+  }
+}
+
+static void refreshDisplay(const SecondTick &)
+{
+  if (firmware && firmware->has(PART_UI))
+  {
+    firmware->ui.dispatch(UI_SECOND);
+  }
+}
+
+static void chimeTimer(const TimerCompleted &)
+{
+  if (firmware)
+  {
+    firmware->timerCompletions++;
+    firmware->clock.previewMelody(MELODY_CHIME);
+  }
+}
+
+template <typename E>
+static void logEvent(const E &event)
+{
+  if (firmware && firmware->has(PART_ACTIVITY_LOG))
+  {
+    firmware->log.record(event);
+  }
+}
+
+static void keepSample(const SensorSample &sample)
+{
+  if (firmware && firmware->has(PART_CLIMATE_LOG))
+  {
+    firmware->climate.onSample(sample);
+  }
+}
+
+static void logClimate(const MinuteTick &tick)
+{
+  if (firmware && firmware->has(PART_CLIMATE_LOG))
+  {
+    firmware->climate.onMinute(tick);
+  }
+}
+
+EVENT_SUBSCRIBERS(SecondTick, checkAlarms, refreshDisplay);
+EVENT_SUBSCRIBERS(MinuteTick, logClimate);
+EVENT_SUBSCRIBERS(SensorSample, keepSample);
+EVENT_SUBSCRIBERS(TimerCompleted, chimeTimer, logEvent<TimerCompleted>);
+EVENT_SUBSCRIBERS(AlarmFired, logEvent<AlarmFired>);
+EVENT_SUBSCRIBERS(AlarmDismissed, logEvent<AlarmDismissed>);
+EVENT_SUBSCRIBERS(SettingsChanged, logEvent<SettingsChanged>);
+EVENT_SUBSCRIBERS(SensorFault, logEvent<SensorFault>);
+EVENT_SUBSCRIBERS(MemoryLow, logEvent<MemoryLow>);
+
+// In setup()'s order. The activity log takes the reset report the last
+// Watchdog::begin() left.
+Firmware::Firmware(uint8_t parts) : parts(parts), buzzer(BUZZER_PIN), dht11(A0), timerCompletions(0)
+{
+  firmware = this;
+  if (has(PART_UI))
+  {
+    display.begin(3, 4, 5, 6, SHIFT_PIN, CLOCK_PIN);
+  }
+  rtc.begin(A4, A5, SQW_PIN);
+  buzzer.begin();
+  dht11.begin(&scheduler);
+  clock.begin(&rtc, &dht11, &buzzer, &scheduler);
+  if (has(PART_TIME_SYNC))
+  {
+    timeSync.begin(&clock, &scheduler);
+  }
+  serial.begin(&clock, &scheduler, nullptr, has(PART_TIME_SYNC) ? &timeSync : nullptr,
+               has(PART_ACTIVITY_LOG) ? &log : nullptr, has(PART_CLIMATE_LOG) ? &climate : nullptr);
+  clock.loadSettings();
+  if (has(PART_ACTIVITY_LOG))
+  {
+    log.begin(&clock, Watchdog::getResetReport());
+  }
+  if (has(PART_CLIMATE_LOG))
+  {
+    climate.begin();
+  }
+  if (has(PART_UI))
+  {
+    ui.begin(&display, &clock, &scheduler, BUTTON_PINS);
+  }
+}
+
+Firmware::~Firmware()
+{
+  if (firmware == this)
+  {
+    firmware = nullptr;
+  }
+}
+
+#endif // FIRMWARE_FIXTURE_H
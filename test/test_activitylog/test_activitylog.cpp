@@ -0,0 +1,205 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "EEPROMStorage.h"
+#include "../FirmwareFixture.h"
+
+static const uint32_t MONDAY_0659 = 1704178740UL; // 2024-01-02 06:59:00
+
+// The firmware with its activity log
+struct LogFirmware : Firmware
+{
+  LogFirmware() : Firmware(PART_ACTIVITY_LOG)
+  {
+  }
+
+  // Time passes without loop passes, then the RTC is read
+  void skip(uint32_t seconds)
+  {
+    halAdvanceMillis(seconds * 1000);
+    clock.update();
+  }
+};
+
+// The whole log, oldest first
+static uint8_t readAll(const ActivityLog &log, LogEntry *entries, uint8_t size)
+{
+  LogCursor cursor;
+  LogEntry entry;
+  uint8_t count = 0;
+  log.rewind(cursor);
+  while (log.next(cursor, entry))
+  {
+    if (count < size)
+    {
+      entries[count] = entry;
+    }
+    count++;
+  }
+  return count;
+}
+
+void setUp()
+{
+  halReset();
+  halSetRtc(MONDAY_0659);
+}
+
+void tearDown()
+{
+}
+
+void test_records_what_happened_and_when()
+{
+  LogFirmware fw;
+  fw.command("alarm 1 set 0700");
+  fw.command("alarm 1 on");
+  fw.run(61000);
+  TEST_ASSERT_EQUAL(ALARM_RINGING, fw.clock.getAlarmState());
+  fw.run(5000);
+  fw.clock.dismissAlarm();
+
+  LogEntry entries[8];
+  TEST_ASSERT_EQUAL_UINT8(5, readAll(fw.log, entries, 8));
+  TEST_ASSERT_EQUAL_UINT8(LOG_POWER_UP, entries[0].type);
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659, entries[0].time);
+  TEST_ASSERT_EQUAL_UINT8(LOG_SETTINGS, entries[1].type);
+  TEST_ASSERT_EQUAL_UINT8(SETTINGS_ALARMS, entries[1].data);
+  TEST_ASSERT_EQUAL_UINT8(LOG_SETTINGS, entries[2].type);
+  TEST_ASSERT_EQUAL_UINT8(LOG_ALARM_FIRED, entries[3].type);
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659 + 60, entries[3].time);
+  TEST_ASSERT_EQUAL_UINT8(0, entries[3].data);
+  TEST_ASSERT_EQUAL_UINT8(LOG_ALARM_DISMISSED, entries[4].type);
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659 + 66, entries[4].time);
+
+  fw.command("log");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "=== Log: 6 records, 0 dropped since power-on ==="));
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "02.01.2024 06:59:00 power up"));
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "02.01.2024 07:00:00 alarm fired 1, round 0"));
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "02.01.2024 07:00:06 alarm dismissed 1, round 0"));
+}
+
+void test_ring_wraps_and_is_found_after_restart()
+{
+  {
+    LogFirmware fw;
+    for (uint16_t i = 0; i < 150; i++)
+    {
+      fw.skip(61);
+      fw.clock.setTimerTime(0, i % 60, 0);
+    }
+    TEST_ASSERT_EQUAL_UINT8(LOG_RECORDS, fw.log.getCount());
+  }
+
+  // A restart finds the head from the lap bits alone
+  LogFirmware fw;
+  EpochTime powerUp = fw.clock.getUnixTime();
+  LogEntry entries[LOG_RECORDS];
+  uint8_t count = readAll(fw.log, entries, LOG_RECORDS);
+  TEST_ASSERT_TRUE(count > LOG_RECORDS - LOG_RECORDS / LOG_ANCHOR_EVERY - 2);
+  TEST_ASSERT_EQUAL_UINT8(LOG_POWER_UP, entries[count - 1].type);
+  TEST_ASSERT_EQUAL_UINT32(powerUp, entries[count - 1].time);
+
+  // Oldest first, in order; only what came before the first anchor left in
+  // the ring has no time
+  uint8_t known = 0;
+  while (entries[known].time == 0)
+  {
+    known++;
+  }
+  TEST_ASSERT_TRUE(known < LOG_ANCHOR_EVERY);
+  for (uint8_t i = known; i < count - 1; i++)
+  {
+    TEST_ASSERT_EQUAL_UINT8(LOG_SETTINGS, entries[i].type);
+    TEST_ASSERT_EQUAL_UINT8(SETTINGS_TIMER, entries[i].data);
+    TEST_ASSERT_EQUAL_UINT32(powerUp - 61 * (count - 2 - i), entries[i].time);
+  }
+}
+
+void test_rate_limited_with_a_count_of_dropped()
+{
+  LogFirmware fw;
+  for (uint8_t i = 0; i < 20; i++)
+  {
+    fw.clock.setTimerTime(0, 5, 0);
+  }
+  LogEntry entries[16];
+  // The power-up took one of the burst
+  TEST_ASSERT_EQUAL_UINT8(LOG_BURST, readAll(fw.log, entries, 16));
+  TEST_ASSERT_EQUAL_UINT16(20 - (LOG_BURST - 1), fw.log.getDropped());
+
+  fw.skip(LOG_REFILL);
+  fw.clock.setTimerTime(0, 6, 0);
+  TEST_ASSERT_EQUAL_UINT8(LOG_BURST + 2, readAll(fw.log, entries, 16));
+  TEST_ASSERT_EQUAL_UINT8(LOG_DROPPED, entries[LOG_BURST].type);
+  TEST_ASSERT_EQUAL_UINT8(20 - (LOG_BURST - 1), entries[LOG_BURST].data);
+  TEST_ASSERT_EQUAL_UINT8(LOG_SETTINGS, entries[LOG_BURST + 1].type);
+}
+
+void test_clock_set_back_and_long_gaps()
+{
+  LogFirmware fw;
+  fw.skip(5);
+  fw.clock.setUnixTime(MONDAY_0659 - 3600);
+  fw.skip(2 * 86400UL); // More than a delta holds
+  fw.clock.setTimerTime(0, 1, 0);
+
+  LogEntry entries[4];
+  TEST_ASSERT_EQUAL_UINT8(3, readAll(fw.log, entries, 4));
+  TEST_ASSERT_EQUAL_UINT8(SETTINGS_CLOCK, entries[1].data);
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659 - 3600, entries[1].time);
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659 - 3600 + 2 * 86400UL, entries[2].time);
+}
+
+void test_sensor_fault_once_until_it_recovers()
+{
+  LogFirmware fw;
+  halSetDht(NAN, NAN);
+  fw.run(10000);
+  halSetDht(22, 40);
+  fw.run(4000);
+  halSetDht(120, 40);
+  fw.run(10000);
+
+  LogEntry entries[4];
+  TEST_ASSERT_EQUAL_UINT8(3, readAll(fw.log, entries, 4));
+  TEST_ASSERT_EQUAL_UINT8(LOG_SENSOR_FAULT, entries[1].type);
+  TEST_ASSERT_EQUAL_UINT8(SENSOR_NO_REPLY, entries[1].data);
+  TEST_ASSERT_EQUAL_UINT8(SENSOR_OUT_OF_RANGE, entries[2].data);
+}
+
+void test_wear_and_empty_states()
+{
+  // Erased: power-up and its anchor, 4 cells each
+  uint32_t writes = halEepromWrites();
+  LogFirmware fw;
+  TEST_ASSERT_EQUAL_UINT8(2, fw.log.getCount());
+  TEST_ASSERT_TRUE(halEepromWrites() - writes <= 8);
+
+  writes = halEepromWrites();
+  fw.clock.setTimerTime(0, 1, 0);
+  TEST_ASSERT_TRUE(halEepromWrites() - writes <= 4);
+
+  fw.command("log clear");
+  TEST_ASSERT_EQUAL_UINT8(0, fw.log.getCount());
+
+  // Zeroed by clearSettings(): empty as well
+  EEPROMStorage eeprom;
+  eeprom.clearSettings();
+  LogFirmware again;
+  TEST_ASSERT_EQUAL_UINT8(2, again.log.getCount());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_records_what_happened_and_when);
+  RUN_TEST(test_ring_wraps_and_is_found_after_restart);
+  RUN_TEST(test_rate_limited_with_a_count_of_dropped);
+  RUN_TEST(test_clock_set_back_and_long_gaps);
+  RUN_TEST(test_sensor_fault_once_until_it_recovers);
+  RUN_TEST(test_wear_and_empty_states);
+  return UNITY_END();
+}
@@ -0,0 +1,148 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "Alarm.h"
+
+static const EpochTime TUESDAY_0700 = 1704178800UL; // 2024-01-02 07:00:00
+static const EpochTime DAY = Epoch::SECONDS_PER_DAY;
+static const AlarmData AT_0700 = {7, 0, true, ALARM_EVERY_DAY};
+
+// One update per second over [from, to], like the SecondTick; returns the
+// number of times an alarm fired
+static uint8_t runSeconds(AlarmScheduler &scheduler, EpochTime from, EpochTime to)
+{
+  uint8_t fires = 0;
+  for (EpochTime now = from; now <= to; now++)
+  {
+    if (scheduler.update(now) >= 0)
+    {
+      fires++;
+    }
+  }
+  return fires;
+}
+
+void setUp()
+{
+  halReset();
+}
+
+void tearDown()
+{
+}
+
+void test_stall_across_instant_fires_once()
+{
+  AlarmScheduler scheduler;
+  scheduler.setAlarm(0, AT_0700);
+  TEST_ASSERT_EQUAL_INT8(-1, scheduler.update(TUESDAY_0700 - 2));
+
+  // The loop comes back 5 s past the instant: late, but it fires
+  TEST_ASSERT_EQUAL_INT8(0, scheduler.update(TUESDAY_0700 + 5));
+  TEST_ASSERT_EQUAL_UINT8(0, runSeconds(scheduler, TUESDAY_0700 + 6, TUESDAY_0700 + 120));
+  TEST_ASSERT_EQUAL_UINT32(TUESDAY_0700, scheduler.getFiredFor(0));
+  TEST_ASSERT_EQUAL_UINT32(TUESDAY_0700 + DAY, scheduler.getNextFireTime());
+}
+
+void test_dismiss_inside_window_does_not_refire()
+{
+  Alarm alarm;
+  alarm.begin();
+  alarm.setData(0, AT_0700);
+  alarm.update(TUESDAY_0700 - 1);
+  alarm.update(TUESDAY_0700);
+  TEST_ASSERT_EQUAL(ALARM_RINGING, alarm.getState());
+
+  alarm.dismiss();
+  for (EpochTime now = TUESDAY_0700 + 1; now <= TUESDAY_0700 + 120; now++)
+  {
+    alarm.update(now);
+  }
+  TEST_ASSERT_EQUAL(ALARM_ARMED, alarm.getState());
+
+  // Nor after a restart still inside the catch-up window
+  uint32_t records[MAX_ALARMS];
+  for (uint8_t i = 0; i < MAX_ALARMS; i++)
+  {
+    records[i] = alarm.getFiredFor(i);
+  }
+  Alarm restarted;
+  restarted.begin();
+  restarted.setData(0, AT_0700);
+  restarted.restoreFiredFor(records);
+  restarted.update(TUESDAY_0700 + 300);
+  TEST_ASSERT_EQUAL(ALARM_ARMED, restarted.getState());
+}
+
+void test_clock_set_back_does_not_refire()
+{
+  AlarmScheduler scheduler;
+  scheduler.setAlarm(0, AT_0700);
+  TEST_ASSERT_EQUAL_UINT8(1, runSeconds(scheduler, TUESDAY_0700 - 10, TUESDAY_0700 + 10));
+
+  // Back ten minutes: 07:00 comes round again, but has already rung
+  scheduler.clockAdjusted();
+  TEST_ASSERT_EQUAL_UINT8(0, runSeconds(scheduler, TUESDAY_0700 - 600, TUESDAY_0700 + 60));
+  TEST_ASSERT_EQUAL_UINT32(TUESDAY_0700 + DAY, scheduler.getNextFireTime());
+}
+
+void test_clock_set_forward_consumes_instant()
+{
+  AlarmScheduler scheduler;
+  scheduler.setAlarm(0, AT_0700);
+  scheduler.update(TUESDAY_0700 - 600);
+  scheduler.takeRecordsChanged();
+
+  // Forward over 07:00: skipped, not rung late
+  scheduler.clockAdjusted();
+  TEST_ASSERT_EQUAL_UINT8(0, runSeconds(scheduler, TUESDAY_0700 + 600, TUESDAY_0700 + 660));
+  TEST_ASSERT_EQUAL_UINT32(TUESDAY_0700 + 600, scheduler.getFiredFor(0));
+  TEST_ASSERT_TRUE(scheduler.takeRecordsChanged());
+  TEST_ASSERT_EQUAL_UINT32(TUESDAY_0700 + DAY, scheduler.getNextFireTime());
+}
+
+void test_power_cycle_catches_up_within_window()
+{
+  // Last rang yesterday; off over this morning's 07:00
+  EpochTime records[MAX_ALARMS] = {TUESDAY_0700 - DAY, 0, 0, 0};
+
+  AlarmScheduler recent;
+  recent.setAlarm(0, AT_0700);
+  recent.restoreFiredFor(records);
+  TEST_ASSERT_EQUAL_INT8(0, recent.update(TUESDAY_0700 + AlarmScheduler::CATCH_UP_WINDOW - 60));
+  TEST_ASSERT_EQUAL_UINT32(TUESDAY_0700, recent.getFiredFor(0));
+
+  // Back on after more than the window: dropped
+  AlarmScheduler late;
+  late.setAlarm(0, AT_0700);
+  late.restoreFiredFor(records);
+  TEST_ASSERT_EQUAL_UINT8(0, runSeconds(late, TUESDAY_0700 + AlarmScheduler::CATCH_UP_WINDOW + 60,
+                                        TUESDAY_0700 + AlarmScheduler::CATCH_UP_WINDOW + 120));
+  TEST_ASSERT_EQUAL_UINT32(TUESDAY_0700 + DAY, late.getNextFireTime());
+}
+
+void test_shared_instant_fires_once()
+{
+  AlarmScheduler scheduler;
+  scheduler.setAlarm(0, AT_0700);
+  scheduler.setAlarm(2, AT_0700);
+  scheduler.update(TUESDAY_0700 - 1);
+
+  TEST_ASSERT_EQUAL_INT8(0, scheduler.update(TUESDAY_0700));
+  TEST_ASSERT_EQUAL_UINT8(0, runSeconds(scheduler, TUESDAY_0700 + 1, TUESDAY_0700 + 120));
+  TEST_ASSERT_EQUAL_UINT32(TUESDAY_0700, scheduler.getFiredFor(0));
+  TEST_ASSERT_EQUAL_UINT32(TUESDAY_0700, scheduler.getFiredFor(2));
+  TEST_ASSERT_EQUAL_UINT32(TUESDAY_0700 + DAY, scheduler.getNextFireTime());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_stall_across_instant_fires_once);
+  RUN_TEST(test_dismiss_inside_window_does_not_refire);
+  RUN_TEST(test_clock_set_back_does_not_refire);
+  RUN_TEST(test_clock_set_forward_consumes_instant);
+  RUN_TEST(test_power_cycle_catches_up_within_window);
+  RUN_TEST(test_shared_instant_fires_once);
+  return UNITY_END();
+}
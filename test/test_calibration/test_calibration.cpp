@@ -0,0 +1,179 @@
+#include <unity.h>
+#include <string.h>
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "EEPROMStorage.h"
+#include "Timebase.h"
+#include "../FirmwareFixture.h"
+
+// A resonator well inside the ceramic part's tolerance
+static const int32_t RESONATOR_PPM = 3000;
+
+void setUp()
+{
+  halReset();
+  Timebase::setCorrection(0);
+}
+
+void tearDown()
+{
+}
+
+void test_timebase_keeps_true_time()
+{
+  Timebase::setCorrection(RESONATOR_PPM);
+  uint32_t start = Timebase::millis();
+
+  // 1000 true seconds are 1003 s of a fast millis(), read in uneven steps
+  for (uint32_t raw = 0; raw < 1003000UL; raw += 7)
+  {
+    halAdvanceMillis(1003000UL - raw < 7 ? 1003000UL - raw : 7);
+    Timebase::millis();
+  }
+  int32_t counted = (int32_t)(Timebase::millis() - start);
+  TEST_ASSERT_TRUE(counted >= 999999 && counted <= 1000001);
+
+  // A new correction applies from now on, without a jump
+  uint32_t before = Timebase::millis();
+  Timebase::setCorrection(-RESONATOR_PPM);
+  TEST_ASSERT_EQUAL_UINT32(before, Timebase::millis());
+  halAdvanceMillis(997000UL);
+  counted = (int32_t)(Timebase::millis() - before);
+  TEST_ASSERT_TRUE(counted >= 999998 && counted <= 1000002);
+
+  // Durations for hardware timers
+  Timebase::setCorrection(RESONATOR_PPM);
+  TEST_ASSERT_EQUAL_UINT32(60180, Timebase::toRaw(60000));
+  uint32_t back = Timebase::fromRaw(60180);
+  TEST_ASSERT_TRUE(back >= 59999 && back <= 60001);
+
+  Timebase::setCorrection(30000);
+  TEST_ASSERT_EQUAL_INT(Timebase::MAX_PPM, Timebase::getCorrection());
+}
+
+void test_estimate_from_edges()
+{
+  Calibration calibration;
+  EpochTime second = 1717243200UL;
+  uint32_t edge = 4000000000UL; // Wraps during the window
+
+  // Edges seen up to 30 us late, as behind another interrupt
+  for (uint16_t i = 0; i <= CALIBRATION_WINDOW; i++)
+  {
+    calibration.update(second + i, edge + (i % 7) * 5);
+    edge += 1000000 - 1500;
+  }
+  TEST_ASSERT_TRUE(calibration.hasEstimate());
+  TEST_ASSERT_EQUAL_INT(-1500, calibration.getEstimate());
+  TEST_ASSERT_EQUAL_INT(-1500, Timebase::getCorrection());
+  TEST_ASSERT_TRUE(calibration.takeEstimateChanged());
+  TEST_ASSERT_FALSE(calibration.takeEstimateChanged());
+
+  // The next window moves it a quarter of the way; too little to save
+  second += CALIBRATION_WINDOW;
+  for (uint16_t i = 1; i <= CALIBRATION_WINDOW; i++)
+  {
+    calibration.update(second + i, edge);
+    edge += 1000000 - 1460;
+  }
+  TEST_ASSERT_EQUAL_INT(-1490, calibration.getEstimate());
+  TEST_ASSERT_EQUAL_INT(-1500, calibration.getSaved());
+  TEST_ASSERT_FALSE(calibration.takeEstimateChanged());
+  TEST_ASSERT_EQUAL_UINT8(2, calibration.getWindowCount());
+}
+
+void test_broken_windows_are_dropped()
+{
+  Calibration calibration;
+  EpochTime second = 1717243200UL;
+  uint32_t edge = 0;
+  for (uint16_t i = 0; i < 600; i++)
+  {
+    calibration.update(second++, edge);
+    edge += 1000000;
+  }
+  TEST_ASSERT_EQUAL_UINT16(599, calibration.getWindowSeconds());
+
+  // Power-down: the seconds go on while micros() stands still
+  second += 30;
+  calibration.update(second, edge);
+  TEST_ASSERT_EQUAL_UINT16(0, calibration.getWindowSeconds());
+
+  // An interval far off a second: the RTC was written
+  calibration.update(++second, edge + 400000);
+  TEST_ASSERT_EQUAL_UINT16(0, calibration.getWindowSeconds());
+
+  calibration.update(++second, edge + 1400000);
+  TEST_ASSERT_EQUAL_UINT16(1, calibration.getWindowSeconds());
+  calibration.restart();
+  TEST_ASSERT_EQUAL_UINT16(0, calibration.getWindowSeconds());
+  TEST_ASSERT_FALSE(calibration.hasEstimate());
+}
+
+void test_measured_on_the_board_and_persisted()
+{
+  halSetClockError(RESONATOR_PPM);
+  {
+    Firmware fw;
+    fw.run((CALIBRATION_WINDOW + 5) * 1000UL, 10);
+    TEST_ASSERT_TRUE(fw.clock.getCalibration().hasEstimate());
+    TEST_ASSERT_EQUAL_INT(RESONATOR_PPM, fw.clock.getCalibration().getEstimate());
+    TEST_ASSERT_EQUAL_INT(RESONATOR_PPM, Timebase::getCorrection());
+
+    fw.command("cal");
+    TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Calibration: +3000 ppm"));
+    TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Uncorrected: +259.2 s a day"));
+  }
+
+  EEPROMStorage eeprom;
+  int16_t ppm;
+  TEST_ASSERT_TRUE(eeprom.loadCalibration(ppm));
+  TEST_ASSERT_EQUAL_INT(RESONATOR_PPM, ppm);
+
+  // Applied again after a restart, before any new window
+  Timebase::setCorrection(0);
+  Firmware fw;
+  TEST_ASSERT_EQUAL_INT(RESONATOR_PPM, Timebase::getCorrection());
+
+  fw.command("cal reset");
+  TEST_ASSERT_FALSE(fw.clock.getCalibration().hasEstimate());
+  TEST_ASSERT_EQUAL_INT(0, Timebase::getCorrection());
+  TEST_ASSERT_FALSE(eeprom.loadCalibration(ppm));
+  fw.command("cal");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Calibration: none yet"));
+}
+
+void test_timer_counts_rtc_seconds()
+{
+  halSetClockError(RESONATOR_PPM);
+  EEPROMStorage eeprom;
+  eeprom.saveCalibration(RESONATOR_PPM);
+  Firmware fw;
+  fw.run(1500);
+
+  // Ten minutes would end 1.8 s early on the raw millis()
+  fw.clock.setTimerTime(0, 10, 0);
+  uint64_t start = micros();
+  fw.clock.startTimer();
+  uint32_t ms = 0;
+  while (fw.timerCompletions == 0 && ms < 700000UL)
+  {
+    fw.run(1);
+    ms++;
+  }
+  TEST_ASSERT_EQUAL_UINT8(1, fw.timerCompletions);
+  uint32_t elapsed = (uint32_t)(micros() - start);
+  uint64_t trueUs = (uint64_t)elapsed * 1000000ULL / (1000000ULL + RESONATOR_PPM);
+  TEST_ASSERT_TRUE(trueUs >= 599998000ULL && trueUs <= 600003000ULL);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_timebase_keeps_true_time);
+  RUN_TEST(test_estimate_from_edges);
+  RUN_TEST(test_broken_windows_are_dropped);
+  RUN_TEST(test_measured_on_the_board_and_persisted);
+  RUN_TEST(test_timer_counts_rtc_seconds);
+  return UNITY_END();
+}
@@ -0,0 +1,305 @@
+#include <unity.h>
+#include <string.h>
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "EEPROMStorage.h"
+#include "../FirmwareFixture.h"
+
+static const EpochTime START = 1704178800UL; // 2024-01-02 07:00:00, a whole hour
+static const uint32_t MINUTE = 60;
+
+// One sample for the slot at the given minute
+static void feed(ClimateLog &log, EpochTime time, int8_t temperature, int8_t humidity)
+{
+  log.onSample({temperature, humidity});
+  log.onMinute({time, (uint8_t)(time / 3600 % 24), (uint8_t)(time / 60 % 60)});
+}
+
+// The whole log, oldest first
+static uint16_t readAll(const ClimateLog &log, ClimateSample *samples, uint16_t size)
+{
+  ClimateCursor cursor;
+  ClimateSample sample;
+  uint16_t count = 0;
+  log.rewind(cursor);
+  while (log.next(cursor, sample))
+  {
+    if (count < size)
+    {
+      samples[count] = sample;
+    }
+    count++;
+  }
+  return count;
+}
+
+// Indoor air: drifts by a degree or a percent now and then
+static void indoor(uint16_t i, int8_t &temperature, int8_t &humidity)
+{
+  temperature = 21 + (i / 7) % 4 - (i / 31) % 3;
+  humidity = 45 + (i / 5) % 3 - (i / 17) % 4;
+}
+
+void setUp()
+{
+  halReset();
+  halSetRtc(START - 30);
+}
+
+void tearDown()
+{
+}
+
+void test_zigzag()
+{
+  const int16_t values[] = {0, -1, 1, -2, 2, 63, -64, 150, -150};
+  const uint16_t codes[] = {0, 1, 2, 3, 4, 126, 127, 300, 299};
+  for (uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+  {
+    TEST_ASSERT_EQUAL_UINT16(codes[i], ClimateLog::zigzag(values[i]));
+    TEST_ASSERT_EQUAL_INT16(values[i], ClimateLog::unzigzag(codes[i]));
+  }
+}
+
+void test_round_trip()
+{
+  ClimateLog log;
+  log.begin();
+  TEST_ASSERT_EQUAL_UINT8(CLIMATE_DEFAULT_INTERVAL, log.getInterval());
+
+  // Runs, the nine small changes, escapes of both signs and the extremes
+  const int8_t temperatures[] = {21, 21, 21, 21, 21, 21, 21, 21, 22, 21, 20, 20, 20, 21, 22, 23, 23,
+                                 -40, 99, 98, 98, -50, 100, 100, 22};
+  const int8_t humidities[] = {40, 40, 40, 40, 40, 40, 40, 40, 41, 40, 39, 40, 41, 41, 40, 39, 38,
+                               0, 100, 95, 95, 5, 96, 97, 40};
+  const uint8_t count = sizeof(temperatures);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    feed(log, START + i * 5 * MINUTE, temperatures[i], humidities[i]);
+  }
+
+  ClimateSample samples[32];
+  TEST_ASSERT_EQUAL_UINT16(count, readAll(log, samples, 32));
+  for (uint8_t i = 0; i < count; i++)
+  {
+    TEST_ASSERT_EQUAL_UINT32(START + i * 5 * MINUTE, samples[i].time);
+    TEST_ASSERT_EQUAL_INT8(temperatures[i], samples[i].temperature);
+    TEST_ASSERT_EQUAL_INT8(humidities[i], samples[i].humidity);
+  }
+
+  // All in one block: the header and 52 nibbles, 16 of them for the 17
+  // small changes and 36 for the six escapes
+  ClimateStats stats = log.getStats();
+  TEST_ASSERT_EQUAL_UINT16(count, stats.samples);
+  TEST_ASSERT_EQUAL_UINT16(sizeof(ClimateHeader) + 26, stats.bytes);
+  TEST_ASSERT_EQUAL_UINT32(START, stats.first);
+  TEST_ASSERT_EQUAL_UINT32(START + (count - 1) * 5 * MINUTE, stats.last);
+}
+
+void test_a_day_fits_with_room_to_spare()
+{
+  ClimateLog log;
+  log.begin();
+  int8_t temperature;
+  int8_t humidity;
+  const uint16_t day = 24 * 60 / CLIMATE_DEFAULT_INTERVAL;
+  for (uint16_t i = 0; i < day; i++)
+  {
+    indoor(i, temperature, humidity);
+    feed(log, START + i * CLIMATE_DEFAULT_INTERVAL * MINUTE, temperature, humidity);
+  }
+
+  ClimateStats stats = log.getStats();
+  TEST_ASSERT_EQUAL_UINT16(day, stats.samples);
+  // Under a third of the ring, and of two raw bytes a sample
+  TEST_ASSERT_TRUE(stats.bytes * 3 < CLIMATE_BLOCKS * CLIMATE_BLOCK_BYTES);
+  TEST_ASSERT_TRUE(stats.bytes * 3 < stats.samples * 2);
+
+  // Decoded back exactly
+  ClimateCursor cursor;
+  ClimateSample sample;
+  uint16_t i = 0;
+  uint16_t wrong = 0;
+  log.rewind(cursor);
+  while (log.next(cursor, sample))
+  {
+    indoor(i, temperature, humidity);
+    if (sample.time != START + i * CLIMATE_DEFAULT_INTERVAL * MINUTE || sample.temperature != temperature ||
+        sample.humidity != humidity)
+    {
+      wrong++;
+    }
+    i++;
+  }
+  TEST_ASSERT_EQUAL_UINT16(day, i);
+  TEST_ASSERT_EQUAL_UINT16(0, wrong);
+}
+
+void test_ring_wraps_and_goes_on_after_restart()
+{
+  int8_t temperature;
+  int8_t humidity;
+  const uint16_t total = 4000;
+  {
+    ClimateLog log;
+    log.begin();
+    log.setInterval(1);
+    for (uint16_t i = 0; i < total; i++)
+    {
+      indoor(i, temperature, humidity);
+      feed(log, START + i * MINUTE, temperature, humidity);
+    }
+  }
+
+  // A restart finds the newest block and appends to it
+  ClimateLog log;
+  log.begin();
+  TEST_ASSERT_EQUAL_UINT8(1, log.getInterval());
+  ClimateStats before = log.getStats();
+  indoor(total, temperature, humidity);
+  feed(log, START + total * MINUTE, temperature, humidity);
+  ClimateStats after = log.getStats();
+  TEST_ASSERT_EQUAL_UINT16(before.samples + 1, after.samples);
+  TEST_ASSERT_EQUAL_UINT32(START + total * MINUTE, after.last);
+
+  // The oldest blocks are gone; the rest is whole and in order
+  TEST_ASSERT_TRUE(after.samples < total);
+  TEST_ASSERT_TRUE(after.samples > (CLIMATE_BLOCKS - 1) * CLIMATE_PAYLOAD_BYTES * 2);
+  ClimateCursor cursor;
+  ClimateSample sample;
+  uint16_t i = total + 1 - after.samples;
+  uint16_t wrong = 0;
+  log.rewind(cursor);
+  while (log.next(cursor, sample))
+  {
+    indoor(i, temperature, humidity);
+    if (sample.time != START + i * MINUTE || sample.temperature != temperature || sample.humidity != humidity)
+    {
+      wrong++;
+    }
+    i++;
+  }
+  TEST_ASSERT_EQUAL_UINT16(total + 1, i);
+  TEST_ASSERT_EQUAL_UINT16(0, wrong);
+}
+
+void test_gaps_start_new_blocks()
+{
+  ClimateLog log;
+  log.begin();
+  feed(log, START, 20, 50);
+  feed(log, START + 5 * MINUTE, 20, 50);
+
+  // A slot without a reading (the sensor failed) is left out
+  log.onMinute({START + 10 * MINUTE, 7, 10});
+  feed(log, START + 15 * MINUTE, 21, 50);
+
+  // A minute tick missed: still the slot it was due for
+  feed(log, START + 21 * MINUTE, 22, 50);
+
+  // New blocks only start on whole intervals
+  log.setInterval(10);
+  feed(log, START + 25 * MINUTE, 23, 51);
+  feed(log, START + 30 * MINUTE, 23, 52);
+
+  // The clock set back
+  feed(log, START - 60 * MINUTE, 10, 60);
+  feed(log, START - 50 * MINUTE, 11, 60);
+
+  ClimateSample samples[8];
+  TEST_ASSERT_EQUAL_UINT16(7, readAll(log, samples, 8));
+  const EpochTime times[] = {START, START + 5 * MINUTE, START + 15 * MINUTE, START + 20 * MINUTE,
+                             START + 30 * MINUTE, START - 60 * MINUTE, START - 50 * MINUTE};
+  for (uint8_t i = 0; i < 7; i++)
+  {
+    TEST_ASSERT_EQUAL_UINT32(times[i], samples[i].time);
+  }
+  TEST_ASSERT_EQUAL_INT8(22, samples[3].temperature);
+  TEST_ASSERT_EQUAL_INT8(52, samples[4].humidity);
+  TEST_ASSERT_EQUAL_INT8(11, samples[6].temperature);
+
+  // Off: nothing more
+  log.setInterval(0);
+  feed(log, START - 40 * MINUTE, 12, 60);
+  TEST_ASSERT_EQUAL_UINT16(7, readAll(log, samples, 8));
+}
+
+void test_serial_report_and_csv()
+{
+  halSetDht(22, 41);
+  Firmware fw(PART_CLIMATE_LOG);
+  fw.command("climate 1");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Climate log: every 1 min"));
+
+  fw.run(100000);
+  halSetDht(23, 41);
+  fw.run(60000);
+  halSetDht(24, 44);
+  fw.run(60000);
+
+  fw.command("climate csv");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "time,temperature,humidity"));
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "1704178800,22,41"));
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "1704178860,22,41"));
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "1704178920,23,41"));
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "1704178980,24,44"));
+  TEST_ASSERT_NULL(strstr(halSerialOutput(), "1704179040"));
+
+  fw.command("climate");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Stored: 4 samples in 11 of 576 bytes, 0.36 samples/byte"));
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Span: 0.0 h"));
+
+  // Kept over a restart, cleared on request
+  EEPROMStorage eeprom;
+  uint8_t minutes;
+  TEST_ASSERT_TRUE(eeprom.loadClimateInterval(minutes));
+  TEST_ASSERT_EQUAL_UINT8(1, minutes);
+  fw.command("climate clear");
+  fw.command("climate");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Stored: 0 samples"));
+  fw.command("climate 0");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Invalid climate command"));
+}
+
+void test_out_of_range_readings_are_gaps()
+{
+  // Humidity out of range from power-up: no sample, not the initial 0 %
+  halSetDht(22, 120);
+  Firmware fw(PART_CLIMATE_LOG);
+  fw.command("climate 1");
+  fw.run(100000);
+  fw.command("climate");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Stored: 0 samples"));
+
+  halSetDht(22, 41);
+  fw.run(60000);
+  fw.command("climate csv");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "1704178920,22,41"));
+  TEST_ASSERT_NULL(strstr(halSerialOutput(), ",22,0"));
+}
+
+void test_cleared_eeprom_reads_empty()
+{
+  EEPROMStorage eeprom;
+  eeprom.clearSettings();
+  ClimateLog log;
+  log.begin();
+  TEST_ASSERT_EQUAL_UINT8(CLIMATE_DEFAULT_INTERVAL, log.getInterval());
+  TEST_ASSERT_EQUAL_UINT16(0, log.getStats().samples);
+  ClimateSample samples[1];
+  TEST_ASSERT_EQUAL_UINT16(0, readAll(log, samples, 1));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_zigzag);
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_a_day_fits_with_room_to_spare);
+  RUN_TEST(test_ring_wraps_and_goes_on_after_restart);
+  RUN_TEST(test_gaps_start_new_blocks);
+  RUN_TEST(test_serial_report_and_csv);
+  RUN_TEST(test_out_of_range_readings_are_gaps);
+  RUN_TEST(test_cleared_eeprom_reads_empty);
+  return UNITY_END();
+}
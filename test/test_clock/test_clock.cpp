@@ -0,0 +1,299 @@
+#include <unity.h>
+#include <string.h>
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "Button.h"
+#include "../FirmwareFixture.h"
+
+static const uint32_t MONDAY_0659 = 1704178740UL; // 2024-01-02 06:59:00
+
+void setUp()
+{
+  halReset();
+}
+
+void tearDown()
+{
+}
+
+void test_serial_sets_rtc_time()
+{
+  Firmware fw;
+  halSerialClear();
+  fw.command("time 143000");
+
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "14:30:00"));
+  TEST_ASSERT_EQUAL_UINT32(14 * 3600UL + 30 * 60, halGetRtc() % 86400UL);
+  Time time = fw.clock.getTime();
+  TEST_ASSERT_EQUAL_UINT8(14, time.hour);
+  TEST_ASSERT_EQUAL_UINT8(30, time.minute);
+}
+
+void test_serial_rejects_day_past_month_end()
+{
+  Firmware fw;
+  halSetRtc(MONDAY_0659);
+  fw.command("date 31022024");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Invalid date values"));
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659, halGetRtc());
+
+  fw.command("date 29022024"); // A leap year
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Date set to: 29.02.2024"));
+  Date date = fw.clock.getDate();
+  TEST_ASSERT_EQUAL_UINT8(29, date.day);
+  TEST_ASSERT_EQUAL_UINT8(2, date.month);
+}
+
+void test_stopped_rtc_starts_unset()
+{
+  // Not from the build time: that is the build machine's local time
+  halStopRtc();
+  halSerialClear();
+  Firmware fw;
+  TEST_ASSERT_TRUE(halRtcRunning());
+  TEST_ASSERT_EQUAL_UINT32(RTC_UNSET_TIME, halGetRtc());
+  TEST_ASSERT_TRUE(fw.clock.isTimeLost());
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "RTC had stopped and is not set"));
+
+  fw.command("status");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "(not set)"));
+  fw.command("date 02012024");
+  TEST_ASSERT_FALSE(fw.clock.isTimeLost());
+}
+
+void test_square_wave_drives_time_string()
+{
+  char text[DISPLAY_CHARS];
+  Firmware fw;
+  halSetRtc(MONDAY_0659);
+  fw.clock.setTime({6, 59, 0});
+  TEST_ASSERT_EQUAL_STRING_LEN("065900", fw.clock.getTimeString(text), 6);
+
+  // The edge comes after 1000 ms, the next loop pass picks it up
+  fw.run(999);
+  TEST_ASSERT_EQUAL_STRING_LEN("065900", fw.clock.getTimeString(text), 6);
+  fw.run(2);
+  TEST_ASSERT_EQUAL_STRING_LEN("065901", fw.clock.getTimeString(text), 6);
+}
+
+void test_missing_square_wave_falls_back_to_polling()
+{
+  // SQW wired to the other interrupt pin: D2 never sees an edge
+  char text[DISPLAY_CHARS];
+  halSetRtcSqwInterrupt(1);
+  Firmware fw;
+  halSetRtc(MONDAY_0659);
+  fw.clock.setTime({6, 59, 0});
+  TEST_ASSERT_TRUE(fw.rtc.hasSquareWave());
+
+  fw.run(1400);
+  TEST_ASSERT_TRUE(fw.rtc.hasSquareWave());
+  TEST_ASSERT_EQUAL_STRING_LEN("065900", fw.clock.getTimeString(text), 6);
+  fw.run(200);
+  TEST_ASSERT_FALSE(fw.rtc.hasSquareWave());
+  TEST_ASSERT_EQUAL_STRING_LEN("065901", fw.clock.getTimeString(text), 6);
+
+  // Polled seconds keep the alarms going
+  fw.command("alarm 1 set 0700");
+  fw.command("alarm 1 on");
+  fw.run(59000);
+  TEST_ASSERT_EQUAL(ALARM_RINGING, fw.clock.getAlarmState());
+
+  // An edge brings the square wave back; a power-down without one drops it
+  halSetRtcSqwInterrupt(0);
+  fw.run(1000);
+  TEST_ASSERT_TRUE(fw.rtc.hasSquareWave());
+  fw.rtc.missedEdge();
+  TEST_ASSERT_FALSE(fw.rtc.hasSquareWave());
+}
+
+void test_alarm_rings_and_snoozes()
+{
+  Firmware fw;
+  halSetRtc(MONDAY_0659);
+  fw.command("alarm 1 set 0700");
+  fw.command("alarm 1 on");
+  TEST_ASSERT_FALSE(fw.clock.isAlarmTriggered());
+
+  // 10 ms into the first beep
+  fw.run(60010);
+  TEST_ASSERT_EQUAL(ALARM_RINGING, fw.clock.getAlarmState());
+  TEST_ASSERT_NOT_EQUAL(0, halGetTone(BUZZER_PIN));
+
+  fw.command("alarm snooze");
+  TEST_ASSERT_EQUAL(ALARM_SNOOZED, fw.clock.getAlarmState());
+  TEST_ASSERT_EQUAL(0, halGetTone(BUZZER_PIN));
+}
+
+void test_settings_survive_restart()
+{
+  {
+    Firmware fw;
+    fw.command("alarm 2 set 0815");
+    fw.command("alarm 2 days 1111100");
+  }
+
+  Firmware fw;
+  AlarmData alarm = fw.clock.getAlarmTime(1);
+  TEST_ASSERT_EQUAL_UINT8(8, alarm.hour);
+  TEST_ASSERT_EQUAL_UINT8(15, alarm.minute);
+  TEST_ASSERT_EQUAL_UINT8(ALARM_WEEKDAYS, alarm.days);
+}
+
+void test_snooze_settings_survive_restart()
+{
+  {
+    Firmware fw;
+    fw.command("alarm snooze 07 2");
+    TEST_ASSERT_EQUAL_UINT8(7, fw.clock.getAlarmSnooze().minutes);
+  }
+
+  Firmware fw;
+  SnoozeConfig snooze = fw.clock.getAlarmSnooze();
+  TEST_ASSERT_EQUAL_UINT8(7, snooze.minutes);
+  TEST_ASSERT_EQUAL_UINT8(2, snooze.limit);
+}
+
+void test_fired_alarm_stays_fired_after_restart()
+{
+  {
+    Firmware fw;
+    halSetRtc(MONDAY_0659);
+    fw.command("alarm 1 set 0700");
+    fw.command("alarm 1 on");
+    fw.run(60010);
+    TEST_ASSERT_EQUAL(ALARM_RINGING, fw.clock.getAlarmState());
+    fw.command("alarm dismiss");
+  }
+
+  // The image is the AVR's: 2-byte magics, Settings packed, little-endian
+  const uint8_t *image = halEeprom();
+  TEST_ASSERT_EQUAL_HEX8(0x36, image[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x12, image[1]);
+  TEST_ASSERT_EQUAL_HEX8(2024 & 0xFF, image[9]);
+  TEST_ASSERT_EQUAL_HEX8(2024 >> 8, image[10]);
+  TEST_ASSERT_EQUAL_UINT8(7, image[11]); // Alarm 1 hour
+  TEST_ASSERT_EQUAL_HEX8(0xF1, image[32]);
+  TEST_ASSERT_EQUAL_HEX8(0x5A, image[33]);
+
+  // Still inside the catch-up window, but the record says it has rung
+  Firmware fw;
+  fw.run(2000);
+  TEST_ASSERT_EQUAL(ALARM_ARMED, fw.clock.getAlarmState());
+}
+
+void test_time_zone_keeps_rtc_on_utc()
+{
+  char text[DISPLAY_CHARS];
+  const uint32_t SPRING = 1711846800UL; // 2024-03-31 01:00 UTC, CET to CEST
+  {
+    Firmware fw;
+    halSetRtc(SPRING - 3);
+    halSerialClear();
+    fw.command("tz 3");
+    TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Berlin (UTC+01:00)"));
+    TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Next change: 31.03.2024 03:00:00"));
+
+    // The display follows the change, the RTC does not
+    fw.run(1000);
+    TEST_ASSERT_EQUAL_STRING_LEN("015958", fw.clock.getTimeString(text), 6);
+    fw.run(2000);
+    TEST_ASSERT_EQUAL_STRING_LEN("030000", fw.clock.getTimeString(text), 6);
+    TEST_ASSERT_EQUAL_UINT32(SPRING, fw.clock.getUnixTime());
+
+    // Set in local time, kept in UTC
+    fw.command("time 120000");
+    TEST_ASSERT_EQUAL_UINT32(10 * 3600UL, halGetRtc() % 86400UL);
+    TEST_ASSERT_EQUAL_UINT8(12, fw.clock.getTime().hour);
+  }
+
+  Firmware fw;
+  TEST_ASSERT_EQUAL_UINT8(2, fw.clock.getTimeZone().getSelected());
+  TEST_ASSERT_EQUAL_UINT8(12, fw.clock.getTime().hour);
+}
+
+void test_finished_timer_chimes()
+{
+  Firmware fw;
+  fw.command("timer set 000003");
+  fw.command("timer start");
+  TEST_ASSERT_TRUE(fw.clock.isTimerRunning());
+
+  fw.run(2900);
+  TEST_ASSERT_EQUAL_UINT8(0, fw.timerCompletions);
+  TEST_ASSERT_EQUAL(0, halGetTone(BUZZER_PIN));
+
+  fw.run(110);
+  TEST_ASSERT_EQUAL_UINT8(1, fw.timerCompletions);
+  TEST_ASSERT_FALSE(fw.clock.isTimerRunning());
+  TEST_ASSERT_NOT_EQUAL(0, halGetTone(BUZZER_PIN));
+}
+
+static uint8_t scanPatterns[6];
+static uint8_t scanCount = 0;
+
+static void capturePattern(uint8_t dataPin, uint8_t value)
+{
+  if (dataPin == SHIFT_PIN && scanCount < 6)
+  {
+    scanPatterns[scanCount++] = value;
+  }
+}
+
+void test_display_scans_all_digits()
+{
+  Display display;
+  display.begin(3, 4, 5, 6, SHIFT_PIN, 7);
+  display.print("123456");
+  scanCount = 0;
+  halOnShiftOut(capturePattern);
+
+  // Rightmost digit first, one per refresh
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    display.update();
+  }
+  TEST_ASSERT_EQUAL_HEX8(0b01111101, scanPatterns[0]); // 6
+  TEST_ASSERT_EQUAL_HEX8(0b00000110, scanPatterns[5]); // 1
+}
+
+void test_button_debounces_and_long_presses()
+{
+  Button button(A1);
+  button.begin();
+
+  halSetPin(A1, HIGH);
+  for (uint8_t i = 0; i < 40; i++)
+  {
+    button.update();
+    halAdvanceMillis(1);
+  }
+  TEST_ASSERT_FALSE(button.isPressed());
+
+  for (uint16_t i = 0; i < 3100; i++)
+  {
+    button.update();
+    halAdvanceMillis(1);
+  }
+  TEST_ASSERT_TRUE(button.isPressed());
+  TEST_ASSERT_TRUE(button.isLongPressed());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_serial_sets_rtc_time);
+  RUN_TEST(test_serial_rejects_day_past_month_end);
+  RUN_TEST(test_stopped_rtc_starts_unset);
+  RUN_TEST(test_square_wave_drives_time_string);
+  RUN_TEST(test_missing_square_wave_falls_back_to_polling);
+  RUN_TEST(test_alarm_rings_and_snoozes);
+  RUN_TEST(test_settings_survive_restart);
+  RUN_TEST(test_snooze_settings_survive_restart);
+  RUN_TEST(test_fired_alarm_stays_fired_after_restart);
+  RUN_TEST(test_time_zone_keeps_rtc_on_utc);
+  RUN_TEST(test_finished_timer_chimes);
+  RUN_TEST(test_display_scans_all_digits);
+  RUN_TEST(test_button_debounces_and_long_presses);
+  return UNITY_END();
+}
@@ -0,0 +1,143 @@
+#include <unity.h>
+#include <time.h>
+#include "Epoch.h"
+
+// The C library's UTC calendar is the reference
+static time_t reference(const Date &date, const Time &time)
+{
+  struct tm fields = {};
+  fields.tm_year = date.year - 1900;
+  fields.tm_mon = date.month - 1;
+  fields.tm_mday = date.day;
+  fields.tm_hour = time.hour;
+  fields.tm_min = time.minute;
+  fields.tm_sec = time.second;
+  return timegm(&fields);
+}
+
+static const EpochTime Y2000 = 946684800UL;  // 2000-01-01 00:00:00
+static const EpochTime Y2100 = 4102444800UL; // 2100-01-01 00:00:00
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_every_day_2000_to_2099_converts_both_ways()
+{
+  uint32_t days = 0;
+  for (EpochTime day = Y2000; day < Y2100; day += Epoch::SECONDS_PER_DAY)
+  {
+    // A different time of day for each date
+    EpochTime time = day + (days * 7919UL) % Epoch::SECONDS_PER_DAY;
+    time_t t = time;
+    struct tm expected;
+    gmtime_r(&t, &expected);
+
+    Date date = Epoch::toDate(time);
+    Time clock = Epoch::toTime(time);
+    TEST_ASSERT_EQUAL_UINT16(expected.tm_year + 1900, date.year);
+    TEST_ASSERT_EQUAL_UINT8(expected.tm_mon + 1, date.month);
+    TEST_ASSERT_EQUAL_UINT8(expected.tm_mday, date.day);
+    TEST_ASSERT_EQUAL_UINT8(expected.tm_hour, clock.hour);
+    TEST_ASSERT_EQUAL_UINT8(expected.tm_min, clock.minute);
+    TEST_ASSERT_EQUAL_UINT8(expected.tm_sec, clock.second);
+    TEST_ASSERT_EQUAL_UINT8(expected.tm_wday, Epoch::dayOfWeek(time));
+
+    TEST_ASSERT_EQUAL_UINT32(time, Epoch::fromFields(date, clock));
+    TEST_ASSERT_EQUAL_UINT32(day, Epoch::startOfDay(time));
+    TEST_ASSERT_EQUAL_UINT16(time / Epoch::SECONDS_PER_DAY, Epoch::toDays(date));
+    days++;
+  }
+  TEST_ASSERT_EQUAL_UINT32(36525, days);
+}
+
+void test_day_boundaries_of_every_month()
+{
+  for (uint16_t year = 2000; year <= 2099; year++)
+  {
+    for (uint8_t month = 1; month <= 12; month++)
+    {
+      uint8_t last = Epoch::daysInMonth(year, month);
+      Date first = {1, month, year};
+      Date end = {last, month, year};
+
+      TEST_ASSERT_EQUAL_UINT32(reference(first, {0, 0, 0}), Epoch::fromFields(first, {0, 0, 0}));
+      TEST_ASSERT_EQUAL_UINT32(reference(end, {23, 59, 59}), Epoch::fromFields(end, {23, 59, 59}));
+
+      // The second after the month's last is the next month's first
+      Date next = Epoch::toDate(Epoch::fromFields(end, {23, 59, 59}) + 1);
+      TEST_ASSERT_EQUAL_UINT8(1, next.day);
+      TEST_ASSERT_EQUAL_UINT8(month % 12 + 1, next.month);
+    }
+  }
+}
+
+void test_leap_years()
+{
+  TEST_ASSERT_TRUE(Epoch::isLeapYear(2000));
+  TEST_ASSERT_TRUE(Epoch::isLeapYear(2024));
+  TEST_ASSERT_FALSE(Epoch::isLeapYear(2023));
+  TEST_ASSERT_FALSE(Epoch::isLeapYear(2100));
+  TEST_ASSERT_EQUAL_UINT8(29, Epoch::daysInMonth(2000, 2));
+  TEST_ASSERT_EQUAL_UINT8(28, Epoch::daysInMonth(2099, 2));
+  TEST_ASSERT_EQUAL_UINT8(30, Epoch::daysInMonth(2024, 11));
+  TEST_ASSERT_EQUAL_UINT8(31, Epoch::daysInMonth(2024, 12));
+
+  // The leap days themselves
+  uint8_t leapDays = 0;
+  for (uint16_t year = 2000; year <= 2099; year++)
+  {
+    if (Epoch::daysInMonth(year, 2) == 29)
+    {
+      Date date = Epoch::toDate(Epoch::fromFields({29, 2, year}, {12, 0, 0}));
+      TEST_ASSERT_EQUAL_UINT8(29, date.day);
+      TEST_ASSERT_EQUAL_UINT8(2, date.month);
+      leapDays++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT8(25, leapDays);
+}
+
+void test_epoch_start_and_range_end()
+{
+  Date date = Epoch::toDate(0);
+  TEST_ASSERT_EQUAL_UINT16(1970, date.year);
+  TEST_ASSERT_EQUAL_UINT8(1, date.month);
+  TEST_ASSERT_EQUAL_UINT8(1, date.day);
+  TEST_ASSERT_EQUAL_UINT8(4, Epoch::dayOfWeek(0)); // Thursday
+
+  EpochTime last = Y2100 - 1;
+  date = Epoch::toDate(last);
+  Time time = Epoch::toTime(last);
+  TEST_ASSERT_EQUAL_UINT16(2099, date.year);
+  TEST_ASSERT_EQUAL_UINT8(12, date.month);
+  TEST_ASSERT_EQUAL_UINT8(31, date.day);
+  TEST_ASSERT_EQUAL_UINT8(23, time.hour);
+  TEST_ASSERT_EQUAL_UINT8(59, time.minute);
+  TEST_ASSERT_EQUAL_UINT8(59, time.second);
+}
+
+void test_times_of_day()
+{
+  TEST_ASSERT_EQUAL_UINT32(0, Epoch::toSeconds({0, 0, 0}));
+  TEST_ASSERT_EQUAL_UINT32(86399UL, Epoch::toSeconds({23, 59, 59}));
+  for (uint32_t seconds = 0; seconds < Epoch::SECONDS_PER_DAY; seconds += 37)
+  {
+    TEST_ASSERT_EQUAL_UINT32(seconds, Epoch::toSeconds(Epoch::toTime(Y2000 + seconds)));
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_every_day_2000_to_2099_converts_both_ways);
+  RUN_TEST(test_day_boundaries_of_every_month);
+  RUN_TEST(test_leap_years);
+  RUN_TEST(test_epoch_start_and_range_end);
+  RUN_TEST(test_times_of_day);
+  return UNITY_END();
+}
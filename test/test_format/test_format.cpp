@@ -0,0 +1,116 @@
+#include <unity.h>
+#include <string.h>
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "Format.h"
+#include "Clock.h"
+#include "Buzzer.h"
+
+// Collects what is printed
+struct TextSink : public Print
+{
+  char text[32];
+  size_t length = 0;
+
+  size_t write(uint8_t c) override
+  {
+    if (length < sizeof(text) - 1)
+    {
+      text[length++] = c;
+      text[length] = '\0';
+    }
+    return 1;
+  }
+
+  const char *take()
+  {
+    length = 0;
+    return text;
+  }
+};
+
+void setUp()
+{
+  halReset();
+}
+
+void tearDown()
+{
+}
+
+void test_reciprocal_division_is_exact()
+{
+  uint16_t wrong = 0;
+  for (uint16_t value = 0; value <= 255; value++)
+  {
+    if (Format::divideBy10(value) != value / 10)
+    {
+      wrong++;
+    }
+  }
+  for (uint16_t value = 0; value <= 9999; value++)
+  {
+    if (Format::divideBy100(value) != value / 100)
+    {
+      wrong++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT16(0, wrong);
+}
+
+void test_display_text()
+{
+  char text[DISPLAY_CHARS];
+  Format::twoDigits(text, 7);
+  TEST_ASSERT_EQUAL_STRING_LEN("07", text, 2);
+  Format::twoDigits(text, 99);
+  TEST_ASSERT_EQUAL_STRING_LEN("99", text, 2);
+  Format::display(text, 23, 5, 0);
+  TEST_ASSERT_EQUAL_STRING_LEN("230500", text, DISPLAY_CHARS);
+}
+
+void test_print_to_a_sink()
+{
+  TextSink sink;
+  Format::printTime(sink, 7, 5, 9);
+  TEST_ASSERT_EQUAL_STRING("07:05:09", sink.take());
+  Format::printTime(sink, 23, 59);
+  TEST_ASSERT_EQUAL_STRING("23:59", sink.take());
+  Format::printDate(sink, 1, 12, 2099);
+  TEST_ASSERT_EQUAL_STRING("01.12.2099", sink.take());
+  Format::printDate(sink, 29, 2, 2000);
+  TEST_ASSERT_EQUAL_STRING("29.02.2000", sink.take());
+  Format::printDays(sink, ALARM_WEEKDAYS);
+  TEST_ASSERT_EQUAL_STRING("MTWTF--", sink.take());
+  Format::printDays(sink, 0x01); // Sunday
+  TEST_ASSERT_EQUAL_STRING("------S", sink.take());
+}
+
+void test_climate_text_has_a_sign()
+{
+  Scheduler scheduler;
+  RTClock rtc;
+  Buzzer buzzer(9);
+  HTSensor dht11(A0);
+  Clock clock;
+  rtc.begin(A4, A5, 2);
+  dht11.begin(&scheduler);
+  clock.begin(&rtc, &dht11, &buzzer, &scheduler);
+
+  char text[DISPLAY_CHARS];
+  halSetDht(-7, 38);
+  halAdvanceMillis(3000);
+  scheduler.run();
+  TEST_ASSERT_EQUAL_STRING_LEN(" -07*C", clock.getTemperatureString(text), DISPLAY_CHARS);
+  TEST_ASSERT_EQUAL_STRING_LEN("  38*H", clock.getHumidityString(text), DISPLAY_CHARS);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_reciprocal_division_is_exact);
+  RUN_TEST(test_display_text);
+  RUN_TEST(test_print_to_a_sink);
+  RUN_TEST(test_climate_text_has_a_sign);
+  return UNITY_END();
+}
@@ -0,0 +1,111 @@
+#include <unity.h>
+#include <string.h>
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "MemoryMonitor.h"
+#include "EventBus.h"
+
+// RAM between the heap top (ram[0]) and the stack pointer
+static uint8_t ram[64];
+
+static uint8_t warnings = 0;
+static uint16_t lastHeadroom = 0;
+
+static void countWarning(const MemoryLow &event)
+{
+  warnings++;
+  lastHeadroom = event.headroom;
+}
+
+EVENT_SUBSCRIBERS(MemoryLow, countWarning);
+
+void setUp()
+{
+  halReset();
+  memset(ram, MEMORY_PAINT, sizeof(ram));
+  warnings = 0;
+  lastHeadroom = 0;
+}
+
+void tearDown()
+{
+}
+
+void test_untouched_region_is_all_headroom()
+{
+  uint16_t unused = 0;
+  const uint8_t *peak = MemoryMonitor::findStackPeak(ram, ram + sizeof(ram), unused);
+  TEST_ASSERT_TRUE(peak == ram + sizeof(ram));
+  TEST_ASSERT_EQUAL_UINT16(sizeof(ram), unused);
+}
+
+void test_stack_peak_ends_the_paint()
+{
+  // Deepest frame at 40, with a local it never wrote above it
+  memset(ram + 40, 0x12, 24);
+  ram[50] = MEMORY_PAINT;
+  ram[51] = MEMORY_PAINT;
+  uint16_t unused = 0;
+  const uint8_t *peak = MemoryMonitor::findStackPeak(ram, ram + sizeof(ram), unused);
+  TEST_ASSERT_TRUE(peak == ram + 40);
+  TEST_ASSERT_EQUAL_UINT16(40, unused);
+}
+
+void test_stale_heap_block_is_skipped()
+{
+  // A block freed off the top of the heap, with a paint byte by chance
+  memset(ram, 0x00, 12);
+  ram[5] = MEMORY_PAINT;
+  memset(ram + 50, 0x34, 14);
+  uint16_t unused = 0;
+  const uint8_t *peak = MemoryMonitor::findStackPeak(ram, ram + sizeof(ram), unused);
+  TEST_ASSERT_TRUE(peak == ram + 50);
+  TEST_ASSERT_EQUAL_UINT16(38, unused);
+}
+
+void test_collision_leaves_no_headroom()
+{
+  memset(ram, 0x00, 30);
+  memset(ram + 32, 0x56, 32); // Two stray paint bytes between them
+  uint16_t unused = 1;
+  const uint8_t *peak = MemoryMonitor::findStackPeak(ram, ram + sizeof(ram), unused);
+  TEST_ASSERT_TRUE(peak == ram);
+  TEST_ASSERT_EQUAL_UINT16(0, unused);
+}
+
+void test_warning_once_until_recovered()
+{
+  Scheduler scheduler;
+  MemoryMonitor::begin(&scheduler, 100);
+  MemoryMonitor::check(300);
+  TEST_ASSERT_EQUAL_UINT8(0, warnings);
+  MemoryMonitor::check(90);
+  MemoryMonitor::check(60);
+  TEST_ASSERT_EQUAL_UINT8(1, warnings);
+  TEST_ASSERT_EQUAL_UINT16(90, lastHeadroom);
+  MemoryMonitor::check(100);
+  MemoryMonitor::check(40);
+  TEST_ASSERT_EQUAL_UINT8(2, warnings);
+  TEST_ASSERT_EQUAL_UINT16(40, lastHeadroom);
+}
+
+void test_zero_threshold_never_warns()
+{
+  Scheduler scheduler;
+  MemoryMonitor::begin(&scheduler, 0);
+  MemoryMonitor::check(0);
+  TEST_ASSERT_EQUAL_UINT8(0, warnings);
+  TEST_ASSERT_FALSE(scheduler.hasTasks());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_untouched_region_is_all_headroom);
+  RUN_TEST(test_stack_peak_ends_the_paint);
+  RUN_TEST(test_stale_heap_block_is_skipped);
+  RUN_TEST(test_collision_leaves_no_headroom);
+  RUN_TEST(test_warning_once_until_recovered);
+  RUN_TEST(test_zero_threshold_never_warns);
+  return UNITY_END();
+}
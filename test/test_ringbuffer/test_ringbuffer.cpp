@@ -0,0 +1,185 @@
+#include <unity.h>
+#include <thread>
+#include "RingBuffer.h"
+#include "InputEvents.h"
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_fifo_until_full()
+{
+  RingBuffer<uint8_t, 4> queue;
+  TEST_ASSERT_TRUE(queue.isEmpty());
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    TEST_ASSERT_TRUE(queue.push(i));
+  }
+  TEST_ASSERT_TRUE(queue.isFull());
+  TEST_ASSERT_FALSE(queue.push(99));
+  TEST_ASSERT_EQUAL_UINT8(4, queue.available());
+
+  uint8_t value;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL_UINT8(i, value);
+  }
+  TEST_ASSERT_FALSE(queue.pop(value));
+}
+
+void test_indices_wrap()
+{
+  // Many times round the 8-bit counters, at every fill level
+  RingBuffer<uint16_t, 8> queue;
+  uint16_t next = 0;
+  uint16_t expected = 0;
+  for (uint16_t round = 0; round < 1000; round++)
+  {
+    uint8_t fill = round % 9;
+    for (uint8_t i = 0; i < fill; i++)
+    {
+      TEST_ASSERT_TRUE(queue.push(next++));
+    }
+    TEST_ASSERT_EQUAL_UINT8(fill, queue.available());
+    uint16_t value;
+    while (queue.pop(value))
+    {
+      TEST_ASSERT_EQUAL_UINT16(expected++, value);
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT16(next, expected);
+}
+
+void test_peek_and_clear()
+{
+  ButtonEdgeQueue queue;
+  queue.push({15, 1, 1000});
+  queue.push({15, 0, 1150});
+
+  ButtonEdgeEvent edge;
+  TEST_ASSERT_TRUE(queue.peek(edge));
+  TEST_ASSERT_EQUAL_UINT16(1000, edge.time);
+  TEST_ASSERT_EQUAL_UINT8(2, queue.available());
+
+  queue.clear();
+  TEST_ASSERT_TRUE(queue.isEmpty());
+  TEST_ASSERT_FALSE(queue.peek(edge));
+}
+
+void test_typed_events_copy_whole()
+{
+  SensorFrameQueue queue;
+  TEST_ASSERT_EQUAL_UINT8(2, SensorFrameQueue::capacity());
+  TEST_ASSERT_TRUE(queue.push({-5, 80, 1, 4242}));
+
+  SensorFrameEvent frame;
+  TEST_ASSERT_TRUE(queue.pop(frame));
+  TEST_ASSERT_EQUAL_INT8(-5, frame.temperature);
+  TEST_ASSERT_EQUAL_UINT8(80, frame.humidity);
+  TEST_ASSERT_EQUAL_UINT8(1, frame.ok);
+  TEST_ASSERT_EQUAL_UINT16(4242, frame.time);
+}
+
+static const uint32_t STRESS_ITEMS = 500000;
+
+void test_threads_keep_order()
+{
+  RingBuffer<uint32_t, 16> queue;
+  std::thread producer([&queue]() {
+    for (uint32_t i = 0; i < STRESS_ITEMS; i++)
+    {
+      while (!queue.push(i))
+      {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t expected = 0;
+  uint32_t errors = 0;
+  while (expected < STRESS_ITEMS)
+  {
+    uint32_t value;
+    if (!queue.pop(value))
+    {
+      std::this_thread::yield(); // Lets the producer in on a single core
+      continue;
+    }
+    if (value != expected)
+    {
+      errors++;
+    }
+    expected = value + 1;
+  }
+  producer.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, errors);
+  TEST_ASSERT_TRUE(queue.isEmpty());
+}
+
+// Fields that must agree; a torn copy shows up as a mismatch
+struct Checked
+{
+  uint32_t sequence;
+  uint32_t inverse;
+  uint16_t low;
+};
+
+void test_threads_never_tear_items()
+{
+  // Two slots keep both threads on the same memory as much as possible
+  RingBuffer<Checked, 2> queue;
+  std::thread producer([&queue]() {
+    for (uint32_t i = 0; i < STRESS_ITEMS; i++)
+    {
+      Checked item = {i, ~i, (uint16_t)i};
+      while (!queue.push(item))
+      {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t received = 0;
+  uint32_t torn = 0;
+  uint32_t outOfOrder = 0;
+  while (received < STRESS_ITEMS)
+  {
+    Checked item;
+    if (!queue.pop(item))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    if (item.inverse != ~item.sequence || item.low != (uint16_t)item.sequence)
+    {
+      torn++;
+    }
+    if (item.sequence != received)
+    {
+      outOfOrder++;
+    }
+    received++;
+  }
+  producer.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_until_full);
+  RUN_TEST(test_indices_wrap);
+  RUN_TEST(test_peek_and_clear);
+  RUN_TEST(test_typed_events_copy_whole);
+  RUN_TEST(test_threads_keep_order);
+  RUN_TEST(test_threads_never_tear_items);
+  return UNITY_END();
+}
@@ -0,0 +1,177 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "Timer.h"
+
+static const uint32_t FULL_DAY_MS = 23 * 3600000UL + 59 * 60000UL + 59 * 1000UL;
+
+// Deterministic pseudo-random loop latency: mostly short passes with
+// occasional long stalls (sensor reads, serial output, ...)
+static uint32_t jitterState = 12345;
+
+static uint32_t nextLoopLatency()
+{
+  jitterState = jitterState * 1103515245UL + 12345UL;
+  uint32_t r = (jitterState >> 16) & 0x7FFF;
+  if (r % 97 == 0)
+  {
+    return 250 + r % 900;
+  }
+  return 1 + r % 37;
+}
+
+static uint32_t expectedRemaining(uint32_t start, uint32_t duration)
+{
+  uint32_t elapsed = (uint32_t)millis() - start;
+  return elapsed >= duration ? 0 : duration - elapsed;
+}
+
+void setUp()
+{
+  jitterState = 12345;
+  halSetMillis(0);
+}
+
+void tearDown()
+{
+}
+
+void test_set_time_reports_fields()
+{
+  Timer timer;
+  timer.begin();
+  timer.setTime(1, 2, 3);
+
+  TimerData data = timer.getTime();
+  TEST_ASSERT_EQUAL_UINT8(1, data.hour);
+  TEST_ASSERT_EQUAL_UINT8(2, data.minute);
+  TEST_ASSERT_EQUAL_UINT8(3, data.second);
+  TEST_ASSERT_FALSE(data.running);
+  TEST_ASSERT_EQUAL_UINT32(3723000UL, timer.getRemainingMillis());
+}
+
+void test_start_requires_nonzero_duration()
+{
+  Timer timer;
+  timer.begin();
+  timer.start();
+  TEST_ASSERT_FALSE(timer.isRunning());
+}
+
+void test_display_rounds_up_to_whole_seconds()
+{
+  Timer timer;
+  timer.begin();
+  timer.setTime(0, 0, 10);
+  timer.start();
+
+  halAdvanceMillis(1);
+  TEST_ASSERT_EQUAL_UINT8(10, timer.getSecond());
+  halAdvanceMillis(999);
+  TEST_ASSERT_EQUAL_UINT8(9, timer.getSecond());
+}
+
+void test_full_day_countdown_with_jitter_has_zero_error()
+{
+  // Start one hour before the 32-bit millis() rollover
+  halSetMillis(0xFFFFFFFFUL - 3600000UL);
+
+  Timer timer;
+  timer.begin();
+  timer.setTime(23, 59, 59);
+  timer.start();
+  uint32_t start = millis();
+
+  uint32_t passes = 0;
+  while (!timer.isCompleted())
+  {
+    halAdvanceMillis(nextLoopLatency());
+    timer.update();
+    passes++;
+
+    uint32_t expected = expectedRemaining(start, FULL_DAY_MS);
+    TEST_ASSERT_EQUAL_UINT32(expected, timer.getRemainingMillis());
+    TEST_ASSERT_EQUAL_UINT32((expected + 999) / 1000,
+                             timer.getHour() * 3600UL + timer.getMinute() * 60UL + timer.getSecond());
+    TEST_ASSERT_EQUAL(expected > 0, timer.isRunning());
+  }
+
+  // Completion was detected on the first pass at or after the deadline
+  uint32_t overshoot = ((uint32_t)millis() - start) - FULL_DAY_MS;
+  TEST_ASSERT_LESS_THAN_UINT32(1150UL, overshoot);
+  TEST_ASSERT_GREATER_THAN(1000000UL, passes);
+  TEST_ASSERT_EQUAL_UINT32(0, timer.getRemainingMillis());
+}
+
+void test_pause_resume_accumulates_elapsed_time()
+{
+  Timer timer;
+  timer.begin();
+  timer.setTime(0, 1, 0);
+  timer.start();
+
+  halAdvanceMillis(15250);
+  timer.stop();
+  TEST_ASSERT_EQUAL_UINT32(44750UL, timer.getRemainingMillis());
+
+  // Paused time does not count
+  halAdvanceMillis(600000UL);
+  timer.update();
+  TEST_ASSERT_EQUAL_UINT32(44750UL, timer.getRemainingMillis());
+
+  timer.start();
+  halAdvanceMillis(44749);
+  timer.update();
+  TEST_ASSERT_FALSE(timer.isCompleted());
+  TEST_ASSERT_EQUAL_UINT32(1, timer.getRemainingMillis());
+
+  halAdvanceMillis(1);
+  timer.update();
+  TEST_ASSERT_TRUE(timer.isCompleted());
+  TEST_ASSERT_FALSE(timer.isRunning());
+}
+
+void test_pause_across_rollover()
+{
+  halSetMillis(0xFFFFFFFFUL - 500);
+
+  Timer timer;
+  timer.begin();
+  timer.setTime(0, 0, 5);
+  timer.start();
+
+  halAdvanceMillis(2000);
+  timer.stop();
+  TEST_ASSERT_EQUAL_UINT32(3000, timer.getRemainingMillis());
+
+  timer.start();
+  halAdvanceMillis(3000);
+  timer.update();
+  TEST_ASSERT_TRUE(timer.isCompleted());
+}
+
+void test_stop_after_deadline_completes()
+{
+  Timer timer;
+  timer.begin();
+  timer.setTime(0, 0, 1);
+  timer.start();
+
+  halAdvanceMillis(1500);
+  timer.stop();
+  TEST_ASSERT_TRUE(timer.isCompleted());
+  TEST_ASSERT_EQUAL_UINT32(0, timer.getRemainingMillis());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_set_time_reports_fields);
+  RUN_TEST(test_start_requires_nonzero_duration);
+  RUN_TEST(test_display_rounds_up_to_whole_seconds);
+  RUN_TEST(test_full_day_countdown_with_jitter_has_zero_error);
+  RUN_TEST(test_pause_resume_accumulates_elapsed_time);
+  RUN_TEST(test_pause_across_rollover);
+  RUN_TEST(test_stop_after_deadline_completes);
+  return UNITY_END();
+}
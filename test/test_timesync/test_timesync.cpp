@@ -0,0 +1,203 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "../FirmwareFixture.h"
+
+// The host, standing in for tools/timesync.py on a PC whose clock is right.
+// Its clock in us is the board's micros() plus an offset the host does not
+// know, and each direction of the serial link has its own latency.
+static const uint64_t HOST_OFFSET = 1717243200371234ULL; // 2024-06-01 12:00:00.371234 at micros() 0
+
+static uint64_t hostNow()
+{
+  return HOST_OFFSET + micros();
+}
+
+// One exchange, with the host's estimate of its clock minus micros()
+struct Sample
+{
+  int64_t offset; // us
+  int64_t delay;  // Round trip less the board's turnaround, us
+  int64_t rtcError; // RTC second start less the host's time for it, us
+};
+
+static uint32_t latency()
+{
+  // USB serial: 1 to 6 ms each way
+  return 1000 + rand() % 5000;
+}
+
+// False if the reply did not come back
+static bool exchange(Firmware &fw, Sample &sample)
+{
+  char line[40];
+  uint64_t t1 = hostNow();
+  snprintf(line, sizeof(line), "sync %llu\n", (unsigned long long)t1);
+  halAdvanceMicros(latency());
+  halSerialClear();
+  halSerialInput(line);
+  fw.serial.update();
+  halAdvanceMicros(latency());
+  uint64_t t4 = hostNow();
+
+  unsigned long long token;
+  unsigned t2, t3, unixTime, secondMicros;
+  int fields = sscanf(halSerialOutput(), "SYNC %llu %u %u %u %u", &token, &t2, &t3, &unixTime, &secondMicros);
+  if (fields != 5 || token != t1)
+  {
+    return false;
+  }
+
+  sample.offset = ((int64_t)(t1 - t2) + (int64_t)(t4 - t3)) / 2;
+  sample.delay = (int64_t)(t4 - t1) - (int64_t)(t3 - t2);
+  sample.rtcError = (int64_t)unixTime * 1000000 - ((int64_t)secondMicros + sample.offset);
+  return true;
+}
+
+// Keeps the sample with the least delay, as NTP's clock filter does
+static bool bestOf(Firmware &fw, uint8_t count, Sample &best)
+{
+  best.delay = INT64_MAX;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    Sample sample;
+    if (!exchange(fw, sample))
+    {
+      return false;
+    }
+    if (sample.delay < best.delay)
+    {
+      best = sample;
+    }
+    fw.run(50 + rand() % 200);
+  }
+  return true;
+}
+
+void setUp()
+{
+  halReset();
+  srand(44);
+}
+
+void tearDown()
+{
+}
+
+void test_exchange_reports_receive_and_transmit_instants()
+{
+  Firmware fw(PART_TIME_SYNC);
+  fw.run(2500);
+  Sample sample;
+  TEST_ASSERT_TRUE(exchange(fw, sample));
+
+  // The estimate is off by at most half the round trip
+  int64_t error = sample.offset - (int64_t)HOST_OFFSET;
+  TEST_ASSERT_TRUE(sample.delay >= 2000 && sample.delay <= 12000);
+  TEST_ASSERT_TRUE(llabs(error) <= sample.delay / 2);
+
+  // The RTC starts at 2024-01-01, months behind the host
+  TEST_ASSERT_TRUE(sample.rtcError < -100LL * 86400 * 1000000);
+}
+
+void test_loopback_sync_is_within_10ms()
+{
+  Firmware fw(PART_TIME_SYNC);
+  fw.run(1700);
+
+  Sample best;
+  TEST_ASSERT_TRUE(bestOf(fw, 8, best));
+
+  // Ask for the host's next whole second at least a second ahead, at the
+  // micros() instant the host expects it
+  uint64_t second = (hostNow() + 1000000) / 1000000 + 1;
+  uint32_t at = (uint32_t)(second * 1000000 - best.offset);
+  char line[48];
+  snprintf(line, sizeof(line), "sync set %u %u\n", at, (unsigned)second);
+  halAdvanceMicros(latency());
+  halSerialClear();
+  halSerialInput(line);
+  fw.run(1);
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "SYNC SET"));
+  TEST_ASSERT_TRUE(fw.timeSync.isPending());
+
+  // Past the instant and the next second edge
+  fw.run(3000);
+  TEST_ASSERT_FALSE(fw.timeSync.isPending());
+  TEST_ASSERT_TRUE(fw.timeSync.getLastLateness() >= 0 && fw.timeSync.getLastLateness() < 100);
+
+  // Against the true host clock: second edges within 10 ms of the host's
+  int64_t truth = (int64_t)fw.clock.getUnixTime() * 1000000 -
+                  ((int64_t)fw.clock.getSecondMicros() + (int64_t)HOST_OFFSET);
+  TEST_ASSERT_TRUE(llabs(truth) < 10000);
+
+  // And as the host measures it
+  Sample after;
+  TEST_ASSERT_TRUE(bestOf(fw, 8, after));
+  TEST_ASSERT_TRUE(llabs(after.rtcError) < 10000);
+}
+
+void test_rejects_bad_instants()
+{
+  Firmware fw(PART_TIME_SYNC);
+  fw.run(5000);
+  uint32_t now = micros();
+  char line[48];
+
+  // Already passed
+  snprintf(line, sizeof(line), "sync set %u 1717243200\n", now - 1000);
+  halSerialClear();
+  halSerialInput(line);
+  fw.run(1);
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Invalid sync instant"));
+
+  // Too far ahead
+  snprintf(line, sizeof(line), "sync set %u 1717243200\n", now + 20000000);
+  halSerialClear();
+  halSerialInput(line);
+  fw.run(1);
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Invalid sync instant"));
+
+  // Before the DS1307's range
+  snprintf(line, sizeof(line), "sync set %u 12345\n", now + 1000000);
+  halSerialClear();
+  halSerialInput(line);
+  fw.run(1);
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Invalid sync instant"));
+  TEST_ASSERT_FALSE(fw.timeSync.isPending());
+}
+
+void test_failed_write_is_reported()
+{
+  Firmware fw(PART_TIME_SYNC);
+  fw.run(2000);
+  char line[48];
+  snprintf(line, sizeof(line), "sync set %u 1717243200\n", (unsigned)(micros() + 500000));
+  halSerialInput(line);
+  fw.run(490);
+  TEST_ASSERT_TRUE(fw.timeSync.isPending());
+
+  // The bus hangs just before the write
+  halSetI2cHang(5);
+  fw.run(20);
+  TEST_ASSERT_FALSE(fw.timeSync.isPending());
+  TEST_ASSERT_TRUE(fw.timeSync.hasWriteFailed());
+  TEST_ASSERT_NOT_EQUAL(1717243200UL, halGetRtc());
+
+  halSerialClear();
+  halSerialInput("sync\n");
+  fw.run(1);
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "last write failed"));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_exchange_reports_receive_and_transmit_instants);
+  RUN_TEST(test_loopback_sync_is_within_10ms);
+  RUN_TEST(test_rejects_bad_instants);
+  RUN_TEST(test_failed_write_is_reported);
+  return UNITY_END();
+}
@@ -0,0 +1,185 @@
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "TimeZone.h"
+
+// The C library's POSIX TZ rules are the reference, one per zone
+struct Reference
+{
+  const char *name;
+  const char *tz;
+};
+
+static const Reference REFERENCES[] = {
+    {"UTC", "UTC0"},
+    {"London", "GMT0BST,M3.5.0/1,M10.5.0/2"},
+    {"Berlin", "CET-1CEST,M3.5.0/2,M10.5.0/3"},
+    {"Helsinki", "EET-2EEST,M3.5.0/3,M10.5.0/4"},
+    {"Moscow", "MSK-3"},
+    {"Kolkata", "IST-5:30"},
+    {"Tokyo", "JST-9"},
+    {"Sydney", "AEST-10AEDT,M10.1.0/2,M4.1.0/3"},
+    {"Auckland", "NZST-12NZDT,M9.5.0/2,M4.1.0/3"},
+    {"New York", "EST5EDT,M3.2.0/2,M11.1.0/2"},
+    {"Chicago", "CST6CDT,M3.2.0/2,M11.1.0/2"},
+    {"Denver", "MST7MDT,M3.2.0/2,M11.1.0/2"},
+    {"Phoenix", "MST7"},
+    {"Los Angeles", "PST8PDT,M3.2.0/2,M11.1.0/2"},
+};
+
+static const EpochTime Y2000 = 946684800UL;  // 2000-01-01 00:00:00
+static const EpochTime Y2100 = 4102444800UL; // 2100-01-01 00:00:00
+static const uint8_t BERLIN = 2;
+
+static void useReference(uint8_t zone)
+{
+  setenv("TZ", REFERENCES[zone].tz, 1);
+  tzset();
+}
+
+static int32_t referenceOffset(EpochTime utc)
+{
+  time_t t = utc;
+  struct tm fields;
+  localtime_r(&t, &fields);
+  return fields.tm_gmtoff;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_zone_table_matches_references()
+{
+  TEST_ASSERT_EQUAL_UINT8(sizeof(REFERENCES) / sizeof(REFERENCES[0]), TimeZone::COUNT);
+  for (uint8_t i = 0; i < TimeZone::COUNT; i++)
+  {
+    TEST_ASSERT_EQUAL_STRING(REFERENCES[i].name, (const char *)TimeZone::getName(i));
+  }
+  TEST_ASSERT_NULL(TimeZone::getName(TimeZone::COUNT));
+
+  TimeZone zone;
+  TEST_ASSERT_FALSE(zone.select(TimeZone::COUNT));
+  TEST_ASSERT_EQUAL_UINT8(0, zone.getSelected());
+}
+
+void test_offsets_2000_to_2099()
+{
+  TimeZone zone;
+  for (uint8_t i = 0; i < TimeZone::COUNT; i++)
+  {
+    TEST_ASSERT_TRUE(zone.select(i));
+    useReference(i);
+    for (EpochTime utc = Y2000; utc < Y2100; utc += 3 * 3600UL + 17)
+    {
+      int32_t expected = referenceOffset(utc);
+      TEST_ASSERT_EQUAL_UINT32(utc + expected, zone.toLocal(utc));
+      TEST_ASSERT_EQUAL_INT32(expected, zone.getOffset(utc));
+    }
+  }
+}
+
+void test_every_change_to_the_second()
+{
+  TimeZone zone;
+  for (uint8_t i = 0; i < TimeZone::COUNT; i++)
+  {
+    zone.select(i);
+    useReference(i);
+    uint16_t changes = 0;
+    EpochTime utc = Y2000;
+    while (true)
+    {
+      EpochTime change = zone.getNextChange(utc);
+      if (change == 0 || change >= Y2100)
+      {
+        break;
+      }
+      TEST_ASSERT_TRUE(change > utc);
+      TEST_ASSERT_EQUAL_INT32(referenceOffset(change - 1), zone.getOffset(change - 1));
+      TEST_ASSERT_EQUAL_INT32(referenceOffset(change), zone.getOffset(change));
+      TEST_ASSERT_TRUE(zone.getOffset(change - 1) != zone.getOffset(change));
+      TEST_ASSERT_TRUE(zone.isDst(change - 1) != zone.isDst(change));
+      utc = change;
+      changes++;
+    }
+    // Two a year with DST, none without
+    uint16_t expected = zone.getNextChange(Y2000) == 0 ? 0 : 200;
+    TEST_ASSERT_EQUAL_UINT16(expected, changes);
+  }
+}
+
+void test_jumps_in_any_order()
+{
+  // A clock set back or forward leaves the cached period
+  TimeZone zone;
+  zone.select(BERLIN);
+  useReference(BERLIN);
+  srand(42);
+  for (uint16_t i = 0; i < 20000; i++)
+  {
+    EpochTime utc = Y2000 + (EpochTime)(((uint64_t)rand() * 65536 + rand()) % (Y2100 - Y2000));
+    TEST_ASSERT_EQUAL_INT32(referenceOffset(utc), zone.getOffset(utc));
+  }
+}
+
+void test_local_to_utc()
+{
+  TimeZone zone;
+  for (uint8_t i = 0; i < TimeZone::COUNT; i++)
+  {
+    zone.select(i);
+    for (EpochTime utc = Y2000; utc < Y2100; utc += 5 * 3600UL + 31)
+    {
+      // Exact, except in the repeated hour where the second occurrence wins
+      EpochTime local = zone.toLocal(utc);
+      EpochTime back = zone.toUtc(local);
+      TEST_ASSERT_EQUAL_UINT32(local, zone.toLocal(back));
+      TEST_ASSERT_TRUE(back == utc || back == utc + 3600);
+    }
+  }
+}
+
+void test_berlin_gap_and_repeated_hour()
+{
+  TimeZone zone;
+  zone.select(BERLIN);
+  const EpochTime SPRING = 1711846800UL; // 2024-03-31 01:00 UTC, 02:00 CET
+  const EpochTime AUTUMN = 1729990800UL; // 2024-10-27 01:00 UTC, 03:00 CEST
+
+  TEST_ASSERT_EQUAL_UINT32(SPRING, zone.getNextChange(SPRING - 3600));
+  TEST_ASSERT_EQUAL_UINT32(AUTUMN, zone.getNextChange(SPRING));
+  TEST_ASSERT_FALSE(zone.isDst(SPRING - 1));
+  TEST_ASSERT_TRUE(zone.isDst(SPRING));
+
+  // 01:59:59 CET is followed by 03:00:00 CEST
+  TEST_ASSERT_EQUAL_UINT32(SPRING + 3600 - 1, zone.toLocal(SPRING - 1));
+  TEST_ASSERT_EQUAL_UINT32(SPRING + 7200, zone.toLocal(SPRING));
+
+  // 02:30 does not exist that night and is taken as 03:30 CEST
+  EpochTime gap = SPRING + 3600 + 1800;
+  TEST_ASSERT_EQUAL_UINT32(SPRING + 1800, zone.toUtc(gap));
+
+  // 02:30 happens twice in October; the CET one is chosen
+  EpochTime repeated = AUTUMN + 3600 + 1800;
+  TEST_ASSERT_EQUAL_UINT32(AUTUMN + 1800, zone.toUtc(repeated));
+  TEST_ASSERT_EQUAL_UINT32(repeated, zone.toLocal(AUTUMN - 1800));
+  TEST_ASSERT_EQUAL_UINT32(repeated, zone.toLocal(AUTUMN + 1800));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_zone_table_matches_references);
+  RUN_TEST(test_offsets_2000_to_2099);
+  RUN_TEST(test_every_change_to_the_second);
+  RUN_TEST(test_jumps_in_any_order);
+  RUN_TEST(test_local_to_utc);
+  RUN_TEST(test_berlin_gap_and_repeated_hour);
+  return UNITY_END();
+}
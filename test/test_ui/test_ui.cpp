@@ -0,0 +1,433 @@
+#include <unity.h>
+#include <string.h>
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "../FirmwareFixture.h"
+
+static const uint32_t MONDAY_0659 = 1704178740UL; // 2024-01-02 06:59:00
+
+static const char *const STATE_NAMES[UI_STATE_COUNT] = {
+    "DISPLAY", "SHOW_TIME", "SHOW_DATE", "SHOW_CLIMATE", "SHOW_ALARM", "SHOW_TIMER", "SETTINGS",
+    "SET_TIME", "SET_DATE", "SET_ALARM_1", "SET_ALARM_2", "SET_ALARM_3", "SET_ALARM_4", "SET_TIMER"};
+
+// The firmware with its UI, and the buttons pressed as their events
+struct UiFirmware : Firmware
+{
+  UiFirmware() : Firmware(PART_UI)
+  {
+  }
+
+  void button(uint8_t index, ButtonAction action)
+  {
+    ui.handleButton({BUTTON_PINS[index], action});
+  }
+
+  void click(uint8_t index)
+  {
+    button(index, BUTTON_DOWN);
+    button(index, BUTTON_SINGLE);
+  }
+
+  void longPress(uint8_t index)
+  {
+    button(index, BUTTON_DOWN);
+    button(index, BUTTON_LONG);
+    button(index, BUTTON_UP);
+  }
+
+  uint8_t activeTasks() const
+  {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < scheduler.getTaskCount(); i++)
+    {
+      count += scheduler.getTask(i) != nullptr;
+    }
+    return count;
+  }
+
+  bool shows(const char *text) const
+  {
+    const char digits[] = {display.digit1, display.digit2, display.digit3,
+                           display.digit4, display.digit5, display.digit6};
+    return memcmp(digits, text, 6) == 0;
+  }
+};
+
+// The transition a state takes for an event, looked up in the table the way
+// the UI should: the state's own row first, then its ancestors'. Returns
+// false when nothing handles the event.
+static bool lookup(uint8_t state, uint8_t event, UiTransition &found)
+{
+  for (uint8_t s = state; s != UI_NO_STATE; s = UserInterface::getParent(s))
+  {
+    for (uint8_t i = 0; i < UserInterface::getTransitionCount(); i++)
+    {
+      UiTransition row = UserInterface::getTransition(i);
+      if (row.state == s && row.event == event)
+      {
+        found = row;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Shortest event sequence from the initial state to each leaf
+static uint8_t pathLength[UI_STATE_COUNT];
+static uint8_t pathEvents[UI_STATE_COUNT][UI_STATE_COUNT];
+
+static void findPaths()
+{
+  memset(pathLength, 0xFF, sizeof(pathLength));
+  pathLength[UI_SHOW_TIME] = 0;
+  uint8_t queue[UI_STATE_COUNT];
+  uint8_t head = 0, tail = 0;
+  queue[tail++] = UI_SHOW_TIME;
+  while (head < tail)
+  {
+    uint8_t state = queue[head++];
+    for (uint8_t event = 0; event < UI_EVENT_COUNT; event++)
+    {
+      UiTransition row;
+      if (!lookup(state, event, row) || row.target == UI_NO_STATE || pathLength[row.target] != 0xFF)
+      {
+        continue;
+      }
+      memcpy(pathEvents[row.target], pathEvents[state], pathLength[state]);
+      pathEvents[row.target][pathLength[state]] = event;
+      pathLength[row.target] = pathLength[state] + 1;
+      queue[tail++] = row.target;
+    }
+  }
+}
+
+void setUp()
+{
+  halReset();
+  halSetRtc(MONDAY_0659);
+}
+
+void tearDown()
+{
+}
+
+void test_state_tree_is_well_formed()
+{
+  for (uint8_t state = 0; state < UI_STATE_COUNT; state++)
+  {
+    // Parents come first, so the tree has no cycles
+    uint8_t parent = UserInterface::getParent(state);
+    TEST_ASSERT_TRUE_MESSAGE(parent == UI_NO_STATE || parent < state, STATE_NAMES[state]);
+    if (parent != UI_NO_STATE)
+    {
+      TEST_ASSERT_FALSE_MESSAGE(UserInterface::isLeaf(parent), STATE_NAMES[state]);
+    }
+  }
+  TEST_ASSERT_FALSE(UserInterface::isLeaf(UI_DISPLAY));
+  TEST_ASSERT_FALSE(UserInterface::isLeaf(UI_SETTINGS));
+}
+
+void test_transition_rows_are_valid()
+{
+  uint8_t count = UserInterface::getTransitionCount();
+  TEST_ASSERT_GREATER_THAN_UINT8(0, count);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    UiTransition row = UserInterface::getTransition(i);
+    TEST_ASSERT_LESS_THAN_UINT8(UI_STATE_COUNT, row.state);
+    TEST_ASSERT_LESS_THAN_UINT8(UI_EVENT_COUNT, row.event);
+
+    // The machine only ever rests in a leaf
+    if (row.target == UI_NO_STATE)
+    {
+      TEST_ASSERT_NOT_NULL_MESSAGE(row.action, STATE_NAMES[row.state]);
+    }
+    else
+    {
+      TEST_ASSERT_LESS_THAN_UINT8(UI_STATE_COUNT, row.target);
+      TEST_ASSERT_TRUE_MESSAGE(UserInterface::isLeaf(row.target), STATE_NAMES[row.target]);
+    }
+
+    // One row per state and event, or the later one is dead
+    for (uint8_t j = i + 1; j < count; j++)
+    {
+      UiTransition other = UserInterface::getTransition(j);
+      TEST_ASSERT_FALSE_MESSAGE(other.state == row.state && other.event == row.event, STATE_NAMES[row.state]);
+    }
+  }
+}
+
+void test_every_leaf_is_reachable()
+{
+  findPaths();
+  for (uint8_t state = 0; state < UI_STATE_COUNT; state++)
+  {
+    if (UserInterface::isLeaf(state))
+    {
+      TEST_ASSERT_TRUE_MESSAGE(pathLength[state] != 0xFF, STATE_NAMES[state]);
+    }
+  }
+}
+
+void test_every_state_handles_every_event_by_the_table()
+{
+  // Every leaf, every event: the UI ends where the table says, and an
+  // unhandled event leaves it where it was
+  findPaths();
+  for (uint8_t state = 0; state < UI_STATE_COUNT; state++)
+  {
+    if (!UserInterface::isLeaf(state))
+    {
+      continue;
+    }
+    for (uint8_t event = 0; event < UI_EVENT_COUNT; event++)
+    {
+      halReset();
+      halSetRtc(MONDAY_0659);
+      UiFirmware fw;
+      for (uint8_t i = 0; i < pathLength[state]; i++)
+      {
+        fw.ui.dispatch(pathEvents[state][i]);
+      }
+      TEST_ASSERT_EQUAL_UINT8_MESSAGE(state, fw.ui.getState(), STATE_NAMES[state]);
+
+      UiTransition row;
+      uint8_t expected = state;
+      if (lookup(state, event, row) && row.target != UI_NO_STATE)
+      {
+        expected = row.target;
+      }
+
+      char message[40];
+      snprintf(message, sizeof(message), "%s on event %u", STATE_NAMES[state], event);
+      fw.ui.dispatch(event);
+      TEST_ASSERT_EQUAL_UINT8_MESSAGE(expected, fw.ui.getState(), message);
+      TEST_ASSERT_EQUAL_MESSAGE(UserInterface::getParent(expected) == UI_SETTINGS, fw.ui.isInSettings(), message);
+    }
+  }
+}
+
+void test_held_buttons_select_views()
+{
+  char text[DISPLAY_CHARS];
+  UiFirmware fw;
+  TEST_ASSERT_EQUAL_UINT8(UI_SHOW_TIME, fw.ui.getState());
+  TEST_ASSERT_TRUE(fw.shows("065900"));
+
+  fw.button(0, BUTTON_DOWN);
+  TEST_ASSERT_EQUAL_UINT8(UI_SHOW_DATE, fw.ui.getState());
+  TEST_ASSERT_TRUE(fw.shows(fw.clock.getDateString(text)));
+
+  // Releasing another button changes nothing
+  fw.button(1, BUTTON_UP);
+  TEST_ASSERT_EQUAL_UINT8(UI_SHOW_DATE, fw.ui.getState());
+
+  fw.button(0, BUTTON_SINGLE);
+  TEST_ASSERT_EQUAL_UINT8(UI_SHOW_TIME, fw.ui.getState());
+  TEST_ASSERT_TRUE(fw.shows("065900"));
+
+  fw.button(3, BUTTON_DOWN);
+  TEST_ASSERT_EQUAL_UINT8(UI_SHOW_TIMER, fw.ui.getState());
+  fw.button(3, BUTTON_UP);
+  TEST_ASSERT_EQUAL_UINT8(UI_SHOW_TIME, fw.ui.getState());
+}
+
+void test_display_changes_only_on_events()
+{
+  UiFirmware fw;
+
+  // Nothing due for half a second: the display is left alone
+  fw.display.digit1 = 'x';
+  fw.run(400);
+  TEST_ASSERT_EQUAL_INT8('x', fw.display.digit1);
+
+  // The second tick reprints it
+  fw.run(700);
+  TEST_ASSERT_TRUE(fw.shows("065901"));
+}
+
+void test_dot_blinks_in_time_view_only()
+{
+  UiFirmware fw;
+  fw.run(501);
+  TEST_ASSERT_TRUE(fw.display.dotState);
+
+  fw.button(0, BUTTON_DOWN);
+  TEST_ASSERT_FALSE(fw.display.dotState);
+  fw.run(1000);
+  TEST_ASSERT_FALSE(fw.display.dotState);
+}
+
+void test_settings_pages_blink_and_save_on_exit()
+{
+  char text[DISPLAY_CHARS];
+  char other[DISPLAY_CHARS];
+  UiFirmware fw;
+  uint8_t tasks = fw.activeTasks();
+
+  fw.longPress(0);
+  TEST_ASSERT_TRUE(fw.ui.isInSettings());
+  TEST_ASSERT_EQUAL_UINT8(UI_SET_TIME, fw.ui.getState());
+
+  // Each page starts blank and blinks in
+  TEST_ASSERT_TRUE(fw.shows("\x0c\x0c\x0c\x0c\x0c\x0c")); // Display::clear()
+  fw.run(51);
+  TEST_ASSERT_TRUE(fw.shows("065900"));
+
+  // Button 2 adjusts the first field of the page
+  fw.click(1);
+  TEST_ASSERT_TRUE(fw.shows("075900"));
+
+  // Button 1 walks every page and wraps
+  for (uint8_t page = 1; page <= SETTINGS_COUNT; page++)
+  {
+    fw.click(0);
+    TEST_ASSERT_EQUAL_UINT8(UI_SET_TIME + page % SETTINGS_COUNT, fw.ui.getState());
+  }
+
+  fw.click(0);
+  fw.click(0);
+  fw.click(1); // Alarm 1 hour
+  fw.longPress(0);
+  TEST_ASSERT_FALSE(fw.ui.isInSettings());
+  TEST_ASSERT_EQUAL_UINT8(UI_SHOW_TIME, fw.ui.getState());
+
+  // The blink task went with the settings, and the alarm was saved
+  TEST_ASSERT_EQUAL_UINT8(tasks, fw.activeTasks());
+
+  // A restart with the EEPROM as it was
+  UiFirmware restarted;
+  TEST_ASSERT_EQUAL_STRING_LEN(fw.clock.getAlarmTimeString(text, 0), restarted.clock.getAlarmTimeString(other, 0), 6);
+  TEST_ASSERT_EQUAL_STRING_LEN("0800", other, 4);
+}
+
+void test_settings_edits_apply_once_on_exit()
+{
+  char text[DISPLAY_CHARS];
+  UiFirmware fw;
+  fw.longPress(0);
+  fw.click(1); // 07:59
+  fw.click(1); // 08:59
+  fw.click(2); // 08:00
+  fw.run(2001);
+
+  // The RTC is untouched while editing, and the draft keeps running
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659 + 2, halGetRtc());
+  TEST_ASSERT_EQUAL_STRING_LEN("080002", fw.clock.getSettingString(text, SETTING_TIME), 6);
+
+  fw.longPress(0);
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659 - 6 * 3600L - 59 * 60 + 8 * 3600L + 2, halGetRtc());
+  TEST_ASSERT_TRUE(fw.shows("080002"));
+}
+
+void test_settings_date_follows_the_calendar()
+{
+  char text[DISPLAY_CHARS];
+  UiFirmware fw;
+  fw.clock.setDate({29, 2, 2024});
+  fw.longPress(0);
+  fw.click(0);
+  TEST_ASSERT_EQUAL_UINT8(UI_SET_DATE, fw.ui.getState());
+  TEST_ASSERT_EQUAL_STRING_LEN("290224", fw.clock.getSettingString(text, SETTING_DATE), 6);
+
+  // No 29 February in 2025, and the day wraps at the month's end
+  fw.click(3);
+  TEST_ASSERT_EQUAL_STRING_LEN("280225", fw.clock.getSettingString(text, SETTING_DATE), 6);
+  fw.click(1);
+  TEST_ASSERT_EQUAL_STRING_LEN("010225", fw.clock.getSettingString(text, SETTING_DATE), 6);
+
+  fw.longPress(0);
+  Date date = fw.clock.getDate();
+  TEST_ASSERT_EQUAL_UINT8(1, date.day);
+  TEST_ASSERT_EQUAL_UINT8(2, date.month);
+  TEST_ASSERT_EQUAL_UINT16(2025, date.year);
+  TEST_ASSERT_EQUAL_STRING_LEN("065900", fw.clock.getTimeString(text), 6);
+}
+
+void test_settings_timeout_discards_edits()
+{
+  char text[DISPLAY_CHARS];
+  UiFirmware fw;
+  fw.clock.setAlarmTime(0, 6, 30);
+  fw.longPress(0);
+  fw.click(0);
+  fw.click(0);
+  fw.click(1); // Alarm 1 hour, in the draft only
+  TEST_ASSERT_EQUAL_STRING_LEN("0730", fw.clock.getSettingString(text, SETTING_ALARM), 4);
+
+  // A press holds the timeout off
+  fw.run(20000);
+  fw.click(0);
+  fw.run(20000);
+  TEST_ASSERT_TRUE(fw.ui.isInSettings());
+
+  fw.run(10001);
+  TEST_ASSERT_FALSE(fw.ui.isInSettings());
+  TEST_ASSERT_EQUAL_STRING_LEN("0630", fw.clock.getAlarmTimeString(text, 0), 4);
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659 + 50, halGetRtc());
+}
+
+void test_failed_time_write_keeps_the_draft()
+{
+  char text[DISPLAY_CHARS];
+  UiFirmware fw;
+  fw.longPress(0);
+  fw.click(1); // 07:59
+  fw.click(0);
+  fw.click(0);
+  fw.click(1); // Alarm 1 hour
+
+  // The RTC write times out: back on the time page, the rest applied
+  halSetI2cHang(5);
+  fw.longPress(0);
+  TEST_ASSERT_EQUAL_UINT8(UI_SET_TIME, fw.ui.getState());
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659, halGetRtc());
+  TEST_ASSERT_EQUAL_STRING_LEN("0800", fw.clock.getAlarmTimeString(text, 0), 4);
+  fw.run(51);
+  TEST_ASSERT_TRUE(fw.shows("075900"));
+
+  // The bus was recovered by the failed write, so the retry goes through
+  fw.longPress(0);
+  TEST_ASSERT_EQUAL_UINT8(UI_SHOW_TIME, fw.ui.getState());
+  TEST_ASSERT_EQUAL_STRING_LEN("075900", fw.clock.getTimeString(text), 6);
+}
+
+void test_ringing_alarm_takes_clicks()
+{
+  UiFirmware fw;
+  fw.clock.setAlarmTime(0, 7, 0);
+  fw.clock.enableAlarm(0);
+  fw.run(60010);
+  TEST_ASSERT_EQUAL(ALARM_RINGING, fw.clock.getAlarmState());
+
+  // Snoozed by button 3, whose view closes on the release
+  fw.click(2);
+  TEST_ASSERT_EQUAL(ALARM_SNOOZED, fw.clock.getAlarmState());
+  TEST_ASSERT_EQUAL_UINT8(UI_SHOW_TIME, fw.ui.getState());
+
+  // Dismissed by button 1, in settings without turning the page
+  fw.longPress(0);
+  fw.click(0);
+  TEST_ASSERT_EQUAL(ALARM_ARMED, fw.clock.getAlarmState());
+  TEST_ASSERT_EQUAL_UINT8(UI_SET_TIME, fw.ui.getState());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_state_tree_is_well_formed);
+  RUN_TEST(test_transition_rows_are_valid);
+  RUN_TEST(test_every_leaf_is_reachable);
+  RUN_TEST(test_every_state_handles_every_event_by_the_table);
+  RUN_TEST(test_held_buttons_select_views);
+  RUN_TEST(test_display_changes_only_on_events);
+  RUN_TEST(test_dot_blinks_in_time_view_only);
+  RUN_TEST(test_settings_pages_blink_and_save_on_exit);
+  RUN_TEST(test_settings_edits_apply_once_on_exit);
+  RUN_TEST(test_settings_date_follows_the_calendar);
+  RUN_TEST(test_settings_timeout_discards_edits);
+  RUN_TEST(test_failed_time_write_keeps_the_draft);
+  RUN_TEST(test_ringing_alarm_takes_clicks);
+  return UNITY_END();
+}
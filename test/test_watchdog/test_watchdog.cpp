@@ -0,0 +1,128 @@
+#include <unity.h>
+#include <string.h>
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include "Watchdog.h"
+#include "../FirmwareFixture.h"
+
+static const uint32_t MONDAY_0659 = 1704178740UL; // 2024-01-02 06:59:00
+
+void setUp()
+{
+  halReset();
+  halSetRtc(MONDAY_0659);
+  Watchdog::begin(RESET_POWER_ON);
+}
+
+void tearDown()
+{
+}
+
+void test_stalled_stage_survives_the_reset()
+{
+  Watchdog::enter(STAGE_CLOCK);
+  Watchdog::onTimeout();
+
+  Watchdog::begin(RESET_WATCHDOG);
+  TEST_ASSERT_EQUAL_UINT8(STAGE_CLOCK, Watchdog::getStalledStage());
+  TEST_ASSERT_EQUAL_UINT8(RESET_WATCHDOG | STAGE_CLOCK << 4, Watchdog::getResetReport());
+
+  // Taken once: a second watchdog reset without a stall record is unknown
+  Watchdog::begin(RESET_WATCHDOG);
+  TEST_ASSERT_EQUAL_UINT8(WATCHDOG_UNKNOWN, Watchdog::getStalledStage());
+}
+
+void test_late_pass_is_only_counted()
+{
+  Watchdog::enter(STAGE_TASKS);
+  Watchdog::onTimeout();
+  Watchdog::feed();
+  Watchdog::feed();
+  TEST_ASSERT_EQUAL_UINT16(1, Watchdog::getLateCount());
+
+  // The reset never came, so neither does a later one blame this stall
+  Watchdog::begin(RESET_WATCHDOG);
+  TEST_ASSERT_EQUAL_UINT8(WATCHDOG_UNKNOWN, Watchdog::getStalledStage());
+}
+
+void test_power_on_ignores_a_stall_record()
+{
+  Watchdog::enter(STAGE_SERIAL);
+  Watchdog::onTimeout();
+  Watchdog::begin(RESET_POWER_ON | RESET_BROWN_OUT);
+  TEST_ASSERT_EQUAL_UINT8(RESET_POWER_ON | RESET_BROWN_OUT, Watchdog::getResetReport());
+}
+
+void test_reset_is_reported_and_logged()
+{
+  Watchdog::enter(STAGE_CLOCK);
+  Watchdog::onTimeout();
+  Watchdog::begin(RESET_WATCHDOG);
+  halSerialClear();
+  Firmware fw(PART_ACTIVITY_LOG);
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Restarted by the watchdog, stuck in clock"));
+
+  fw.command("log");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "02.01.2024 06:59:00 power up, watchdog, stuck in clock"));
+  fw.command("wdt");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Last reset: watchdog, stuck in clock"));
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "I2C bus recoveries: 0"));
+
+  // A plain power-up leaves the log line as it was
+  Watchdog::begin(RESET_POWER_ON);
+  Firmware again(PART_ACTIVITY_LOG);
+  again.command("log");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "power up\r\n"));
+  TEST_ASSERT_NULL(strstr(halSerialOutput(), "Restarted"));
+}
+
+void test_hung_bus_is_clocked_free()
+{
+  // Held at power-up: begin() clocks it free before Wire starts
+  halSetI2cHang(4);
+  RTClock rtc;
+  rtc.begin(A4, A5, SQW_PIN);
+  TEST_ASSERT_EQUAL_UINT8(0, halI2cHang());
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659, rtc.getUnixTime());
+
+  // Hung mid-run: the read times out, is dropped, and the bus recovered
+  halSetI2cHang(7);
+  halAdvanceMillis(1000);
+  TEST_ASSERT_FALSE(rtc.update());
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659, rtc.getUnixTime());
+  TEST_ASSERT_EQUAL_UINT16(1, rtc.getBusRecoveries());
+  TEST_ASSERT_EQUAL_UINT8(0, halI2cHang());
+
+  halAdvanceMillis(1000);
+  TEST_ASSERT_TRUE(rtc.update());
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659 + 2, rtc.getUnixTime());
+}
+
+void test_failed_time_write_is_reported()
+{
+  Firmware fw;
+  halSetI2cHang(5);
+  fw.command("time 143000");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "RTC write failed"));
+  TEST_ASSERT_NULL(strstr(halSerialOutput(), "Time set to"));
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659, halGetRtc());
+  TEST_ASSERT_EQUAL_UINT32(MONDAY_0659, fw.clock.getUnixTime());
+  TEST_ASSERT_EQUAL_UINT16(1, fw.clock.getBusRecoveries());
+
+  // Recovered by the failed write, so the retry goes through
+  fw.command("time 143000");
+  TEST_ASSERT_NOT_NULL(strstr(halSerialOutput(), "Time set to: 14:30:00"));
+  TEST_ASSERT_EQUAL_UINT32(14 * 3600UL + 30 * 60, halGetRtc() % 86400UL);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_stalled_stage_survives_the_reset);
+  RUN_TEST(test_late_pass_is_only_counted);
+  RUN_TEST(test_power_on_ignores_a_stall_record);
+  RUN_TEST(test_reset_is_reported_and_logged);
+  RUN_TEST(test_hung_bus_is_clocked_free);
+  RUN_TEST(test_failed_time_write_is_reported);
+  return UNITY_END();
+}
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Set the clock's RTC from this computer's clock over serial.
+
+    python3 tools/timesync.py --port /dev/ttyUSB0            # sync once
+    python3 tools/timesync.py --port /dev/ttyUSB0 --check    # measure only
+    python3 tools/timesync.py --port /dev/ttyUSB0 --interval 3600
+
+Each exchange sends "sync <t1>", with t1 the host time in us. The clock
+replies "SYNC <t1> <t2> <t3> <unix> <second>", where t2 and t3 are its
+micros() when the line was received and when the reply started, <unix> is
+the RTC's current UTC second and <second> the micros() when it began. With
+t4 the host time when the reply arrived, as in NTP:
+
+    offset = ((t1 - t2) + (t4 - t3)) / 2     host time = micros() + offset
+    delay  = (t4 - t1) - (t3 - t2)
+
+The offset is off by at most delay / 2, so the exchange with the least delay
+is kept. The script then sends "sync set <micros> <unix>" for the next whole
+second at least a second ahead, and the clock writes that second to the RTC
+at that micros() instant, restarting the DS1307's second divider.
+
+This computer's clock should be kept by NTP. Run it with --interval to
+stand in for a daemon; the RTC is only written when its error is over
+--threshold. Night mode loses the first byte sent; the script sends a
+newline first.
+"""
+
+import argparse
+import sys
+import time
+
+try:
+    import serial
+except ImportError:
+    serial = None
+
+EXCHANGES = 8
+
+
+def host_us():
+    return time.time_ns() // 1000
+
+
+def wire_us(line, baud):
+    # 10 bits a byte: the reply has taken this long to arrive once read
+    return len(line) * 10 * 1000000 // baud
+
+
+def exchange(port, baud):
+    t1 = host_us()
+    port.write(b"sync %d\n" % t1)
+    port.flush()
+    while True:
+        line = port.readline()
+        t4 = host_us()
+        if not line:
+            return None
+        fields = line.decode(errors="replace").split()
+        if len(fields) == 6 and fields[0] == "SYNC" and fields[1] == str(t1):
+            break
+    # t3 is when the reply started, t4 when all of it had arrived
+    t4 -= wire_us(line, baud)
+    t2, t3, unix, second = (int(f) for f in fields[2:])
+    # micros() may have wrapped in between; count back from t3
+    t2 = t3 - ((t3 - t2) & 0xFFFFFFFF)
+    second = t3 - ((t3 - second) & 0xFFFFFFFF)
+    offset = ((t1 - t2) + (t4 - t3)) // 2
+    delay = (t4 - t1) - (t3 - t2)
+    # Time the RTC shows less the host's time for the same instant
+    error = unix * 1000000 - (second + offset)
+    return {"offset": offset, "delay": delay, "error": error}
+
+
+def measure(port, baud, count=EXCHANGES):
+    best = None
+    for _ in range(count):
+        sample = exchange(port, baud)
+        if sample and (best is None or sample["delay"] < best["delay"]):
+            best = sample
+        time.sleep(0.1)
+    return best
+
+
+def apply(port, sample):
+    # micros() is 32 bits and wraps; the offset holds near the measurement
+    second = (host_us() + 1000000) // 1000000 + 1
+    at = (second * 1000000 - sample["offset"]) & 0xFFFFFFFF
+    port.write(b"sync set %d %d\n" % (at, second))
+    port.flush()
+    reply = port.readline().decode(errors="replace").strip()
+    if not reply.startswith("SYNC SET"):
+        raise RuntimeError("clock refused the sync: %r" % reply)
+    # Past the instant and the next edge
+    time.sleep(max(0.0, second - host_us() / 1e6) + 1.2)
+
+
+def report(label, sample):
+    print("%-7s RTC error %+9.3f ms  (delay %.3f ms, so +/- %.3f ms)" % (
+        label, sample["error"] / 1000.0, sample["delay"] / 1000.0, sample["delay"] / 2000.0))
+
+
+def sync(port, baud, threshold_us, check):
+    before = measure(port, baud)
+    if before is None:
+        sys.stderr.write("no reply to 'sync'\n")
+        return 1
+    report("before", before)
+    if check or abs(before["error"]) <= threshold_us:
+        return 0
+    apply(port, before)
+    after = measure(port, baud)
+    if after is None:
+        sys.stderr.write("no reply after the sync\n")
+        return 1
+    report("after", after)
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", required=True)
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--check", action="store_true", help="measure the RTC error, do not set it")
+    parser.add_argument("--threshold", type=float, default=2.0, help="ms of error left alone (default 2)")
+    parser.add_argument("--interval", type=float, help="keep running, syncing every this many seconds")
+    args = parser.parse_args()
+
+    if serial is None:
+        sys.stderr.write("needs pyserial (pip install pyserial)\n")
+        return 1
+
+    with serial.Serial(args.port, args.baud, timeout=1) as port:
+        # Opening the port resets most Nanos; wait for the banner, wake it
+        time.sleep(2.0)
+        port.write(b"\n")
+        port.flush()
+        time.sleep(0.1)
+        port.reset_input_buffer()
+
+        while True:
+            result = sync(port, args.baud, args.threshold * 1000, args.check)
+            if args.interval is None:
+                return result
+            time.sleep(args.interval)
+
+
+if __name__ == "__main__":
+    sys.exit(main())